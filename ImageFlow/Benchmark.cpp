@@ -0,0 +1,298 @@
+#include "Benchmark.h"
+//--------------------------
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+//--------------------------
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+//--------------------------
+#include "FastPathEngine.h"
+#include "FilterGraphPool.h"
+#include "ImageEncoder.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+/* 单个编码预设的结果 */
+struct EncodeResult
+{
+    EncodePreset preset;
+    double encodeMs = 0.0; // 单次编码耗时
+    size_t bytes = 0;      // 输出体积
+};
+
+/* 误差统计 */
+struct ErrorStats
+{
+    double psnr = 0.0; // 峰值信噪比（dB）
+    int maxDiff = 0;   // 最大绝对误差
+};
+
+// 生成带渐变与噪声的合成图像  内容接近照片以免缩放核被特殊值"优待"
+AVFrame *makeSyntheticFrame(AVPixelFormat fmt, int width, int height)
+{
+    auto frame = av_frame_alloc();
+    if (!frame)
+        return nullptr;
+    frame->format = fmt;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0)
+    {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    uint32_t seed = 12345;
+    auto desc = av_pix_fmt_desc_get(fmt);
+    for (int plane = 0; plane < 4 && frame->data[plane]; ++plane)
+    {
+        bool isChroma = (plane == 1 || plane == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        int rows = isChroma ? AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height;
+        int bytes = av_image_get_linesize(fmt, width, plane);
+        for (int y = 0; y < rows; ++y)
+        {
+            uint8_t *row = frame->data[plane] + static_cast<ptrdiff_t>(y) * frame->linesize[plane];
+            for (int x = 0; x < bytes; ++x)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                int value = (x * 7 + y * 3 + plane * 50) % 256 + static_cast<int>(seed >> 28) - 8;
+                row[x] = static_cast<uint8_t>(std::clamp(value, 0, 255));
+            }
+        }
+    }
+    return frame;
+}
+
+// 转换为指定像素格式  用于对齐两条路径的输出格式
+AVFrame *convertFrame(AVFrame const *src, AVPixelFormat fmt)
+{
+    auto dst = av_frame_alloc();
+    dst->format = fmt;
+    dst->width = src->width;
+    dst->height = src->height;
+    if (av_frame_get_buffer(dst, 0) < 0)
+    {
+        av_frame_free(&dst);
+        return nullptr;
+    }
+    auto ctx = sws_getContext(
+        src->width, src->height, static_cast<AVPixelFormat>(src->format),
+        dst->width, dst->height, fmt,
+        SWS_BICUBIC | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT, nullptr, nullptr, nullptr);
+    if (!ctx)
+    {
+        av_frame_free(&dst);
+        return nullptr;
+    }
+    sws_scale(ctx, src->data, src->linesize, 0, src->height, dst->data, dst->linesize);
+    sws_freeContext(ctx);
+    return dst;
+}
+
+ErrorStats compareFrames(AVFrame const *a, AVFrame const *b)
+{
+    ErrorStats stats;
+    auto fmt = static_cast<AVPixelFormat>(a->format);
+    auto desc = av_pix_fmt_desc_get(fmt);
+    double sumSq = 0.0;
+    int64_t count = 0;
+    for (int plane = 0; plane < 4 && a->data[plane]; ++plane)
+    {
+        bool isChroma = (plane == 1 || plane == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        int rows = isChroma ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h) : a->height;
+        int bytes = av_image_get_linesize(fmt, a->width, plane);
+        for (int y = 0; y < rows; ++y)
+        {
+            uint8_t const *ra = a->data[plane] + static_cast<ptrdiff_t>(y) * a->linesize[plane];
+            uint8_t const *rb = b->data[plane] + static_cast<ptrdiff_t>(y) * b->linesize[plane];
+            for (int x = 0; x < bytes; ++x)
+            {
+                int diff = std::abs(ra[x] - rb[x]);
+                stats.maxDiff = std::max(stats.maxDiff, diff);
+                sumSq += static_cast<double>(diff) * diff;
+            }
+            count += bytes;
+        }
+    }
+    double mse = count ? sumSq / count : 0.0;
+    stats.psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+    return stats;
+}
+
+template <typename Func>
+double measureMs(int iterations, Func &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int Benchmark::runFastPath(std::string const &filterDesc, int iterations)
+{
+    FastPathPlan plan;
+    if (!FastPathEngine::parse(filterDesc, plan))
+    {
+        std::cerr << "快速路径无法识别滤镜描述：" << filterDesc << std::endl;
+        return 1;
+    }
+    iterations = std::max(iterations, 1);
+
+    struct Size
+    {
+        int width;
+        int height;
+    };
+    Size const sizes[] = {{1920, 1080}, {4000, 3000}};
+    AVPixelFormat const formats[] = {AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA};
+    const char *const levels[] = {"scalar", "sse4.1", "avx2"};
+
+    FilterGraphPool pool;
+    FilterGraphOptions graphOptions;
+    graphOptions.threadCount = 1; // 与单线程的原生内核对比
+    graphOptions.allowFastPath = false;
+
+    std::cout << "=== 快速路径基准 ===" << std::endl;
+    std::cout << "  滤镜：" << filterDesc << "  迭代：" << iterations
+              << "  自动选择内核：" << FastPathEngine::kernelLevel() << std::endl;
+
+    for (auto &&size : sizes)
+    {
+        for (auto fmt : formats)
+        {
+            auto input = makeSyntheticFrame(fmt, size.width, size.height);
+            if (!input)
+                continue;
+            double megaPixels = size.width * static_cast<double>(size.height) / 1e6;
+
+            // libavfilter参考输出  预热一次以排除滤镜图构建时间
+            AVFrame *reference = nullptr;
+            if (pool.processFrame(input, filterDesc, &reference, graphOptions) < 0 || !reference)
+            {
+                std::cerr << "libavfilter处理失败" << std::endl;
+                av_frame_free(&input);
+                continue;
+            }
+            auto runGraph = [&]
+            {
+                AVFrame *out = nullptr;
+                pool.processFrame(input, filterDesc, &out, graphOptions);
+                av_frame_free(&out);
+            };
+            double graphMs = measureMs(iterations, runGraph);
+
+            std::cout << "  " << size.width << "x" << size.height
+                      << " " << av_get_pix_fmt_name(fmt) << std::endl;
+            std::printf("    %-10s %8.2f ms  %8.1f MP/s\n", "libavfilter", graphMs, megaPixels / graphMs * 1000.0);
+
+            for (auto level : levels)
+            {
+                if (!FastPathEngine::setKernelLevel(level))
+                    continue;
+
+                AVFrame *output = nullptr;
+                if (FastPathEngine::process(input, plan, &output) < 0 || !output)
+                    continue;
+                auto runFastPath = [&]
+                {
+                    AVFrame *out = nullptr;
+                    FastPathEngine::process(input, plan, &out);
+                    av_frame_free(&out);
+                };
+                double fastMs = measureMs(iterations, runFastPath);
+
+                // 两条路径的输出格式可能不同（hue在libavfilter中会把RGB转为YUV）
+                AVFrame *aligned = reference->format == output->format
+                                       ? av_frame_clone(reference)
+                                       : convertFrame(reference, static_cast<AVPixelFormat>(output->format));
+                ErrorStats stats = aligned ? compareFrames(output, aligned) : ErrorStats{};
+                std::printf("    %-10s %8.2f ms  %8.1f MP/s  x%.2f  PSNR %.2f dB  最大误差 %d\n",
+                            level, fastMs, megaPixels / fastMs * 1000.0, graphMs / fastMs,
+                            stats.psnr, stats.maxDiff);
+                av_frame_free(&aligned);
+                av_frame_free(&output);
+            }
+            FastPathEngine::setKernelLevel("auto");
+
+            av_frame_free(&reference);
+            av_frame_free(&input);
+        }
+    }
+    std::cout << "=================================" << std::endl;
+    return 0;
+}
+
+int Benchmark::runEncode(int width, int height, int iterations)
+{
+    iterations = std::max(iterations, 1);
+
+    // 不透明照片与带透明通道的图像  后者用于对比PNG的RGB/RGBA输出
+    AVPixelFormat const sources[] = {AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA};
+    const char *const formats[] = {"jpg", "png", "webp"};
+    EncodePreset const presets[] = {EncodePreset::FASTEST, EncodePreset::BALANCED, EncodePreset::SMALLEST};
+
+    std::cout << "=== 编码预设基准 ===" << std::endl;
+    std::cout << "  尺寸：" << width << "x" << height << "  迭代：" << iterations << std::endl;
+
+    for (auto fmt : sources)
+    {
+        auto input = makeSyntheticFrame(fmt, width, height);
+        if (!input)
+            continue;
+
+        for (auto format : formats)
+        {
+            std::cout << "  " << av_get_pix_fmt_name(fmt) << " -> " << format << std::endl;
+            // 全部预设运行后再输出  体积比以均衡预设为基准
+            std::vector<EncodeResult> results;
+            size_t balancedBytes = 0;
+            for (auto preset : presets)
+            {
+                auto options = ImageEncoder::fromPreset(preset);
+                std::vector<uint8_t> output;
+                if (ImageEncoder::encode(input, format, options, 1, output) < 0)
+                {
+                    std::cerr << "    编码失败：" << ImageEncoder::presetName(preset) << std::endl;
+                    continue;
+                }
+                auto runEncoder = [&]
+                {
+                    std::vector<uint8_t> buffer;
+                    ImageEncoder::encode(input, format, options, 1, buffer);
+                };
+                results.push_back({preset, measureMs(iterations, runEncoder), output.size()});
+                if (preset == EncodePreset::BALANCED)
+                    balancedBytes = output.size();
+            }
+
+            for (auto &&result : results)
+            {
+                std::printf("    %-10s %8.2f ms  %10zu 字节",
+                            ImageEncoder::presetName(result.preset), result.encodeMs, result.bytes);
+                if (balancedBytes)
+                    std::printf("  体积比 %.3f", static_cast<double>(result.bytes) / balancedBytes);
+                std::printf("\n");
+            }
+        }
+        av_frame_free(&input);
+    }
+    std::cout << "=================================" << std::endl;
+    return 0;
+}
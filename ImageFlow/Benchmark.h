@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ImageFlow
+{
+namespace Benchmark
+{
+
+// 原生快速路径与libavfilter滤镜图的吞吐量、输出误差对比
+// 使用合成图像 覆盖各像素格式与可用的内核级别
+int runFastPath(std::string const &filterDesc, int iterations);
+
+// 各编码预设在不同输出格式下的编码耗时与输出体积
+int runEncode(int width, int height, int iterations);
+
+// 线程池微基准  生产者与工作线程数各取1、2、4……直到maxThreads
+// 空任务提交吞吐量、提交到开始的延迟、waitAll唤醒延迟、过载时的三种拒绝策略、优先级抢占与反转
+// 结果写成JSON  字段固定  可在不同提交之间比较
+int runThreadPool(size_t maxThreads, size_t tasks, std::string const &outputPath);
+
+} // namespace Benchmark
+} // namespace ImageFlow
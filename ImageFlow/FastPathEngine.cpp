@@ -0,0 +1,561 @@
+#include "FastPathEngine.h"
+//--------------------------
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <vector>
+//--------------------------
+extern "C"
+{
+#include <libavutil/error.h>
+#include <libavutil/frame.h>
+}
+//--------------------------
+#include "FastPathKernels.h"
+#include "Utils.h"
+
+using namespace ImageFlow;
+using namespace ImageFlow::FastPath;
+
+namespace
+{
+
+//----------------------------------------------------------------
+// 内核选择
+
+Kernels const *detectKernels()
+{
+    if (cpuHasAvx2() && avx2Kernels())
+        return avx2Kernels();
+    if (cpuHasSse41() && sse41Kernels())
+        return sse41Kernels();
+    return &scalarKernels();
+}
+
+std::atomic<Kernels const *> &activeKernels()
+{
+    static std::atomic<Kernels const *> kernels{detectKernels()};
+    return kernels;
+}
+
+//----------------------------------------------------------------
+// 滤镜描述解析
+
+std::vector<std::string_view> split(std::string_view s, char sep)
+{
+    std::vector<std::string_view> parts;
+    size_t pos = 0;
+    while (true)
+    {
+        size_t end = s.find(sep, pos);
+        parts.push_back(Utils::trim(s.substr(pos, end == std::string_view::npos ? end : end - pos)));
+        if (end == std::string_view::npos)
+            break;
+        pos = end + 1;
+    }
+    return parts;
+}
+
+// 只接受纯数字  表达式（如iw/2、t*10）交给libavfilter
+bool parseNumber(std::string_view s, double &value)
+{
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && ptr == s.data() + s.size();
+}
+
+bool parseSize(std::string_view s, int &value)
+{
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && ptr == s.data() + s.size() && value > 0;
+}
+
+bool parseScale(std::string_view args, FastPathPlan &plan)
+{
+    int positional = 0;
+    for (auto arg : split(args, ':'))
+    {
+        auto eq = arg.find('=');
+        auto key = eq == std::string_view::npos ? std::string_view{} : arg.substr(0, eq);
+        auto value = eq == std::string_view::npos ? arg : arg.substr(eq + 1);
+
+        if (key.empty())
+        {
+            // scale的位置参数依次为 w、h
+            if (positional > 1 || !parseSize(value, positional == 0 ? plan.width : plan.height))
+                return false;
+            ++positional;
+        }
+        else if (key == "w" || key == "width")
+        {
+            if (!parseSize(value, plan.width))
+                return false;
+        }
+        else if (key == "h" || key == "height")
+        {
+            if (!parseSize(value, plan.height))
+                return false;
+        }
+        else if (key == "flags")
+        {
+            if (value == "bilinear")
+                plan.kernel = ResizeKernel::BILINEAR;
+            else if (value == "bicubic")
+                plan.kernel = ResizeKernel::BICUBIC;
+            else if (value == "lanczos")
+                plan.kernel = ResizeKernel::LANCZOS;
+            else
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    plan.hasScale = plan.width > 0 && plan.height > 0;
+    return plan.hasScale;
+}
+
+bool parseHue(std::string_view args, FastPathPlan &plan)
+{
+    int positional = 0;
+    for (auto arg : split(args, ':'))
+    {
+        auto eq = arg.find('=');
+        auto key = eq == std::string_view::npos ? std::string_view{} : arg.substr(0, eq);
+        auto value = eq == std::string_view::npos ? arg : arg.substr(eq + 1);
+
+        // hue的位置参数依次为 h、s
+        if (key.empty())
+        {
+            if (positional > 1)
+                return false;
+            key = positional++ == 0 ? "h" : "s";
+        }
+
+        double number = 0.0;
+        if (!parseNumber(value, number))
+            return false;
+
+        if (key == "h")
+            plan.hueDegrees = number;
+        else if (key == "H")
+            plan.hueDegrees = number * 180.0 / std::numbers::pi;
+        else if (key == "s")
+            plan.saturation = std::clamp(number, -10.0, 10.0);
+        else if (key == "b" && number == 0.0)
+            continue;
+        else
+            return false;
+    }
+    plan.hasHue = true;
+    return true;
+}
+
+//----------------------------------------------------------------
+// 缩放系数
+
+double kernelRadius(ResizeKernel kernel)
+{
+    switch (kernel)
+    {
+    case ResizeKernel::BILINEAR:
+        return 1.0;
+    case ResizeKernel::LANCZOS:
+        return 3.0;
+    default:
+        return 2.0;
+    }
+}
+
+double kernelWeight(ResizeKernel kernel, double x)
+{
+    x = std::fabs(x);
+    switch (kernel)
+    {
+    case ResizeKernel::BILINEAR:
+        return std::max(0.0, 1.0 - x);
+    case ResizeKernel::LANCZOS:
+    {
+        if (x < 1e-8)
+            return 1.0;
+        if (x >= 3.0)
+            return 0.0;
+        double px = std::numbers::pi * x;
+        return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+    }
+    default:
+    {
+        // libswscale默认bicubic参数 B=0 C=0.6
+        constexpr double a = -0.6;
+        if (x < 1.0)
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        if (x < 2.0)
+            return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+        return 0.0;
+    }
+    }
+}
+
+/* 一维缩放滤波器 */
+struct ResizeFilter
+{
+    int taps = 0;               // 每个输出位置的抽头数（已对齐）
+    std::vector<int> starts;    // 每个输出位置的起始源坐标
+    std::vector<int16_t> coefs; // taps * 输出长度个定点系数
+};
+
+bool buildFilter(int srcSize, int dstSize, ResizeKernel kernel, ResizeFilter &filter)
+{
+    double scale = static_cast<double>(srcSize) / dstSize;
+    double stretch = std::max(scale, 1.0);
+    double support = kernelRadius(kernel) * stretch;
+    int rawTaps = static_cast<int>(std::ceil(support * 2.0)) + 1;
+    int taps = (rawTaps + kTapAlign - 1) / kTapAlign * kTapAlign;
+
+    // 窗口必须完整落在源图内  SIMD内核不做边界检查
+    if (taps > kMaxTaps || taps > srcSize)
+        return false;
+
+    filter.taps = taps;
+    filter.starts.resize(dstSize);
+    filter.coefs.assign(static_cast<size_t>(dstSize) * taps, 0);
+
+    std::vector<double> weights(taps);
+    for (int i = 0; i < dstSize; ++i)
+    {
+        double center = (i + 0.5) * scale - 0.5;
+        int left = static_cast<int>(std::floor(center - support)) + 1;
+        int start = std::clamp(left, 0, srcSize - taps);
+        filter.starts[i] = start;
+
+        // 超出边界的抽头并入边缘像素
+        std::fill(weights.begin(), weights.end(), 0.0);
+        double sum = 0.0;
+        for (int j = left; j < left + rawTaps; ++j)
+        {
+            double w = kernelWeight(kernel, (j - center) / stretch);
+            weights[std::clamp(j, 0, srcSize - 1) - start] += w;
+            sum += w;
+        }
+
+        // 定点化  舍入误差记到权重最大的抽头上
+        int16_t *coefs = filter.coefs.data() + static_cast<size_t>(i) * taps;
+        int total = 0;
+        int largest = 0;
+        for (int k = 0; k < taps; ++k)
+        {
+            coefs[k] = static_cast<int16_t>(std::lrint(weights[k] / sum * (1 << kCoefBits)));
+            total += coefs[k];
+            if (std::fabs(weights[k]) > std::fabs(weights[largest]))
+                largest = k;
+        }
+        coefs[largest] = static_cast<int16_t>(coefs[largest] + (1 << kCoefBits) - total);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------
+// 逐行缩放
+
+/* 平面引用 */
+struct PlaneRef
+{
+    uint8_t *data;
+    int linesize;
+};
+
+/**
+ * @brief 缩放一组尺寸相同的平面（如YUV420的U与V）  每输出一行后调用rowHook
+ * @brief 水平结果保存在taps行的环形缓冲中  源行只做一次水平缩放
+ */
+template <typename RowHook>
+void resizePlanes(
+    Kernels const &kernels,
+    PlaneRef const *src, PlaneRef const *dst, int planeCount,
+    int dstWidth, int dstHeight, int channels,
+    ResizeFilter const &hFilter, ResizeFilter const &vFilter,
+    RowHook &&rowHook)
+{
+    int taps = vFilter.taps;
+    size_t rowElems = static_cast<size_t>(dstWidth) * channels;
+    std::vector<int16_t> ring(static_cast<size_t>(planeCount) * taps * rowElems);
+    std::vector<int16_t const *> rows(taps);
+
+    auto ringRow = [&](int plane, int srcRow)
+    {
+        return ring.data() + (static_cast<size_t>(plane) * taps + srcRow % taps) * rowElems;
+    };
+
+    int next = 0; // 下一个待水平缩放的源行
+    for (int y = 0; y < dstHeight; ++y)
+    {
+        int start = vFilter.starts[y];
+        next = std::max(next, start);
+        for (; next < start + taps; ++next)
+        {
+            for (int p = 0; p < planeCount; ++p)
+            {
+                kernels.horizontal(
+                    src[p].data + static_cast<ptrdiff_t>(next) * src[p].linesize,
+                    ringRow(p, next), dstWidth, channels,
+                    hFilter.starts.data(), hFilter.coefs.data(), hFilter.taps);
+            }
+        }
+
+        for (int p = 0; p < planeCount; ++p)
+        {
+            for (int k = 0; k < taps; ++k)
+                rows[k] = ringRow(p, start + k);
+            kernels.vertical(
+                rows.data(), vFilter.coefs.data() + static_cast<size_t>(y) * taps, taps,
+                dst[p].data + static_cast<ptrdiff_t>(y) * dst[p].linesize,
+                static_cast<int>(rowElems));
+        }
+        rowHook(y);
+    }
+}
+
+//----------------------------------------------------------------
+// 色相
+
+/* 色相旋转系数 */
+struct HueParams
+{
+    int cosS;   // kHueBits 定点  已乘以饱和度
+    int sinS;   // kHueBits 定点  已乘以饱和度
+    int rgb[9]; // RGB空间等效矩阵  kCoefBits 定点
+};
+
+HueParams makeHueParams(FastPathPlan const &plan)
+{
+    HueParams params{};
+    double h = plan.hueDegrees * std::numbers::pi / 180.0;
+    double c = std::cos(h) * plan.saturation;
+    double s = std::sin(h) * plan.saturation;
+    params.cosS = static_cast<int>(std::lrint(c * (1 << kHueBits)));
+    params.sinS = static_cast<int>(std::lrint(s * (1 << kHueBits)));
+
+    // hue只作用于YUV色度  RGB输入等效为 RGB->YUV  旋转UV  YUV->RGB（BT.601）
+    double const toYuv[3][3] = {
+        {0.299, 0.587, 0.114},
+        {-0.168736, -0.331264, 0.5},
+        {0.5, -0.418688, -0.081312}};
+    double const toRgb[3][3] = {
+        {1.0, 0.0, 1.402},
+        {1.0, -0.344136, -0.714136},
+        {1.0, 1.772, 0.0}};
+    double const rotate[3][3] = {
+        {1.0, 0.0, 0.0},
+        {0.0, c, -s},
+        {0.0, s, c}};
+
+    double tmp[3][3] = {};
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            for (int k = 0; k < 3; ++k)
+                tmp[i][j] += rotate[i][k] * toYuv[k][j];
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            double m = 0.0;
+            for (int k = 0; k < 3; ++k)
+                m += toRgb[i][k] * tmp[k][j];
+            params.rgb[i * 3 + j] = static_cast<int>(std::lrint(m * (1 << kCoefBits)));
+        }
+    }
+    return params;
+}
+
+void hueRgbRow(uint8_t *row, int width, int channels, HueParams const &params)
+{
+    constexpr int round = 1 << (kCoefBits - 1);
+    int const *m = params.rgb;
+    for (int x = 0; x < width; ++x, row += channels)
+    {
+        int r = row[0], g = row[1], b = row[2];
+        row[0] = static_cast<uint8_t>(std::clamp((m[0] * r + m[1] * g + m[2] * b + round) >> kCoefBits, 0, 255));
+        row[1] = static_cast<uint8_t>(std::clamp((m[3] * r + m[4] * g + m[5] * b + round) >> kCoefBits, 0, 255));
+        row[2] = static_cast<uint8_t>(std::clamp((m[6] * r + m[7] * g + m[8] * b + round) >> kCoefBits, 0, 255));
+    }
+}
+
+bool isYuv420(AVPixelFormat fmt)
+{
+    return fmt == AV_PIX_FMT_YUV420P || fmt == AV_PIX_FMT_YUVJ420P;
+}
+
+int channelCount(AVPixelFormat fmt)
+{
+    return fmt == AV_PIX_FMT_RGB24 ? 3 : fmt == AV_PIX_FMT_RGBA ? 4 : 1;
+}
+
+} // namespace
+
+//----------------------------------------------------------------
+
+bool FastPathEngine::parse(std::string const &filterDesc, FastPathPlan &plan)
+{
+    plan = FastPathPlan{};
+    if (filterDesc.empty() || filterDesc.find_first_of("[];'\\") != std::string::npos)
+        return false;
+
+    auto items = split(filterDesc, ',');
+    if (items.size() > 2)
+        return false;
+
+    for (auto item : items)
+    {
+        auto eq = item.find('=');
+        auto name = Utils::trim(item.substr(0, eq));
+        auto args = eq == std::string_view::npos ? std::string_view{} : item.substr(eq + 1);
+
+        // scale与hue均为线性逐像素/可分离运算  先后顺序只影响中间截断  统一在缩放后融合色相
+        if (name == "scale" && !plan.hasScale)
+        {
+            if (!parseScale(args, plan))
+                return false;
+        }
+        else if (name == "hue" && !plan.hasHue)
+        {
+            if (!parseHue(args, plan))
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return plan.hasScale || plan.hasHue;
+}
+
+bool FastPathEngine::supportsFormat(AVPixelFormat fmt)
+{
+    return isYuv420(fmt) || fmt == AV_PIX_FMT_RGB24 || fmt == AV_PIX_FMT_RGBA;
+}
+
+int FastPathEngine::process(
+    AVFrame const *inputFrame,
+    FastPathPlan const &plan,
+    AVFrame **outputFrame)
+{
+    if (!inputFrame || !outputFrame)
+        return AVERROR(EINVAL);
+
+    auto fmt = static_cast<AVPixelFormat>(inputFrame->format);
+    if (!supportsFormat(fmt))
+        return AVERROR(ENOSYS);
+
+    int srcW = inputFrame->width;
+    int srcH = inputFrame->height;
+    int dstW = plan.hasScale ? plan.width : srcW;
+    int dstH = plan.hasScale ? plan.height : srcH;
+    bool yuv = isYuv420(fmt);
+    int channels = channelCount(fmt);
+
+    // 先建好滤波器  无法处理的尺寸返回ENOSYS由调用方回退
+    ResizeFilter lumaH, lumaV, chromaH, chromaV;
+    if (plan.hasScale)
+    {
+        if (!buildFilter(srcW, dstW, plan.kernel, lumaH) ||
+            !buildFilter(srcH, dstH, plan.kernel, lumaV))
+            return AVERROR(ENOSYS);
+        if (yuv &&
+            (!buildFilter((srcW + 1) >> 1, (dstW + 1) >> 1, plan.kernel, chromaH) ||
+             !buildFilter((srcH + 1) >> 1, (dstH + 1) >> 1, plan.kernel, chromaV)))
+            return AVERROR(ENOSYS);
+    }
+
+    auto output = av_frame_alloc();
+    if (!output)
+        return AVERROR(ENOMEM);
+    output->format = fmt;
+    output->width = dstW;
+    output->height = dstH;
+    if (av_frame_get_buffer(output, 0) < 0)
+    {
+        av_frame_free(&output);
+        return AVERROR(ENOMEM);
+    }
+    av_frame_copy_props(output, inputFrame);
+
+    auto const &kernels = *activeKernels().load();
+    HueParams hue = plan.hasHue ? makeHueParams(plan) : HueParams{};
+    int chromaW = (dstW + 1) >> 1;
+
+    auto hueChromaRow = [&](int y)
+    {
+        if (plan.hasHue)
+            kernels.hueChroma(output->data[1] + static_cast<ptrdiff_t>(y) * output->linesize[1],
+                              output->data[2] + static_cast<ptrdiff_t>(y) * output->linesize[2],
+                              chromaW, hue.cosS, hue.sinS);
+    };
+    auto hueRgb = [&](int y)
+    {
+        if (plan.hasHue)
+            hueRgbRow(output->data[0] + static_cast<ptrdiff_t>(y) * output->linesize[0], dstW, channels, hue);
+    };
+
+    if (!plan.hasScale)
+    { // 仅调整色相
+        if (av_frame_copy(output, inputFrame) < 0)
+        {
+            av_frame_free(&output);
+            return AVERROR(EINVAL);
+        }
+        int rows = yuv ? (dstH + 1) >> 1 : dstH;
+        for (int y = 0; y < rows; ++y)
+            yuv ? hueChromaRow(y) : hueRgb(y);
+    }
+    else if (yuv)
+    {
+        PlaneRef srcY{inputFrame->data[0], inputFrame->linesize[0]};
+        PlaneRef dstY{output->data[0], output->linesize[0]};
+        resizePlanes(kernels, &srcY, &dstY, 1, dstW, dstH, 1, lumaH, lumaV, [](int) {});
+
+        // U与V同步逐行缩放  每行输出后立即旋转色相
+        PlaneRef srcUV[2] = {{inputFrame->data[1], inputFrame->linesize[1]},
+                             {inputFrame->data[2], inputFrame->linesize[2]}};
+        PlaneRef dstUV[2] = {{output->data[1], output->linesize[1]},
+                             {output->data[2], output->linesize[2]}};
+        resizePlanes(kernels, srcUV, dstUV, 2, chromaW, (dstH + 1) >> 1, 1, chromaH, chromaV, hueChromaRow);
+    }
+    else
+    {
+        PlaneRef src{inputFrame->data[0], inputFrame->linesize[0]};
+        PlaneRef dst{output->data[0], output->linesize[0]};
+        resizePlanes(kernels, &src, &dst, 1, dstW, dstH, channels, lumaH, lumaV, hueRgb);
+    }
+
+    *outputFrame = output;
+    return 0;
+}
+
+const char *FastPathEngine::kernelLevel()
+{
+    return activeKernels().load()->name;
+}
+
+bool FastPathEngine::setKernelLevel(std::string const &level)
+{
+    Kernels const *kernels = nullptr;
+    if (level == "scalar")
+        kernels = &scalarKernels();
+    else if (level == "sse4.1" && cpuHasSse41())
+        kernels = sse41Kernels();
+    else if (level == "avx2" && cpuHasAvx2())
+        kernels = avx2Kernels();
+    else if (level == "auto")
+        kernels = detectKernels();
+
+    if (!kernels)
+        return false;
+    activeKernels().store(kernels);
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+//--------------------------
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace ImageFlow
+{
+
+/* 缩放插值核 */
+enum class ResizeKernel
+{
+    BILINEAR,
+    BICUBIC, // 与libswscale默认一致
+    LANCZOS,
+};
+
+/* 快速路径执行计划 由滤镜描述解析得到 */
+struct FastPathPlan
+{
+    bool hasScale = false;
+    int width = 0;
+    int height = 0;
+    ResizeKernel kernel = ResizeKernel::BICUBIC;
+
+    bool hasHue = false;
+    double hueDegrees = 0.0; // 色相旋转角度
+    double saturation = 1.0; // 饱和度
+};
+
+/* 原生快速路径
+ * 识别 scale=W:H[:flags=bilinear|bicubic|lanczos] 与 hue=h=..:s=.. 组成的滤镜链
+ * 可分离缩放与色相/饱和度调整融合为逐行处理  支持YUV420P/YUVJ420P/RGB24/RGBA
+ * 运行时按CPU特性选择AVX2/SSE4.1/标量内核
+ */
+class FastPathEngine
+{
+public:
+    // 解析滤镜描述  无法识别时返回false
+    static bool parse(std::string const &filterDesc, FastPathPlan &plan);
+
+    // 是否支持该像素格式
+    static bool supportsFormat(AVPixelFormat fmt);
+
+    // 执行快速路径  输出像素格式与输入一致
+    static int process(
+        AVFrame const *inputFrame,
+        FastPathPlan const &plan,
+        AVFrame **outputFrame);
+
+    // 当前选用的内核级别（"avx2"/"sse4.1"/"scalar"）
+    static const char *kernelLevel();
+
+    // 强制使用指定内核级别（基准测试用）  "auto"恢复自动检测  CPU不支持时返回false
+    static bool setKernelLevel(std::string const &level);
+};
+
+} // namespace ImageFlow
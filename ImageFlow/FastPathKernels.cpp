@@ -0,0 +1,380 @@
+#include "FastPathKernels.h"
+//--------------------------
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IMAGEFLOW_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IMAGEFLOW_TARGET(isa) // MSVC无需为内建函数开启指令集
+#else
+#define IMAGEFLOW_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+using namespace ImageFlow;
+using namespace ImageFlow::FastPath;
+
+namespace
+{
+
+inline uint8_t clipByte(int v)
+{
+    return static_cast<uint8_t>(std::clamp(v, 0, 255));
+}
+
+inline int16_t clipShort(int v)
+{
+    return static_cast<int16_t>(std::clamp(v, -32768, 32767));
+}
+
+constexpr int kHorizontalShift = kCoefBits - kInterBits;
+constexpr int kVerticalShift = kCoefBits + kInterBits;
+
+//----------------------------------------------------------------
+// 标量内核  也是SIMD内核的参考实现
+
+void horizontalScalar(
+    uint8_t const *src, int16_t *dst, int dstCount, int channels,
+    int const *starts, int16_t const *coefs, int taps)
+{
+    for (int i = 0; i < dstCount; ++i)
+    {
+        uint8_t const *s = src + starts[i] * channels;
+        int16_t const *c = coefs + i * taps;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            int acc = 0;
+            for (int k = 0; k < taps; ++k)
+                acc += c[k] * s[k * channels + ch];
+            dst[i * channels + ch] = clipShort((acc + (1 << (kHorizontalShift - 1))) >> kHorizontalShift);
+        }
+    }
+}
+
+void verticalScalar(
+    int16_t const *const *rows, int16_t const *coefs, int taps,
+    uint8_t *dst, int count)
+{
+    for (int x = 0; x < count; ++x)
+    {
+        int acc = 0;
+        for (int k = 0; k < taps; ++k)
+            acc += coefs[k] * rows[k][x];
+        dst[x] = clipByte((acc + (1 << (kVerticalShift - 1))) >> kVerticalShift);
+    }
+}
+
+// 与libavfilter vf_hue的色度查找表公式一致
+void hueChromaScalar(uint8_t *u, uint8_t *v, int count, int cosS, int sinS)
+{
+    constexpr int bias = (1 << (kHueBits - 1)) + (128 << kHueBits);
+    for (int x = 0; x < count; ++x)
+    {
+        int cu = u[x] - 128;
+        int cv = v[x] - 128;
+        u[x] = clipByte((cosS * cu - sinS * cv + bias) >> kHueBits);
+        v[x] = clipByte((sinS * cu + cosS * cv + bias) >> kHueBits);
+    }
+}
+
+Kernels const kScalar{"scalar", horizontalScalar, verticalScalar, hueChromaScalar};
+
+#ifdef IMAGEFLOW_X86_SIMD
+
+//----------------------------------------------------------------
+// SSE4.1
+
+IMAGEFLOW_TARGET("sse4.1")
+void horizontalSse41(
+    uint8_t const *src, int16_t *dst, int dstCount, int channels,
+    int const *starts, int16_t const *coefs, int taps)
+{
+    __m128i const round = _mm_set1_epi32(1 << (kHorizontalShift - 1));
+    if (channels == 1)
+    {
+        for (int i = 0; i < dstCount; ++i)
+        {
+            uint8_t const *s = src + starts[i];
+            int16_t const *c = coefs + i * taps;
+            __m128i acc = _mm_setzero_si128();
+            for (int k = 0; k < taps; k += 8)
+            {
+                __m128i px = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(s + k)));
+                __m128i cf = _mm_loadu_si128(reinterpret_cast<__m128i const *>(c + k));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(px, cf));
+            }
+            acc = _mm_hadd_epi32(acc, acc);
+            acc = _mm_hadd_epi32(acc, acc);
+            acc = _mm_srai_epi32(_mm_add_epi32(acc, round), kHorizontalShift);
+            dst[i] = static_cast<int16_t>(_mm_extract_epi16(_mm_packs_epi32(acc, acc), 0));
+        }
+    }
+    else if (channels == 4)
+    {
+        for (int i = 0; i < dstCount; ++i)
+        {
+            uint8_t const *s = src + starts[i] * 4;
+            int16_t const *c = coefs + i * taps;
+            __m128i acc = _mm_setzero_si128();
+            for (int k = 0; k < taps; ++k)
+            {
+                int32_t pixel;
+                std::copy_n(s + k * 4, 4, reinterpret_cast<uint8_t *>(&pixel));
+                __m128i px = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(pixel));
+                acc = _mm_add_epi32(acc, _mm_mullo_epi32(px, _mm_set1_epi32(c[k])));
+            }
+            acc = _mm_srai_epi32(_mm_add_epi32(acc, round), kHorizontalShift);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i * 4), _mm_packs_epi32(acc, acc));
+        }
+    }
+    else
+    {
+        horizontalScalar(src, dst, dstCount, channels, starts, coefs, taps);
+    }
+}
+
+IMAGEFLOW_TARGET("sse4.1")
+void verticalSse41(
+    int16_t const *const *rows, int16_t const *coefs, int taps,
+    uint8_t *dst, int count)
+{
+    __m128i const round = _mm_set1_epi32(1 << (kVerticalShift - 1));
+    int x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        // 两行一组交织后用madd完成乘加  抽头数已对齐为偶数
+        for (int k = 0; k < taps; k += 2)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(rows[k] + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(rows[k + 1] + x));
+            __m128i cf = _mm_set1_epi32((static_cast<uint16_t>(coefs[k + 1]) << 16) | static_cast<uint16_t>(coefs[k]));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), cf));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), cf));
+        }
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), kVerticalShift);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), kVerticalShift);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), packed);
+    }
+    if (x < count)
+    {
+        int16_t const *tail[kMaxTaps];
+        for (int k = 0; k < taps; ++k)
+            tail[k] = rows[k] + x;
+        verticalScalar(tail, coefs, taps, dst + x, count - x);
+    }
+}
+
+IMAGEFLOW_TARGET("sse4.1")
+void hueChromaSse41(uint8_t *u, uint8_t *v, int count, int cosS, int sinS)
+{
+    __m128i const bias = _mm_set1_epi32((1 << (kHueBits - 1)) + (128 << kHueBits));
+    __m128i const c128 = _mm_set1_epi32(128);
+    __m128i const vc = _mm_set1_epi32(cosS);
+    __m128i const vs = _mm_set1_epi32(sinS);
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        int32_t ru, rv;
+        std::copy_n(u + x, 4, reinterpret_cast<uint8_t *>(&ru));
+        std::copy_n(v + x, 4, reinterpret_cast<uint8_t *>(&rv));
+        __m128i cu = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(ru)), c128);
+        __m128i cv = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(rv)), c128);
+        __m128i nu = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_mullo_epi32(vc, cu), _mm_mullo_epi32(vs, cv)), bias), kHueBits);
+        __m128i nv = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(vs, cu), _mm_mullo_epi32(vc, cv)), bias), kHueBits);
+        __m128i pu = _mm_packus_epi16(_mm_packs_epi32(nu, nu), _mm_setzero_si128());
+        __m128i pv = _mm_packus_epi16(_mm_packs_epi32(nv, nv), _mm_setzero_si128());
+        ru = _mm_cvtsi128_si32(pu);
+        rv = _mm_cvtsi128_si32(pv);
+        std::copy_n(reinterpret_cast<uint8_t const *>(&ru), 4, u + x);
+        std::copy_n(reinterpret_cast<uint8_t const *>(&rv), 4, v + x);
+    }
+    hueChromaScalar(u + x, v + x, count - x, cosS, sinS);
+}
+
+Kernels const kSse41{"sse4.1", horizontalSse41, verticalSse41, hueChromaSse41};
+
+//----------------------------------------------------------------
+// AVX2
+
+IMAGEFLOW_TARGET("avx2")
+void horizontalAvx2(
+    uint8_t const *src, int16_t *dst, int dstCount, int channels,
+    int const *starts, int16_t const *coefs, int taps)
+{
+    if (channels != 1)
+    {
+        horizontalSse41(src, dst, dstCount, channels, starts, coefs, taps);
+        return;
+    }
+
+    __m128i const round = _mm_set1_epi32(1 << (kHorizontalShift - 1));
+    for (int i = 0; i < dstCount; ++i)
+    {
+        uint8_t const *s = src + starts[i];
+        int16_t const *c = coefs + i * taps;
+        __m256i acc = _mm256_setzero_si256();
+        int k = 0;
+        for (; k + 16 <= taps; k += 16)
+        {
+            __m256i px = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + k)));
+            __m256i cf = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(c + k));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(px, cf));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        if (k < taps) // 抽头数按8对齐  最多剩余8个
+        {
+            __m128i px = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(s + k)));
+            __m128i cf = _mm_loadu_si128(reinterpret_cast<__m128i const *>(c + k));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(px, cf));
+        }
+        sum = _mm_hadd_epi32(sum, sum);
+        sum = _mm_hadd_epi32(sum, sum);
+        sum = _mm_srai_epi32(_mm_add_epi32(sum, round), kHorizontalShift);
+        dst[i] = static_cast<int16_t>(_mm_extract_epi16(_mm_packs_epi32(sum, sum), 0));
+    }
+}
+
+IMAGEFLOW_TARGET("avx2")
+void verticalAvx2(
+    int16_t const *const *rows, int16_t const *coefs, int taps,
+    uint8_t *dst, int count)
+{
+    __m256i const round = _mm256_set1_epi32(1 << (kVerticalShift - 1));
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+        for (int k = 0; k < taps; k += 2)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(rows[k] + x));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(rows[k + 1] + x));
+            __m256i cf = _mm256_set1_epi32((static_cast<uint16_t>(coefs[k + 1]) << 16) | static_cast<uint16_t>(coefs[k]));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), cf));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), cf));
+        }
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), kVerticalShift);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), kVerticalShift);
+        // unpack与pack都在128位通道内进行  两次操作后元素顺序恢复
+        __m256i words = _mm256_packs_epi32(lo, hi);
+        __m256i bytes = _mm256_packus_epi16(words, _mm256_setzero_si256());
+        bytes = _mm256_permute4x64_epi64(bytes, 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm256_castsi256_si128(bytes));
+    }
+    if (x < count)
+    {
+        int16_t const *tail[kMaxTaps];
+        for (int k = 0; k < taps; ++k)
+            tail[k] = rows[k] + x;
+        verticalSse41(tail, coefs, taps, dst + x, count - x);
+    }
+}
+
+IMAGEFLOW_TARGET("avx2")
+void hueChromaAvx2(uint8_t *u, uint8_t *v, int count, int cosS, int sinS)
+{
+    __m256i const bias = _mm256_set1_epi32((1 << (kHueBits - 1)) + (128 << kHueBits));
+    __m256i const c128 = _mm256_set1_epi32(128);
+    __m256i const vc = _mm256_set1_epi32(cosS);
+    __m256i const vs = _mm256_set1_epi32(sinS);
+    int x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        __m256i cu = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(u + x))), c128);
+        __m256i cv = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(v + x))), c128);
+        __m256i nu = _mm256_srai_epi32(_mm256_add_epi32(_mm256_sub_epi32(_mm256_mullo_epi32(vc, cu), _mm256_mullo_epi32(vs, cv)), bias), kHueBits);
+        __m256i nv = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(vs, cu), _mm256_mullo_epi32(vc, cv)), bias), kHueBits);
+        // 8个32位结果压缩为8字节
+        __m128i wu = _mm_packs_epi32(_mm256_castsi256_si128(nu), _mm256_extracti128_si256(nu, 1));
+        __m128i wv = _mm_packs_epi32(_mm256_castsi256_si128(nv), _mm256_extracti128_si256(nv, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(u + x), _mm_packus_epi16(wu, wu));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(v + x), _mm_packus_epi16(wv, wv));
+    }
+    hueChromaSse41(u + x, v + x, count - x, cosS, sinS);
+}
+
+Kernels const kAvx2{"avx2", horizontalAvx2, verticalAvx2, hueChromaAvx2};
+
+#endif // IMAGEFLOW_X86_SIMD
+
+} // namespace
+
+//----------------------------------------------------------------
+
+Kernels const &FastPath::scalarKernels()
+{
+    return kScalar;
+}
+
+#ifdef IMAGEFLOW_X86_SIMD
+
+Kernels const *FastPath::sse41Kernels()
+{
+    return &kSse41;
+}
+
+Kernels const *FastPath::avx2Kernels()
+{
+    return &kAvx2;
+}
+
+#if defined(_MSC_VER)
+bool FastPath::cpuHasSse41()
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+}
+
+bool FastPath::cpuHasAvx2()
+{
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) // 操作系统需保存YMM寄存器
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+bool FastPath::cpuHasSse41()
+{
+    return __builtin_cpu_supports("sse4.1");
+}
+
+bool FastPath::cpuHasAvx2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#else
+
+Kernels const *FastPath::sse41Kernels()
+{
+    return nullptr;
+}
+
+Kernels const *FastPath::avx2Kernels()
+{
+    return nullptr;
+}
+
+bool FastPath::cpuHasSse41()
+{
+    return false;
+}
+
+bool FastPath::cpuHasAvx2()
+{
+    return false;
+}
+
+#endif // IMAGEFLOW_X86_SIMD
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ImageFlow
+{
+namespace FastPath
+{
+
+constexpr int kCoefBits = 14; // 缩放系数定点位数 系数和为 1 << kCoefBits
+constexpr int kInterBits = 6; // 水平结果（中间行）保留的小数位数
+constexpr int kTapAlign = 8;  // 抽头数按此对齐  SIMD内核无需处理尾部
+constexpr int kMaxTaps = 256; // 抽头数上限  超出时（极端缩小）交回libavfilter
+constexpr int kHueBits = 16;  // 色相旋转系数定点位数
+
+/* 内核函数表 */
+struct Kernels
+{
+    const char *name;
+
+    // 水平缩放一行  src为交织的channels通道  dst按 dstCount * channels 输出中间值
+    // 第i个输出像素使用 src[starts[i] * channels ...] 起的taps个像素与 coefs[i * taps ...]
+    void (*horizontal)(
+        uint8_t const *src, int16_t *dst, int dstCount, int channels,
+        int const *starts, int16_t const *coefs, int taps);
+
+    // 垂直合并taps行中间值为一行输出  count为元素个数
+    void (*vertical)(
+        int16_t const *const *rows, int16_t const *coefs, int taps,
+        uint8_t *dst, int count);
+
+    // 色度平面色相旋转  cosS/sinS为 kHueBits 定点并已乘以饱和度
+    void (*hueChroma)(uint8_t *u, uint8_t *v, int count, int cosS, int sinS);
+};
+
+Kernels const &scalarKernels();
+
+// 以下两组内核仅在x86上提供  调用前需确认CPU支持
+Kernels const *sse41Kernels();
+Kernels const *avx2Kernels();
+
+bool cpuHasSse41();
+bool cpuHasAvx2();
+
+} // namespace FastPath
+} // namespace ImageFlow
@@ -0,0 +1,212 @@
+#include "FilterChainPlanner.h"
+//--------------------------
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+// 逐像素滤镜  输出像素只依赖同位置输入像素  可以与缩放、条带切分交换
+std::unordered_set<std::string_view> const kPerPixelFilters{
+    "hue", "eq", "colorbalance", "colorchannelmixer", "colorcontrast",
+    "colorlevels", "colortemperature", "curves", "exposure", "huesaturation",
+    "lut", "lutrgb", "lutyuv", "negate", "selectivecolor", "vibrance",
+    "format", "null"};
+
+// 支持运行时命令修改的参数（AV_OPT_FLAG_RUNTIME_PARAM）
+std::unordered_map<std::string_view, std::unordered_set<std::string_view>> const kRuntimeOptions{
+    {"hue", {"h", "H", "s", "b"}},
+    {"eq", {"contrast", "brightness", "saturation", "gamma", "gamma_r", "gamma_g", "gamma_b", "gamma_weight"}},
+    {"colorbalance", {"rs", "gs", "bs", "rm", "gm", "bm", "rh", "gh", "bh"}}};
+
+std::string join(std::vector<std::string> const &items, size_t first, size_t last)
+{
+    std::string result;
+    for (size_t i = first; i < last; ++i)
+    {
+        if (!result.empty())
+            result += ",";
+        result += items[i];
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<std::string> FilterChainPlanner::split(std::string const &filterDesc)
+{
+    std::vector<std::string> items;
+    std::string current;
+    bool quoted = false;
+    for (size_t i = 0; i < filterDesc.size(); ++i)
+    {
+        char c = filterDesc[i];
+        if (c == '\\' && i + 1 < filterDesc.size())
+        {
+            current += c;
+            current += filterDesc[++i];
+            continue;
+        }
+        if (c == '\'')
+            quoted = !quoted;
+        if (c == ',' && !quoted)
+        {
+            if (auto item = Utils::trim(current); !item.empty())
+                items.emplace_back(item);
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    if (auto item = Utils::trim(current); !item.empty())
+        items.emplace_back(item);
+    return items;
+}
+
+std::string_view FilterChainPlanner::filterName(std::string_view item)
+{
+    return Utils::trim(item.substr(0, item.find('=')));
+}
+
+bool FilterChainPlanner::isPerPixelFilter(std::string_view name)
+{
+    return kPerPixelFilters.contains(name);
+}
+
+bool FilterChainPlanner::isPerPixelChain(std::string const &filterDesc)
+{
+    if (filterDesc.find_first_of("[];") != std::string::npos)
+        return false;
+
+    for (auto &&item : split(filterDesc))
+    {
+        if (!isPerPixelFilter(filterName(item)))
+            return false;
+    }
+    return true;
+}
+
+bool FilterChainPlanner::isNoOpChain(std::string const &filterDesc)
+{
+    if (filterDesc.find_first_of("[];") != std::string::npos)
+        return false;
+
+    for (auto &&item : split(filterDesc))
+    {
+        auto name = filterName(item);
+        if (name != "null" && name != "copy")
+            return false;
+    }
+    return true;
+}
+
+bool FilterChainPlanner::makeTemplate(
+    std::string const &filterDesc,
+    FilterTemplate &tmpl)
+{
+    tmpl.key.clear();
+    tmpl.commands.clear();
+
+    // 实例名按滤镜在整个描述中的序号生成  只处理单条无标签的链
+    if (filterDesc.find_first_of("[];'\\") != std::string::npos)
+        return false;
+
+    auto items = split(filterDesc);
+    for (size_t idx = 0; idx < items.size(); ++idx)
+    {
+        std::string_view item = items[idx];
+        auto name = filterName(item);
+        auto runtime = kRuntimeOptions.find(name);
+        auto eq = item.find('=');
+        if (runtime == kRuntimeOptions.end() || eq == std::string_view::npos)
+        {
+            items[idx] = std::string(item);
+            continue;
+        }
+
+        // 逐个参数改写  位置参数无法确定参数名  整个描述不做模板
+        std::string rewritten = std::string(name) + "=";
+        std::string_view args = item.substr(eq + 1);
+        bool first = true;
+        while (!args.empty())
+        {
+            auto colon = args.find(':');
+            auto arg = args.substr(0, colon);
+            args = colon == std::string_view::npos ? std::string_view{} : args.substr(colon + 1);
+
+            auto assign = arg.find('=');
+            if (assign == std::string_view::npos)
+                return false;
+            auto option = Utils::trim(arg.substr(0, assign));
+            auto value = Utils::trim(arg.substr(assign + 1));
+
+            if (!first)
+                rewritten += ":";
+            first = false;
+            rewritten += option;
+            rewritten += "=";
+            if (runtime->second.contains(option))
+            {
+                rewritten += "?";
+                tmpl.commands.push_back({"Parsed_" + std::string(name) + "_" + std::to_string(idx),
+                                         std::string(option), std::string(value)});
+            }
+            else
+            {
+                rewritten += value;
+            }
+        }
+        items[idx] = std::move(rewritten);
+    }
+
+    if (tmpl.commands.empty())
+        return false;
+    tmpl.key = join(items, 0, items.size());
+    return true;
+}
+
+FilterChainPlan FilterChainPlanner::plan(
+    std::string const &userFilter,
+    int srcWidth, int srcHeight,
+    int dstWidth, int dstHeight)
+{
+    if (dstWidth <= 0 || dstHeight <= 0)
+        return {userFilter, "noscale"};
+
+    std::string scale = "scale=" + std::to_string(dstWidth) + ":" + std::to_string(dstHeight);
+    if (userFilter.empty())
+        return {scale, "scale"};
+
+    // 带标签或多条链的描述无法安全重排  保持缩放在前
+    if (userFilter.find_first_of("[];") != std::string::npos)
+        return {scale + "," + userFilter, "fixed"};
+
+    // 缩小或尺寸不变时逐像素滤镜放在缩放之后
+    int64_t srcPixels = static_cast<int64_t>(srcWidth) * srcHeight;
+    int64_t dstPixels = static_cast<int64_t>(dstWidth) * dstHeight;
+    if (srcWidth <= 0 || srcHeight <= 0 || dstPixels <= srcPixels)
+        return {scale + "," + userFilter, "post"};
+
+    // 放大时  把链首连续的逐像素滤镜移到缩放之前  遇到不可交换的滤镜即停止
+    auto items = split(userFilter);
+    size_t moved = 0;
+    while (moved < items.size() && isPerPixelFilter(filterName(items[moved])))
+        ++moved;
+    if (moved == 0)
+        return {scale + "," + userFilter, "post"};
+
+    FilterChainPlan result;
+    result.filterDesc = join(items, 0, moved) + "," + scale;
+    if (moved < items.size())
+        result.filterDesc += "," + join(items, moved, items.size());
+    result.decision = "pre" + std::to_string(moved);
+    return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImageFlow
+{
+
+/* 滤镜链规划结果 */
+struct FilterChainPlan
+{
+    std::string filterDesc; // 排序后的完整滤镜描述（含缩放）
+    std::string decision;   // 规划结论  进入滤镜图缓存键与调试日志
+};
+
+/* 运行时可修改的滤镜参数 */
+struct FilterCommand
+{
+    std::string target; // 滤镜实例名 Parsed_<滤镜名>_<序号>
+    std::string option; // 参数名
+    std::string value;  // 参数值
+};
+
+/* 滤镜链的结构模板
+ * 运行时可修改的参数值替换为占位符  结构相同的滤镜描述共用一个滤镜图
+ * 取用时通过avfilter_graph_send_command设置实际参数值
+ */
+struct FilterTemplate
+{
+    std::string key;                     // 参数值替换为占位符后的描述
+    std::vector<FilterCommand> commands; // 被替换的参数  按出现顺序
+};
+
+/* 滤镜链规划器
+ * 逐像素滤镜（hue、eq、colorbalance等）与缩放可交换
+ * 放大时将其移到缩放之前  缩小时保持在缩放之后  使其总在较小的尺寸上运行
+ */
+class FilterChainPlanner
+{
+public:
+    // 按顶层逗号拆分滤镜链（忽略引号与转义内的逗号）
+    static std::vector<std::string> split(std::string const &filterDesc);
+
+    // 取单个滤镜项的滤镜名
+    static std::string_view filterName(std::string_view item);
+
+    // 是否为可与缩放交换的逐像素滤镜
+    static bool isPerPixelFilter(std::string_view name);
+
+    // 滤镜链中只包含逐像素滤镜（不支持标签与多链）
+    static bool isPerPixelChain(std::string const &filterDesc);
+
+    // 滤镜链为空或只包含不改变像素的null、copy
+    static bool isNoOpChain(std::string const &filterDesc);
+
+    // 提取结构模板  不含可修改参数或无法安全改写（标签、多链、位置参数、引号）时返回false
+    static bool makeTemplate(
+        std::string const &filterDesc,
+        FilterTemplate &tmpl);
+
+    // 根据源尺寸与目标尺寸排列缩放与用户滤镜
+    // 目标尺寸无效时不插入缩放  源尺寸未知（<=0）时按缩小处理
+    static FilterChainPlan plan(
+        std::string const &userFilter,
+        int srcWidth, int srcHeight,
+        int dstWidth, int dstHeight);
+};
+
+} // namespace ImageFlow
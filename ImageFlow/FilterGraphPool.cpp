@@ -22,25 +22,35 @@ extern "C"
 #include <libavutil/pixdesc.h>
 #include <libavutil/pixfmt.h>
 }
+//--------------------------
+#include "FastPathEngine.h"
+#include "FilterChainPlanner.h"
+#include "InstrumentedMutex.h"
+#include "Tracer.h"
 
 using namespace ImageFlow;
 
 struct FilterGraphCacheKey
 {
 public:
-    int width;              // ͼ
-    int height;             // ͼ߶
-    AVPixelFormat pixelFmt; // ظʽ
-    std::string filterDesc; // ˾ַ
+    int width;              // 图像宽度
+    int height;             // 图像高度
+    AVPixelFormat pixelFmt; // 像素格式
+    std::string filterDesc; // 滤镜描述字符串
+    int threadCount;        // 滤镜图内线程数
 
 public:
-    static FilterGraphCacheKey fromFrame(AVFrame const *frame, std::string const &descr)
+    static FilterGraphCacheKey fromFrame(
+        AVFrame const *frame,
+        std::string const &descr,
+        FilterGraphOptions const &options)
     {
         return FilterGraphCacheKey{
             frame->width,
             frame->height,
             static_cast<AVPixelFormat>(frame->format),
-            descr.c_str()};
+            descr.c_str(),
+            options.threadCount};
     }
 
     bool operator==(FilterGraphCacheKey const &other) const
@@ -48,7 +58,8 @@ public:
         return width == other.width &&
                height == other.height &&
                pixelFmt == other.pixelFmt &&
-               filterDesc == other.filterDesc;
+               filterDesc == other.filterDesc &&
+               threadCount == other.threadCount;
     }
 };
 
@@ -62,7 +73,8 @@ struct hash<::FilterGraphCacheKey>
         return hash<int>()(key.width) ^
                (hash<int>()(key.height) << 1) ^
                (hash<int>()(key.pixelFmt) << 2) ^
-               (hash<string>()(key.filterDesc) << 3);
+               (hash<string>()(key.filterDesc) << 3) ^
+               (hash<int>()(key.threadCount) << 4);
     }
 };
 } // namespace std
@@ -83,7 +95,7 @@ FilterGraphCacheItem::~FilterGraphCacheItem()
     if (mGraph)
     {
         avfilter_graph_free(&mGraph);
-        // bufferSrcVtxbufferSinkCtxᱻgraphһͷ
+        // bufferSrcVtx和bufferSinkCtx会被graph一起释放
     }
 }
 
@@ -96,7 +108,7 @@ bool FilterGraphCacheItem::acquire()
         mLastUsed = std::chrono::steady_clock::now();
         return true;
     }
-    return false; // ڱ߳ʹ
+    return false; // 正在被其他线程使用
 }
 
 void FilterGraphCacheItem::release()
@@ -146,10 +158,28 @@ struct FilterGraphPool::Impl
 {
 public:
     size_t mMaxSize;
-    std::mutex mMutex;
+    ProfiledMutex mMutex{"FilterGraphPool::mMutex"};
     std::atomic<std::chrono::seconds::rep> mCleanupTimeout;
     std::unordered_map<FilterGraphCacheKey, FilterGraphPtr> mCache;
 
+    // 指标计数器
+    std::atomic<uint64_t> mHits = 0;
+    std::atomic<uint64_t> mMisses = 0;
+    std::atomic<uint64_t> mBuilds = 0;
+    std::atomic<uint64_t> mBuildFailures = 0;
+    std::atomic<uint64_t> mBuildNanos = 0;
+    std::atomic<uint64_t> mMaxBuildNanos = 0;
+    std::atomic<uint64_t> mReparams = 0;
+    std::atomic<uint64_t> mEvictions = 0;
+    std::atomic<uint64_t> mExpirations = 0;
+    std::atomic<uint64_t> mBusyWaits = 0;
+    std::atomic<uint64_t> mWaitNanos = 0;
+    std::atomic<uint64_t> mBusyRejects = 0;
+    std::atomic<uint64_t> mCapacityRejects = 0;
+    std::atomic<uint64_t> mLockWaitNanos = 0;
+    std::atomic<uint64_t> mEnomem = 0;
+    std::atomic<uint64_t> mFastPathFrames = 0;
+
 public:
     Impl(size_t maxSize, std::chrono::seconds cleanupTimeout)
         : mMaxSize(maxSize)
@@ -159,30 +189,35 @@ public:
 
     ~Impl()
     {
-        std::lock_guard<std::mutex> _(mMutex);
+        std::lock_guard<ProfiledMutex> _(mMutex);
         mCache.clear();
     }
 
 public:
-    // µ˾ͼ
+    // 创建新的滤镜图
     FilterGraphPtr createFilterGraph(
         AVFrame const *frame,
-        std::string const &filterDesc)
+        std::string const &filterDesc,
+        FilterGraphOptions const &options)
     {
-        // ˾ͼ
+        // 创建滤镜图
         auto filterGraph = avfilter_graph_alloc();
         if (!filterGraph)
         {
-            // std::cerr << "޷˾ͼ" << std::endl;
+            // std::cerr << "无法创建滤镜图" << std::endl;
             return nullptr;
         }
 
+        // 线程数必须在添加滤镜之前设置
+        if (options.threadCount > 0)
+            filterGraph->nb_threads = options.threadCount;
+
         AVFilterContext *bufferSrcCtx = nullptr;
         AVFilterContext *bufferSinkCtx = nullptr;
 
         //----------------------------------------------------
 
-        // Դ
+        // 创建缓冲区源
         auto bufferSrc = avfilter_get_by_name("buffer");
         if (!bufferSrc)
         {
@@ -190,7 +225,7 @@ public:
             return nullptr;
         }
 
-        // ûԴ
+        // 配置缓冲区源
         char args[512];
         snprintf(args, sizeof(args),
                  "video_size=%dx%d:pix_fmt=%d:time_base=1/1:pixel_aspect=1/1",
@@ -201,13 +236,13 @@ public:
                 args, nullptr, filterGraph) < 0)
         {
             avfilter_graph_free(&filterGraph);
-            // std::cerr << "޷Դ" << std::endl;
+            // std::cerr << "无法创建缓冲区源" << std::endl;
             return nullptr;
         }
 
         //----------------------------------------------------
 
-        // 
+        // 创建缓冲区接收器
         auto bufferSink = avfilter_get_by_name("buffersink");
         if (!bufferSink)
         {
@@ -215,19 +250,19 @@ public:
             return nullptr;
         }
 
-        // û
+        // 配置缓冲区接收器
         if (avfilter_graph_create_filter(
                 &bufferSinkCtx, bufferSink, "out",
                 nullptr, nullptr, filterGraph) < 0)
         {
             avfilter_graph_free(&filterGraph);
-            // std::cerr << "޷" << std::endl;
+            // std::cerr << "无法创建缓冲区接收器" << std::endl;
             return nullptr;
         }
 
         //----------------------------------------------------
 
-        // ˾
+        // 配置滤镜链
         AVFilterInOut *outputs = avfilter_inout_alloc();
         AVFilterInOut *inputs = avfilter_inout_alloc();
 
@@ -257,27 +292,115 @@ public:
         if (ret < 0)
         {
             avfilter_graph_free(&filterGraph);
-            // std::cerr << "޷˾ͼ" << std::endl;
+            // std::cerr << "无法解析滤镜图" << std::endl;
             return nullptr;
         }
 
-        // ˾ͼ
+        // 配置滤镜图
         if (avfilter_graph_config(filterGraph, nullptr) < 0)
         {
             avfilter_graph_free(&filterGraph);
-            // std::cerr << "޷˾ͼ" << std::endl;
+            // std::cerr << "无法配置滤镜图" << std::endl;
             return nullptr;
         }
 
         return std::make_shared<FilterGraphCacheItem>(filterGraph, bufferSrcCtx, bufferSinkCtx);
     }
 
-    // ɻ
+    // 将模板参数设置为本次的值  只发送与当前值不同的参数
+    bool reparameterize(
+        FilterGraphPtr const &item,
+        FilterTemplate const &tmpl)
+    {
+        if (item->mParams.size() != tmpl.commands.size())
+            return false;
+
+        bool changed = false;
+        for (size_t i = 0; i < tmpl.commands.size(); ++i)
+        {
+            auto &&command = tmpl.commands[i];
+            if (item->mParams[i] == command.value)
+                continue;
+
+            char response[256] = {0};
+            if (avfilter_graph_send_command(
+                    item->mGraph, command.target.c_str(),
+                    command.option.c_str(), command.value.c_str(),
+                    response, sizeof(response), 0) < 0)
+            {
+                // 部分参数可能已生效  当前值不再可信
+                item->mParams.clear();
+                return false;
+            }
+            item->mParams[i] = command.value;
+            changed = true;
+        }
+        if (changed)
+            ++mReparams;
+        return true;
+    }
+
+    // 清理长时间未使用的滤镜图  调用时持有mMutex
+    size_t cleanupUnusedLocked()
+    {
+        std::chrono::seconds currentTimeout(mCleanupTimeout.load());
+        std::vector<FilterGraphCacheKey> toRemove;
+        for (auto &&[key, value] : mCache)
+        {
+            if (value->canCleanup(currentTimeout))
+                toRemove.push_back(key);
+        }
+
+        for (auto &&key : toRemove)
+            mCache.erase(key);
+        mExpirations += toRemove.size();
+        return toRemove.size();
+    }
+
+    // 构建滤镜图并记录耗时
+    FilterGraphPtr buildFilterGraph(
+        AVFrame const *frame,
+        std::string const &filterDesc,
+        FilterGraphOptions const &options)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        auto item = createFilterGraph(frame, filterDesc, options);
+        uint64_t nanos = elapsedNanos(begin);
+        Tracer::getInstance().record("graph_build", begin);
+
+        ++mBuilds;
+        if (!item)
+            ++mBuildFailures;
+        mBuildNanos += nanos;
+        uint64_t prev = mMaxBuildNanos.load();
+        while (prev < nanos && !mMaxBuildNanos.compare_exchange_weak(prev, nanos))
+        {
+        }
+        return item;
+    }
+
+    // 加锁并记录等待耗时
+    void lockTimed(ProfiledLock &lock)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        lock.lock();
+        mLockWaitNanos += elapsedNanos(begin);
+    }
+
+    static uint64_t elapsedNanos(std::chrono::steady_clock::time_point begin)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - begin)
+                                         .count());
+    }
+
+    // 生成缓存键
     FilterGraphCacheKey makeKey(
         AVFrame const *frame,
-        std::string const &filterDesc) const
+        std::string const &filterDesc,
+        FilterGraphOptions const &options) const
     {
-        return FilterGraphCacheKey::fromFrame(frame, filterDesc);
+        return FilterGraphCacheKey::fromFrame(frame, filterDesc, options);
     }
 };
 
@@ -292,52 +415,87 @@ FilterGraphPool::FilterGraphPtr
 FilterGraphPool::getFilterGraph(
     AVFrame const *frame,
     std::string const &filterDesc,
-    bool waitIfBusy)
+    bool waitIfBusy,
+    FilterGraphOptions const &options)
 {
     if (!frame)
         return nullptr;
+    TraceScope span("graph_acquire");
 
-    auto key = mPimpl->makeKey(frame, filterDesc);
-    std::unique_lock<std::mutex> lock(mPimpl->mMutex);
+    // 可修改参数不同的描述共用同一个缓存键
+    FilterTemplate tmpl;
+    bool templated = FilterChainPlanner::makeTemplate(filterDesc, tmpl);
+    auto key = mPimpl->makeKey(frame, templated ? tmpl.key : filterDesc, options);
+    ProfiledLock lock(mPimpl->mMutex, std::defer_lock);
+    mPimpl->lockTimed(lock);
+
+    // 已获取使用权的缓存项设置本次参数  失败时按实际描述重建并替换
+    auto prepare = [&](FilterGraphPtr const &item) -> FilterGraphPtr
+    {
+        if (!templated || mPimpl->reparameterize(item, tmpl))
+            return item;
 
-    // һ
+        auto rebuilt = mPimpl->buildFilterGraph(frame, filterDesc, options);
+        item->release();
+        if (!rebuilt || !rebuilt->acquire())
+            return nullptr;
+        for (auto &&command : tmpl.commands)
+            rebuilt->mParams.push_back(command.value);
+        mPimpl->mCache[key] = rebuilt;
+        return rebuilt;
+    };
+
+    // 查找缓存
     if (auto it = mPimpl->mCache.find(key); it != mPimpl->mCache.end())
     {
-        // ԻȡʹȨ
+        // 尝试获取使用权
         if (it->second->acquire())
-            return it->second;
+        {
+            ++mPimpl->mHits;
+            return prepare(it->second);
+        }
         else if (waitIfBusy)
         {
-            // ʵһ򵥵ĵȴ - ָ˱ + ȴ
+            // 这里实现一个简单的等待机制 - 指数退避 + 等待
+            ++mPimpl->mBusyWaits;
+            auto waitBegin = std::chrono::steady_clock::now();
 
-            int maxRetries = 5;   // Դ
-            int baseBelayMs = 10; // 10msӳ
+            int maxRetries = 5;   // 最大重试次数
+            int baseBelayMs = 10; // 10ms基础延迟
             for (int retry = 0; retry < maxRetries; ++retry)
             {
                 lock.unlock();
                 {
-                    // ָ˱ӳ
+                    // 指数退避延迟
                     int delayMs = baseBelayMs * (1 << retry); // 10, 20, 40, 80, 160ms
                     std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
                 }
-                lock.lock();
+                mPimpl->lockTimed(lock);
 
-                // ¼
+                // 重新检查
                 auto it = mPimpl->mCache.find(key);
                 if (it != mPimpl->mCache.end() &&
                     it->second->acquire())
-                    return it->second;
+                {
+                    mPimpl->mWaitNanos += Impl::elapsedNanos(waitBegin);
+                    ++mPimpl->mHits;
+                    return prepare(it->second);
+                }
             }
+            mPimpl->mWaitNanos += Impl::elapsedNanos(waitBegin);
         }
+        ++mPimpl->mBusyRejects;
         return nullptr;
     }
 
-    // δУ黺С
+    ++mPimpl->mMisses;
+
+    // 缓存未命中，检查缓存大小
     if (mPimpl->mCache.size() >= mPimpl->mMaxSize)
     {
-        cleanupUnused();
+        mPimpl->cleanupUnusedLocked();
 
-        // ģƳһδʹõ
+        // 如果还是满的，移除一个最久未使用的
         if (mPimpl->mCache.size() >= mPimpl->mMaxSize)
         {
             auto oldestIt = mPimpl->mCache.begin();
@@ -348,22 +506,29 @@ FilterGraphPool::getFilterGraph(
                     oldestIt = current;
             }
             if (!oldestIt->second->isInUse())
-            { // Ƴδʹõ
+            { // 移除最久未使用的
                 mPimpl->mCache.erase(oldestIt);
+                ++mPimpl->mEvictions;
             }
             else
-            { // ޿ÿռ
+            { // 无可用空间
+                ++mPimpl->mCapacityRejects;
                 return nullptr;
             }
         }
     }
 
-    // µ˾ͼ
-    auto newItem = mPimpl->createFilterGraph(frame, filterDesc);
+    // 创建新的滤镜图
+    auto newItem = mPimpl->buildFilterGraph(frame, filterDesc, options);
     if (newItem)
     {
         if (newItem->acquire())
         {
+            if (templated)
+            {
+                for (auto &&command : tmpl.commands)
+                    newItem->mParams.push_back(command.value);
+            }
             mPimpl->mCache[key] = newItem;
             return newItem;
         }
@@ -374,21 +539,38 @@ FilterGraphPool::getFilterGraph(
 int FilterGraphPool::processFrame(
     AVFrame *inputFrame,
     std::string const &filterDesc,
-    AVFrame **outputFrame)
+    AVFrame **outputFrame,
+    FilterGraphOptions const &options)
 {
     if (!inputFrame)
     {
         return AVERROR(EINVAL);
     }
 
-    // ڲȡ˾ͼ ȷʹͷ
-    auto filterItem = getFilterGraph(inputFrame, filterDesc, true);
+    // 常见的缩放+色相组合直接走原生内核  其余滤镜描述回退到libavfilter
+    if (options.allowFastPath)
+    {
+        FastPathPlan plan;
+        if (FastPathEngine::parse(filterDesc, plan))
+        {
+            int ret = FastPathEngine::process(inputFrame, plan, outputFrame);
+            if (ret != AVERROR(ENOSYS))
+            {
+                ++mPimpl->mFastPathFrames;
+                return ret;
+            }
+        }
+    }
+
+    // 内部获取滤镜图 确保在使用完后释放
+    auto filterItem = getFilterGraph(inputFrame, filterDesc, true, options);
     if (!filterItem)
     {
+        ++mPimpl->mEnomem;
         return AVERROR(ENOMEM);
     }
 
-    // ʹRAIIȷͷ
+    // 使用RAII确保释放
     struct FilterGuard
     {
         std::shared_ptr<FilterGraphCacheItem> item;
@@ -399,7 +581,20 @@ int FilterGraphPool::processFrame(
         }
     } guard{filterItem};
 
-    // ֡˾ͼ
+    return processFrame(filterItem, inputFrame, outputFrame);
+}
+
+int FilterGraphPool::processFrame(
+    FilterGraphPtr const &filterItem,
+    AVFrame *inputFrame,
+    AVFrame **outputFrame)
+{
+    if (!filterItem || !inputFrame)
+    {
+        return AVERROR(EINVAL);
+    }
+
+    // 发送帧到滤镜图
     int ret = av_buffersrc_add_frame_flags(filterItem->mBufferSrcVtx,
                                            inputFrame, AV_BUFFERSRC_FLAG_KEEP_REF);
     if (ret < 0)
@@ -407,14 +602,14 @@ int FilterGraphPool::processFrame(
         return ret;
     }
 
-    // ֡
+    // 分配输出帧
     *outputFrame = av_frame_alloc();
     if (!*outputFrame)
     {
         return AVERROR(ENOMEM);
     }
 
-    // ˾ͼ֡
+    // 从滤镜图接收帧
     ret = av_buffersink_get_frame(filterItem->mBufferSinkCtx, *outputFrame);
     if (ret < 0)
     {
@@ -425,32 +620,64 @@ int FilterGraphPool::processFrame(
     return 0;
 }
 
-size_t FilterGraphPool::cleanupUnused()
+void FilterGraphPool::releaseFilterGraph(FilterGraphPtr &filterGraph)
 {
-    std::lock_guard<std::mutex> _(mPimpl->mMutex);
-
-    std::chrono::seconds currentTimeout(mPimpl->mCleanupTimeout.load());
-    std::vector<FilterGraphCacheKey> toRemove;
-    for (auto &&[key, value] : mPimpl->mCache)
+    if (filterGraph)
     {
-        if (value->canCleanup(currentTimeout))
-            toRemove.push_back(key);
+        filterGraph->release();
+        filterGraph.reset();
     }
+}
+
+size_t FilterGraphPool::cleanupUnused()
+{
+    std::lock_guard<ProfiledMutex> _(mPimpl->mMutex);
+    return mPimpl->cleanupUnusedLocked();
+}
 
-    for (auto &&key : toRemove)
-        mPimpl->mCache.erase(key);
-    return toRemove.size();
+FilterGraphPoolMetrics FilterGraphPool::getMetrics() const
+{
+    FilterGraphPoolMetrics metrics;
+    metrics.hits = mPimpl->mHits.load();
+    metrics.misses = mPimpl->mMisses.load();
+    metrics.builds = mPimpl->mBuilds.load();
+    metrics.buildFailures = mPimpl->mBuildFailures.load();
+    metrics.buildNanos = mPimpl->mBuildNanos.load();
+    metrics.maxBuildNanos = mPimpl->mMaxBuildNanos.load();
+    metrics.reparams = mPimpl->mReparams.load();
+    metrics.evictions = mPimpl->mEvictions.load();
+    metrics.expirations = mPimpl->mExpirations.load();
+    metrics.busyWaits = mPimpl->mBusyWaits.load();
+    metrics.waitNanos = mPimpl->mWaitNanos.load();
+    metrics.busyRejects = mPimpl->mBusyRejects.load();
+    metrics.capacityRejects = mPimpl->mCapacityRejects.load();
+    metrics.lockWaitNanos = mPimpl->mLockWaitNanos.load();
+    metrics.enomem = mPimpl->mEnomem.load();
+    metrics.fastPathFrames = mPimpl->mFastPathFrames.load();
+    metrics.cacheSize = getCacheSize();
+    metrics.maxSize = getMaxSize();
+    return metrics;
+}
+
+void FilterGraphPool::resetMetrics()
+{
+    for (auto counter : {&mPimpl->mHits, &mPimpl->mMisses, &mPimpl->mBuilds, &mPimpl->mBuildFailures,
+                         &mPimpl->mBuildNanos, &mPimpl->mMaxBuildNanos, &mPimpl->mReparams,
+                         &mPimpl->mEvictions, &mPimpl->mExpirations, &mPimpl->mBusyWaits,
+                         &mPimpl->mWaitNanos, &mPimpl->mBusyRejects, &mPimpl->mCapacityRejects,
+                         &mPimpl->mLockWaitNanos, &mPimpl->mEnomem, &mPimpl->mFastPathFrames})
+        counter->store(0);
 }
 
 void FilterGraphPool::clear()
 {
-    std::lock_guard<std::mutex> _(mPimpl->mMutex);
+    std::lock_guard<ProfiledMutex> _(mPimpl->mMutex);
     mPimpl->mCache.clear();
 }
 
 size_t FilterGraphPool::getCacheSize() const
 {
-    std::lock_guard<std::mutex> lock(mPimpl->mMutex);
+    std::lock_guard<ProfiledMutex> lock(mPimpl->mMutex);
     return mPimpl->mCache.size();
 }
 
@@ -461,14 +688,14 @@ size_t FilterGraphPool::getMaxSize() const
 
 bool FilterGraphPool::setMaxSize(size_t maxSize)
 {
-    std::lock_guard<std::mutex> lock(mPimpl->mMutex);
+    std::lock_guard<ProfiledMutex> lock(mPimpl->mMutex);
 
-    if (mPimpl->mCache.size() > mPimpl->mMaxSize)
-    { // µĴССڵǰСƳ
-        cleanupUnused();
+    if (mPimpl->mCache.size() > maxSize)
+    { // 如果新的大小小于当前缓存大小，移除多余的项
+        mPimpl->cleanupUnusedLocked();
 
-        // ̫ǿƳһЩʹʱ䣩
-        while (mPimpl->mCache.size() > mPimpl->mMaxSize)
+        // 如果还是太大，强制移除一些（按最后使用时间）
+        while (mPimpl->mCache.size() > maxSize)
         {
             auto oldestIt = mPimpl->mCache.begin();
             for (auto it = mPimpl->mCache.begin(); it != mPimpl->mCache.end(); ++it)
@@ -480,7 +707,7 @@ bool FilterGraphPool::setMaxSize(size_t maxSize)
             if (!oldestIt->second->isInUse())
                 mPimpl->mCache.erase(oldestIt);
             else
-                return false; // ʹУ޷
+                return false; // 在使用中，无法清理
         }
     }
     mPimpl->mMaxSize = maxSize;
@@ -499,13 +726,27 @@ std::chrono::seconds FilterGraphPool::getCleanupTimeout() const
 
 void FilterGraphPool::printCacheStatus() const
 {
-    std::lock_guard<std::mutex> lock(mPimpl->mMutex);
+    // getMetrics内部会加锁  须在持锁之前取得
+    auto metrics = getMetrics();
+    std::lock_guard<ProfiledMutex> lock(mPimpl->mMutex);
 
     std::chrono::seconds currentTimeout(mPimpl->mCleanupTimeout.load());
-    std::cout << "=== ˾ͼ״̬ ===" << std::endl;
-    std::cout << "  ܻͼ" << mPimpl->mCache.size() << std::endl;
-    std::cout << "  󻺴" << mPimpl->mMaxSize << std::endl;
-    std::cout << " ʱޣ" << currentTimeout.count() << " " << std::endl;
+    std::cout << "=== 滤镜图缓存的状态 ===" << std::endl;
+    std::cout << "  总缓存图数：" << mPimpl->mCache.size() << std::endl;
+    std::cout << "  最大缓存数：" << mPimpl->mMaxSize << std::endl;
+    std::cout << " 清理时限：" << currentTimeout.count() << " 秒" << std::endl;
+
+    uint64_t lookups = metrics.hits + metrics.misses;
+    std::cout << "  命中率：" << (lookups ? metrics.hits * 100.0 / lookups : 0.0) << "% ("
+              << metrics.hits << "/" << lookups << ")" << std::endl;
+    std::cout << "  构建：" << metrics.builds << " 次  失败 " << metrics.buildFailures
+              << "  平均 " << (metrics.builds ? metrics.buildNanos / 1e6 / metrics.builds : 0.0) << " ms"
+              << "  最长 " << metrics.maxBuildNanos / 1e6 << " ms" << std::endl;
+    std::cout << "  参数重设：" << metrics.reparams << " 次  淘汰 " << metrics.evictions
+              << "  超时清理 " << metrics.expirations << std::endl;
+    std::cout << "  退避等待：" << metrics.busyWaits << " 次 共 " << metrics.waitNanos / 1e6 << " ms"
+              << "  占用拒绝 " << metrics.busyRejects << "  容量拒绝 " << metrics.capacityRejects
+              << "  ENOMEM " << metrics.enomem << std::endl;
 
     int inUseCount = 0;
     int totalUseCount = 0;
@@ -520,13 +761,14 @@ void FilterGraphPool::printCacheStatus() const
 
         const char *pixFmtName = av_get_pix_fmt_name(key.pixelFmt);
         std::cout << "  - " << key.width << "x" << key.height
-                  << " ʽ:" << (pixFmtName ? pixFmtName : "unknown")
-                  << " :" << value->getUseCount()
-                  << " ʹ:" << (value->isInUse() ? "" : "")
-                  << " ϴʹ:" << timeSinceUse.count() << "s ֮ǰ"
+                  << " 格式:" << (pixFmtName ? pixFmtName : "unknown")
+                  << " 线程:" << key.threadCount
+                  << " 引用数:" << value->getUseCount()
+                  << " 使用中:" << (value->isInUse() ? "是" : "否")
+                  << " 上次使用:" << timeSinceUse.count() << "s 之前"
                   << std::endl;
     }
-    std::cout << "ǰʹã" << inUseCount << std::endl;
-    std::cout << "ʹ" << totalUseCount << std::endl;
+    std::cout << "当前正在使用：" << inUseCount << std::endl;
+    std::cout << "使用总数：" << totalUseCount << std::endl;
     std::cout << "=================================" << std::endl;
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 //-------------------------
 extern "C"
 {
@@ -14,18 +16,19 @@ extern "C"
 namespace ImageFlow
 {
 
-/* ˾ͼ */
+/* 滤镜图对象 */
 class FilterGraphCacheItem
 {
     friend class FilterGraphPool;
 
 private:
-    AVFilterGraph *mGraph;                           // ˾ͼ
-    AVFilterContext *mBufferSrcVtx;                  // 뻺˾
-    AVFilterContext *mBufferSinkCtx;                 // ˾
-    std::atomic<int> mUseCount = 1;                  // ü
-    std::atomic<bool> mInUse = false;                // Ƿʹ
-    std::chrono::steady_clock::time_point mLastUsed; // ϴʹʱ
+    AVFilterGraph *mGraph;                           // 滤镜图
+    AVFilterContext *mBufferSrcVtx;                  // 输入缓冲区滤镜
+    AVFilterContext *mBufferSinkCtx;                 // 输出缓冲区滤镜
+    std::atomic<int> mUseCount = 1;                  // 引用计数
+    std::atomic<bool> mInUse = false;                // 是否正在使用
+    std::chrono::steady_clock::time_point mLastUsed; // 上次使用时间
+    std::vector<std::string> mParams;                // 模板参数的当前值  与FilterTemplate::commands一一对应
 
 public:
     FilterGraphCacheItem(
@@ -36,22 +39,22 @@ public:
     ~FilterGraphCacheItem();
 
 private:
-    // ԻȡʹȨ
+    // 尝试获取使用权
     bool acquire();
 
-    // ͷʹȨ
+    // 释放使用权
     void release();
 
-    // Ƿ
+    // 检查是否可清理
     bool canCleanup(std::chrono::seconds timeout = std::chrono::seconds(300)) const;
 
 public:
-    // ȡʹͳ
+    // 获取使用统计
     bool isInUse() const;
     int getUseCount() const;
     auto getLastUsed() const;
 
-    // ȡ˾ͼ
+    // 获取滤镜图组件
     AVFilterGraph *getGraph() const;
     AVFilterContext *getBufferSrc() const;
     AVFilterContext *getBufferSink() const;
@@ -59,7 +62,41 @@ public:
 
 using FilterGraph = FilterGraphCacheItem;
 
-/* ˾ͼ */
+/* 滤镜图构建选项 */
+struct FilterGraphOptions
+{
+    int threadCount = 0;        // 滤镜图内线程数 0表示由libavfilter决定
+    bool allowFastPath = false; // processFrame优先尝试原生快速路径 无法识别时回退到滤镜图
+                                // 输出与libswscale/vf_hue在色度采样位置、舍入与色相矩阵上有差异  须显式开启
+};
+
+/* 滤镜图池指标  耗时均为纳秒 */
+struct FilterGraphPoolMetrics
+{
+    uint64_t hits = 0;            // 缓存命中（含退避等待后命中）
+    uint64_t misses = 0;          // 缓存未命中
+    uint64_t builds = 0;          // 构建滤镜图的次数
+    uint64_t buildFailures = 0;   // 构建失败的次数
+    uint64_t buildNanos = 0;      // 累计构建耗时
+    uint64_t maxBuildNanos = 0;   // 单次构建的最长耗时
+    uint64_t reparams = 0;        // 以命令修改参数代替重建的次数
+    uint64_t evictions = 0;       // 缓存已满时按最久未使用淘汰的条目数
+    uint64_t expirations = 0;     // 超时清理的条目数
+    uint64_t busyWaits = 0;       // 缓存项正被使用而进入退避等待的次数
+    uint64_t waitNanos = 0;       // 累计退避等待耗时
+    uint64_t busyRejects = 0;     // 缓存项一直被占用而返回nullptr的次数
+    uint64_t capacityRejects = 0; // 缓存已满且全部在用而返回nullptr的次数
+    uint64_t lockWaitNanos = 0;   // 累计等待池互斥锁的耗时
+    uint64_t enomem = 0;          // processFrame取不到滤镜图而返回ENOMEM的次数
+    uint64_t fastPathFrames = 0;  // 由原生快速路径处理的帧数
+    size_t cacheSize = 0;         // 当前缓存条目数
+    size_t maxSize = 0;           // 缓存条目上限
+};
+
+/* 滤镜图池
+ * 只在可修改参数值上不同的滤镜描述（如hue=h=30与hue=h=31）按结构模板共用一个滤镜图
+ * 取用时以avfilter_graph_send_command设置本次的参数值
+ */
 class FilterGraphPool
 {
 public:
@@ -69,30 +106,48 @@ public:
     FilterGraphPool(size_t maxSize = 100, std::chrono::seconds cleanupTimeout = std::chrono::seconds(300));
     ~FilterGraphPool();
 
-    // ÿ
+    // 禁用拷贝
     FilterGraphPool(FilterGraphPool const &) = delete;
     FilterGraphPool &operator=(FilterGraphPool const &) = delete;
 
 public:
-    // ȡ˾ͼ  ڱʹûȴ򷵻nullptr
+    // 获取滤镜图  如果正在被使用会等待或返回nullptr
     FilterGraphPtr getFilterGraph(
         AVFrame const *inputFrame,
         std::string const &filterDesc,
-        bool waitIfBusy = false);
+        bool waitIfBusy = false,
+        FilterGraphOptions const &options = {});
 
-    // ֡  򵥴
+    // 处理帧  简单处理
     int processFrame(
         AVFrame *inputFrame,
         std::string const &filterDesc,
+        AVFrame **outputFrame,
+        FilterGraphOptions const &options = {});
+
+    // 使用已获取的滤镜图处理一帧  连续多帧可复用同一个滤镜图
+    // 滤镜暂未输出帧时返回AVERROR(EAGAIN)
+    int processFrame(
+        FilterGraphPtr const &filterGraph,
+        AVFrame *inputFrame,
         AVFrame **outputFrame);
 
-    // ʱδʹõ˾ͼ
+    // 归还getFilterGraph获取的滤镜图
+    void releaseFilterGraph(FilterGraphPtr &filterGraph);
+
+    // 清理长时间未使用的滤镜图
     size_t cleanupUnused();
 
-    // ǿл
+    // 指标快照  各计数器独立读取  相互之间不保证严格一致
+    FilterGraphPoolMetrics getMetrics() const;
+
+    // 计数器清零  缓存内容不受影响
+    void resetMetrics();
+
+    // 强制清理所有缓存
     void clear();
 
-    // ȡͳϢ
+    // 获取缓存统计信息
     size_t getCacheSize() const;
     size_t getMaxSize() const;
     bool setMaxSize(size_t maxSize);
@@ -100,7 +155,7 @@ public:
     void setCleanupTimeout(std::chrono::seconds timeout);
     std::chrono::seconds getCleanupTimeout() const;
 
-    // ӡ״̬ã
+    // 打印缓存状态（调试用）
     void printCacheStatus() const;
 
 private:
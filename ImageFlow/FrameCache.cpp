@@ -0,0 +1,161 @@
+#include "FrameCache.h"
+//--------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+//--------------------------
+extern "C"
+{
+#include <libavutil/buffer.h>
+#include <libavutil/mem.h>
+#include <libavutil/sha.h>
+}
+
+using namespace ImageFlow;
+
+FrameCache::FrameCache(int64_t budget)
+    : mBudget(std::max<int64_t>(budget, 0))
+{
+    mStats.budget = mBudget;
+}
+
+FrameCache::~FrameCache()
+{
+    clear();
+}
+
+bool FrameCache::makeFileKey(std::string const &path, std::string &key)
+{
+    // 文件被覆盖写入后修改时间或大小随之变化  旧条目自然失效并被淘汰
+    std::error_code ec;
+    std::filesystem::path filePath{path};
+    auto size = std::filesystem::file_size(filePath, ec);
+    if (ec)
+        return false;
+    auto mtime = std::filesystem::last_write_time(filePath, ec);
+    if (ec)
+        return false;
+
+    key = "file:" + std::filesystem::absolute(filePath, ec).string() +
+          "|" + std::to_string(mtime.time_since_epoch().count()) +
+          "|" + std::to_string(size);
+    return true;
+}
+
+std::string FrameCache::makeMemoryKey(uint8_t const *data, size_t size)
+{
+    // 内容来自客户端  使用SHA-256  无法构造碰撞让不同的输入命中同一条目
+    uint8_t digest[32];
+    auto sha = av_sha_alloc();
+    if (!sha)
+        return {};
+    av_sha_init(sha, 256);
+    av_sha_update(sha, data, size);
+    av_sha_final(sha, digest);
+    av_free(sha);
+
+    std::string key = "mem:";
+    char hex[3];
+    for (uint8_t byte : digest)
+    {
+        snprintf(hex, sizeof(hex), "%02x", byte);
+        key += hex;
+    }
+    return key + "|" + std::to_string(size);
+}
+
+bool FrameCache::isEnabled() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mBudget > 0;
+}
+
+void FrameCache::setBudget(int64_t budget)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    mBudget = std::max<int64_t>(budget, 0);
+    mStats.budget = mBudget;
+    evictLocked(mBudget);
+}
+
+AVFrame *FrameCache::get(std::string const &key)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    auto it = mIndex.find(key);
+    if (it == mIndex.end())
+    {
+        ++mStats.misses;
+        return nullptr;
+    }
+
+    // 移到表头  只增加引用计数
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+    auto frame = av_frame_clone(it->second->frame);
+    if (!frame)
+        return nullptr;
+    ++mStats.hits;
+    mStats.bytesSaved += it->second->bytes;
+    return frame;
+}
+
+bool FrameCache::contains(std::string const &key) const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mIndex.contains(key);
+}
+
+void FrameCache::put(std::string const &key, AVFrame const *frame)
+{
+    int64_t bytes = frameBytes(frame);
+    std::lock_guard<std::mutex> _(mMutex);
+    if (bytes <= 0 || bytes > mBudget || mIndex.contains(key))
+        return;
+
+    auto ref = av_frame_clone(frame);
+    if (!ref)
+        return;
+
+    evictLocked(mBudget - bytes);
+    mEntries.push_front({key, ref, bytes});
+    mIndex[key] = mEntries.begin();
+    mStats.bytes += bytes;
+    ++mStats.insertions;
+}
+
+void FrameCache::clear()
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    evictLocked(0);
+}
+
+FrameCache::Stats FrameCache::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    auto stats = mStats;
+    stats.entries = mEntries.size();
+    return stats;
+}
+
+void FrameCache::evictLocked(int64_t budget)
+{
+    while (!mEntries.empty() && mStats.bytes > budget)
+    {
+        auto &entry = mEntries.back();
+        mStats.bytes -= entry.bytes;
+        ++mStats.evictions;
+        av_frame_free(&entry.frame);
+        mIndex.erase(entry.key);
+        mEntries.pop_back();
+    }
+}
+
+int64_t FrameCache::frameBytes(AVFrame const *frame)
+{
+    // 以实际持有的缓冲大小计量  包含行对齐的填充
+    int64_t bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i]; ++i)
+        bytes += static_cast<int64_t>(frame->buf[i]->size);
+    return bytes;
+}
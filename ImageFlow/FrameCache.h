@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+//--------------------------
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+namespace ImageFlow
+{
+
+/* 解码帧缓存
+ * 按输入标识（路径+修改时间+大小  或内容哈希）缓存解码后的帧  按总字节数做LRU淘汰
+ * 命中时返回共享像素缓冲的新引用  不复制像素  使用者不得原地修改返回的帧
+ */
+class FrameCache
+{
+public:
+    /* 缓存统计 */
+    struct Stats
+    {
+        int64_t budget = 0;     // 字节预算
+        int64_t bytes = 0;      // 当前缓存的字节数
+        size_t entries = 0;     // 当前条目数
+        size_t hits = 0;        // 命中次数
+        size_t misses = 0;      // 未命中次数
+        size_t insertions = 0;  // 插入次数
+        size_t evictions = 0;   // 淘汰次数
+        int64_t bytesSaved = 0; // 命中而免于解码的字节数
+    };
+
+private:
+    /* 缓存条目 */
+    struct Entry
+    {
+        std::string key; // 输入标识
+        AVFrame *frame;  // 缓存持有的帧引用
+        int64_t bytes;   // 帧缓冲的字节数
+    };
+
+    using EntryList = std::list<Entry>;
+
+private:
+    mutable std::mutex mMutex;                                   // 保护以下状态
+    int64_t mBudget;                                             // 字节预算 0表示关闭
+    EntryList mEntries;                                          // 按最近使用排序 表头最新
+    std::unordered_map<std::string, EntryList::iterator> mIndex; // 键到条目的索引
+    Stats mStats;                                                // 统计
+
+public:
+    explicit FrameCache(int64_t budget = 0);
+    ~FrameCache();
+
+    FrameCache(FrameCache const &) = delete;
+    FrameCache &operator=(FrameCache const &) = delete;
+
+public:
+    // 文件输入的标识  文件不存在时返回false
+    static bool makeFileKey(std::string const &path, std::string &key);
+
+    // 内存输入的标识（SHA-256内容哈希与长度）  无法计算时返回空串  即不缓存
+    static std::string makeMemoryKey(uint8_t const *data, size_t size);
+
+    bool isEnabled() const;
+
+    // 设置字节预算 0表示关闭并清空
+    void setBudget(int64_t budget);
+
+    // 查找  命中时返回帧的新引用（由调用者释放）  未命中返回nullptr
+    AVFrame *get(std::string const &key);
+
+    // 是否已缓存  不计入命中统计  也不调整淘汰顺序
+    bool contains(std::string const &key) const;
+
+    // 插入帧的一个引用  超出预算的单帧不缓存
+    void put(std::string const &key, AVFrame const *frame);
+
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    // 淘汰最久未使用的条目直到不超过预算  调用时持有mMutex
+    void evictLocked(int64_t budget);
+
+    static int64_t frameBytes(AVFrame const *frame);
+};
+
+} // namespace ImageFlow
@@ -0,0 +1,372 @@
+#include "FrameReader.h"
+//--------------------------
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/codec.h>
+#include <libavcodec/codec_par.h>
+#include <libavcodec/packet.h>
+#include <libavutil/dict.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+constexpr int kIoBufferSize = 64 * 1024; // 自定义IO的缓冲区大小
+
+int readMemory(void *opaque, uint8_t *buf, int bufSize)
+{
+    auto input = static_cast<FrameReader::MemoryInput *>(opaque);
+    size_t remaining = input->size - input->pos;
+    if (remaining == 0)
+        return AVERROR_EOF;
+    size_t count = std::min(remaining, static_cast<size_t>(bufSize));
+    memcpy(buf, input->data + input->pos, count);
+    input->pos += count;
+    return static_cast<int>(count);
+}
+
+int64_t seekMemory(void *opaque, int64_t offset, int whence)
+{
+    auto input = static_cast<FrameReader::MemoryInput *>(opaque);
+    if (whence == AVSEEK_SIZE)
+        return static_cast<int64_t>(input->size);
+
+    int64_t base = 0;
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        base = static_cast<int64_t>(input->pos);
+        break;
+    case SEEK_END:
+        base = static_cast<int64_t>(input->size);
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    int64_t pos = base + offset;
+    if (pos < 0 || pos > static_cast<int64_t>(input->size))
+        return AVERROR(EINVAL);
+    input->pos = static_cast<size_t>(pos);
+    return pos;
+}
+
+// TIFF的页数  沿IFD链计数  文件头无效时返回0
+int countTiffPages(uint8_t const *data, size_t size)
+{
+    if (size < 8)
+        return 0;
+    bool little = memcmp(data, "II", 2) == 0;
+    if (!little && memcmp(data, "MM", 2) != 0)
+        return 0;
+    auto u16 = [&](size_t offset)
+    {
+        auto p = data + offset;
+        return little ? static_cast<uint32_t>(p[0] | (p[1] << 8))
+                      : static_cast<uint32_t>((p[0] << 8) | p[1]);
+    };
+    auto u32 = [&](size_t offset)
+    {
+        auto p = data + offset;
+        return little ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+                      : (uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]));
+    };
+    if (u16(2) != 42)
+        return 0;
+
+    // 每个IFD至少占6字节  以此限制计数  避免环形链表
+    int pages = 0;
+    size_t ifd = u32(4);
+    while (ifd != 0 && ifd + 2 <= size && pages < static_cast<int>(size / 6))
+    {
+        ++pages;
+        size_t next = ifd + 2 + static_cast<size_t>(u16(ifd)) * 12;
+        if (next + 4 > size)
+            break;
+        ifd = u32(next);
+    }
+    return pages;
+}
+
+} // namespace
+
+FrameReader::~FrameReader()
+{
+    close();
+}
+
+bool FrameReader::open(std::string const &inputPath)
+{
+    close();
+
+    // 打开输入文件
+    auto utf8Filename = Utils::localToUtf8(inputPath);
+    if (avformat_open_input(&mFormatCtx, utf8Filename.c_str(), nullptr, nullptr) < 0)
+    {
+        std::cerr << "无法打开输入文件：" << inputPath << std::endl;
+        return false;
+    }
+
+    // 查找流信息
+    if (avformat_find_stream_info(mFormatCtx, nullptr) < 0)
+    {
+        std::cerr << "找不到流信息" << std::endl;
+        return false;
+    }
+    return findVideoStream();
+}
+
+bool FrameReader::openMemory(uint8_t const *data, size_t size)
+{
+    close();
+    if (!data || size == 0)
+        return false;
+
+    mMemory = MemoryInput{data, size, 0};
+    auto buffer = static_cast<unsigned char *>(av_malloc(kIoBufferSize));
+    if (!buffer)
+        return false;
+    mIoCtx = avio_alloc_context(buffer, kIoBufferSize, 0, &mMemory, readMemory, nullptr, seekMemory);
+    if (!mIoCtx)
+    {
+        av_free(buffer);
+        return false;
+    }
+
+    // 使用自定义IO时由调用者负责释放pb
+    if (!(mFormatCtx = avformat_alloc_context()))
+        return false;
+    mFormatCtx->pb = mIoCtx;
+    mFormatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    if (avformat_open_input(&mFormatCtx, nullptr, nullptr, nullptr) < 0)
+    {
+        std::cerr << "无法从内存打开输入" << std::endl;
+        return false;
+    }
+
+    if (avformat_find_stream_info(mFormatCtx, nullptr) < 0)
+    {
+        std::cerr << "找不到流信息" << std::endl;
+        return false;
+    }
+    return findVideoStream();
+}
+
+bool FrameReader::findVideoStream()
+{
+    // 查找视频流  图片也按视频流处理
+    for (unsigned int i = 0; i < mFormatCtx->nb_streams; i++)
+    {
+        if (mFormatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        {
+            mStreamIdx = static_cast<int>(i);
+            break;
+        }
+    }
+    if (mStreamIdx == -1)
+    {
+        std::cerr << "找不到视频流" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool FrameReader::openDecoder(int threadCount)
+{
+    if (mStreamIdx < 0)
+        return false;
+
+    mThreadCount = threadCount;
+    mPage = 1;
+    mPageCount = 1;
+    if (!(mPacket = av_packet_alloc()))
+        return false;
+    return createDecoder();
+}
+
+AVFrame *FrameReader::next()
+{
+    if (!mCodecCtx)
+        return nullptr;
+
+    auto frame = av_frame_alloc();
+    if (!frame)
+    {
+        std::cerr << "无法分配 AVFrame" << std::endl;
+        return nullptr;
+    }
+
+    while (true)
+    {
+        int ret = avcodec_receive_frame(mCodecCtx, frame);
+        if (ret == 0)
+        {
+            // 按显示时间排序的时间戳  缺失时按帧时长顺延
+            int64_t pts = frame->best_effort_timestamp;
+            if (pts == AV_NOPTS_VALUE)
+                pts = mNextPts;
+            frame->pts = pts;
+            mNextPts = pts + (frame->duration > 0 ? frame->duration : 1);
+            return frame;
+        }
+        if (ret == AVERROR_EOF)
+        {
+            // 当前解码器已读完  多页TIFF继续解码下一页
+            if (nextPage())
+                continue;
+            break;
+        }
+        if (ret != AVERROR(EAGAIN) || mDraining)
+            break;
+
+        // 解码器需要更多数据
+        if (av_read_frame(mFormatCtx, mPacket) < 0)
+        {
+            avcodec_send_packet(mCodecCtx, nullptr);
+            mDraining = true;
+            continue;
+        }
+        if (mPacket->stream_index == mStreamIdx)
+        {
+            // TIFF的所有页都在同一个数据包中  保留一份用于切页
+            if (mCodecCtx->codec_id == AV_CODEC_ID_TIFF && !mPagePacket &&
+                (mPageCount = countTiffPages(mPacket->data, mPacket->size)) > 1)
+                mPagePacket = av_packet_clone(mPacket);
+            avcodec_send_packet(mCodecCtx, mPacket); // 损坏的包直接跳过
+        }
+        av_packet_unref(mPacket);
+    }
+
+    av_frame_free(&frame);
+    return nullptr;
+}
+
+int FrameReader::width() const
+{
+    return mStreamIdx < 0 ? 0 : mFormatCtx->streams[mStreamIdx]->codecpar->width;
+}
+
+int FrameReader::height() const
+{
+    return mStreamIdx < 0 ? 0 : mFormatCtx->streams[mStreamIdx]->codecpar->height;
+}
+
+AVCodecID FrameReader::codecId() const
+{
+    return mStreamIdx < 0 ? AV_CODEC_ID_NONE : mFormatCtx->streams[mStreamIdx]->codecpar->codec_id;
+}
+
+AVRational FrameReader::timeBase() const
+{
+    return mStreamIdx < 0 ? AVRational{1, 1} : mFormatCtx->streams[mStreamIdx]->time_base;
+}
+
+bool FrameReader::isSingleFrame() const
+{
+    if (mStreamIdx < 0)
+        return false;
+    auto stream = mFormatCtx->streams[mStreamIdx];
+    if (stream->nb_frames == 1)
+        return true;
+    switch (stream->codecpar->codec_id)
+    {
+    case AV_CODEC_ID_MJPEG:
+    case AV_CODEC_ID_PNG: // 动态PNG为AV_CODEC_ID_APNG
+    case AV_CODEC_ID_BMP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FrameReader::nextPage()
+{
+    // 按文件中的页数切页  不依赖解码器在超出页数时报错
+    if (!mPagePacket || mPage >= mPageCount)
+        return false;
+
+    // tiff解码器通过page选项选择页
+    ++mPage;
+    avcodec_free_context(&mCodecCtx);
+    if (!createDecoder())
+        return false;
+    if (avcodec_send_packet(mCodecCtx, mPagePacket) < 0)
+        return false;
+    avcodec_send_packet(mCodecCtx, nullptr);
+    mDraining = true;
+    return true;
+}
+
+bool FrameReader::createDecoder()
+{
+    // 获取解码器
+    AVCodecParameters *codecpar = mFormatCtx->streams[mStreamIdx]->codecpar;
+    auto codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec)
+    {
+        std::cerr << "不支持的编解码器" << std::endl;
+        return false;
+    }
+
+    // 创建解码器上下文
+    if (!(mCodecCtx = avcodec_alloc_context3(codec)))
+    {
+        std::cerr << "无法分配解码器上下文" << std::endl;
+        return false;
+    }
+    if (avcodec_parameters_to_context(mCodecCtx, codecpar) < 0)
+    {
+        std::cerr << "无法拷贝编解码器参数" << std::endl;
+        return false;
+    }
+    // 图像只使用slice线程  帧线程会引入解码延迟
+    mCodecCtx->thread_count = mThreadCount;
+    mCodecCtx->thread_type = FF_THREAD_SLICE;
+
+    AVDictionary *opts = nullptr;
+    if (mPage > 1)
+        av_dict_set_int(&opts, "page", mPage, 0);
+    // 打开解码器
+    int ret = avcodec_open2(mCodecCtx, codec, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+    {
+        std::cerr << "无法打开编解码器" << std::endl;
+        return false;
+    }
+    mDraining = false;
+    return true;
+}
+
+void FrameReader::close()
+{
+    if (mFormatCtx)
+        avformat_close_input(&mFormatCtx);
+    if (mCodecCtx)
+        avcodec_free_context(&mCodecCtx);
+    if (mPacket)
+        av_packet_free(&mPacket);
+    if (mPagePacket)
+        av_packet_free(&mPagePacket);
+    if (mIoCtx)
+    {
+        av_freep(&mIoCtx->buffer);
+        avio_context_free(&mIoCtx);
+    }
+    mMemory = MemoryInput{};
+    mStreamIdx = -1;
+    mDraining = false;
+    mNextPts = 0;
+}
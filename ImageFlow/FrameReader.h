@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+}
+
+namespace ImageFlow
+{
+
+/* 帧读取器
+ * 逐帧解码图像文件  单帧图片、动图（GIF、WebP）与多页TIFF使用同一接口
+ * 任意时刻只持有解码器内部缓冲  由调用者决定每次保留多少帧
+ */
+class FrameReader
+{
+public:
+    /* 内存输入 */
+    struct MemoryInput
+    {
+        uint8_t const *data = nullptr; // 图像数据（由调用者持有）
+        size_t size = 0;               // 数据长度
+        size_t pos = 0;                // 读取位置
+    };
+
+private:
+    AVFormatContext *mFormatCtx = nullptr; // 解封装上下文
+    AVIOContext *mIoCtx = nullptr;         // 内存输入的自定义IO
+    AVCodecContext *mCodecCtx = nullptr;   // 解码器上下文
+    AVPacket *mPacket = nullptr;           // 读包缓冲
+    AVPacket *mPagePacket = nullptr;       // 多页TIFF的整文件数据包  切页时重新送入解码器
+    int mStreamIdx = -1;                   // 视频流索引
+    int mThreadCount = 1;                  // 解码线程数
+    int mPage = 1;                         // 当前TIFF页号（从1开始）
+    int mPageCount = 1;                    // TIFF页数
+    bool mDraining = false;                // 已送入空包冲刷解码器
+    int64_t mNextPts = 0;                  // 缺少时间戳时推算的下一帧时间戳
+    MemoryInput mMemory;                   // 内存输入的读取状态
+
+public:
+    FrameReader() = default;
+    ~FrameReader();
+
+    FrameReader(FrameReader const &) = delete;
+    FrameReader &operator=(FrameReader const &) = delete;
+
+public:
+    // 打开文件并查找视频流
+    bool open(std::string const &inputPath);
+
+    // 从内存打开  data在读取器关闭前必须保持有效
+    bool openMemory(uint8_t const *data, size_t size);
+
+    // 打开解码器  在open之后调用  可先根据width/height决定线程数
+    bool openDecoder(int threadCount);
+
+    // 解码下一帧  pts已换算为timeBase()下的显示时间
+    // 返回nullptr表示读完或出错  返回的帧由调用者释放
+    AVFrame *next();
+
+    int width() const;
+    int height() const;
+
+    // 输入的编码格式  打开后即可取得
+    AVCodecID codecId() const;
+
+    // 帧时间戳的时间基
+    AVRational timeBase() const;
+
+    // 确定只有一帧（流报告的帧数为1  或编码格式不支持多帧）  无法确定时返回false
+    bool isSingleFrame() const;
+
+private:
+    // 多页TIFF切换到下一页
+    bool nextPage();
+
+    // 查找视频流
+    bool findVideoStream();
+
+    // 按当前页号创建并打开解码器
+    bool createDecoder();
+
+    void close();
+};
+
+} // namespace ImageFlow
@@ -0,0 +1,328 @@
+#include "FrameSequenceWriter.h"
+//--------------------------
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/codec.h>
+#include <libavcodec/packet.h>
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+}
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+FrameSequenceWriter::~FrameSequenceWriter()
+{
+    release();
+}
+
+bool FrameSequenceWriter::isAnimatedFormat(std::string const &format)
+{
+    return ImageEncoder::animatedEncoderName(format) != nullptr;
+}
+
+void FrameSequenceWriter::open(
+    std::string const &outputPath,
+    std::string const &format,
+    AVRational timeBase,
+    EncoderOptions const &options,
+    int threadCount,
+    OutputCommitter *committer)
+{
+    release();
+    mCommitter = committer;
+    mOutputPath = outputPath;
+    mFormat = format;
+    mTimeBase = timeBase.num > 0 && timeBase.den > 0 ? timeBase : AVRational{1, 100};
+    mOptions = options;
+    mThreadCount = std::max(threadCount, 1);
+    mFrameCount = 0;
+    mLastPts = AV_NOPTS_VALUE;
+    mBytesWritten = 0;
+}
+
+int FrameSequenceWriter::write(AVFrame const *frame)
+{
+    if (!frame)
+        return AVERROR(EINVAL);
+
+    int ret = isAnimatedFormat(mFormat) ? writeAnimated(frame) : writePage(frame);
+    if (ret >= 0)
+        ++mFrameCount;
+    return ret;
+}
+
+int FrameSequenceWriter::close()
+{
+    int ret = 0;
+    if (mCodecCtx && mFormatCtx)
+    {
+        // 先冲刷量化器  再冲刷编码器中缓存的帧
+        if (mQuantizer && (ret = mQuantizer->send(nullptr)) >= 0)
+            ret = drainQuantizer();
+        avcodec_send_frame(mCodecCtx, nullptr);
+        int drained = drainPackets();
+        if (ret >= 0)
+            ret = drained;
+        int trailer = av_write_trailer(mFormatCtx);
+        if (ret >= 0)
+            ret = trailer;
+        if (mFormatCtx->pb)
+            mBytesWritten += avio_tell(mFormatCtx->pb);
+    }
+
+    // 先关闭文件  再决定提交还是删除临时文件
+    auto tempPath = std::move(mTempPath);
+    mTempPath.clear();
+    release();
+    if (!tempPath.empty())
+    {
+        std::error_code ec;
+        if (ret < 0)
+            std::filesystem::remove(tempPath, ec);
+        else if (!mCommitter->commit(tempPath, mOutputPath))
+            ret = AVERROR(EIO);
+    }
+    return ret;
+}
+
+int64_t FrameSequenceWriter::getFrameCount() const
+{
+    return mFrameCount;
+}
+
+int64_t FrameSequenceWriter::getBytesWritten() const
+{
+    return mBytesWritten;
+}
+
+int FrameSequenceWriter::openAnimated(AVFrame const *frame)
+{
+    const char *codecName = ImageEncoder::animatedEncoderName(mFormat);
+    auto codec = avcodec_find_encoder_by_name(codecName);
+    if (!codec)
+    {
+        std::cerr << "未找到编解码器：" << codecName << std::endl;
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    // 封装格式与输出格式同名（gif、webp）
+    auto utf8Path = Utils::localToUtf8(mOutputPath);
+    int ret = avformat_alloc_output_context2(&mFormatCtx, nullptr, mFormat.c_str(), utf8Path.c_str());
+    if (ret < 0)
+        return ret;
+
+    if (!(mCodecCtx = avcodec_alloc_context3(codec)))
+        return AVERROR(ENOMEM);
+
+    // 编码器沿用输入流的时间基  帧间延时由时间戳差值决定
+    mCodecCtx->width = frame->width;
+    mCodecCtx->height = frame->height;
+    mCodecCtx->time_base = mTimeBase;
+    mCodecCtx->thread_count = mThreadCount;
+    mCodecCtx->thread_type = FF_THREAD_SLICE;
+    mCodecCtx->pix_fmt = ImageEncoder::encoderPixelFormat(
+        codecName, static_cast<AVPixelFormat>(frame->format), mOptions);
+    ImageEncoder::applyOptions(mCodecCtx, codecName, mOptions);
+    if (mFormatCtx->oformat->flags & AVFMT_GLOBALHEADER)
+        mCodecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if ((ret = avcodec_open2(mCodecCtx, codec, nullptr)) < 0)
+    {
+        std::cerr << "无法打开输出编解码器" << std::endl;
+        return ret;
+    }
+    if (mCodecCtx->pix_fmt == AV_PIX_FMT_PAL8)
+        mQuantizer = std::make_unique<PaletteQuantizer>(mTimeBase);
+
+    auto stream = avformat_new_stream(mFormatCtx, nullptr);
+    if (!stream)
+        return AVERROR(ENOMEM);
+    stream->time_base = mCodecCtx->time_base;
+    if ((ret = avcodec_parameters_from_context(stream->codecpar, mCodecCtx)) < 0)
+        return ret;
+
+    if (mCommitter && !(mFormatCtx->oformat->flags & AVFMT_NOFILE))
+    {
+        mTempPath = OutputCommitter::makeTempPath(mOutputPath);
+        utf8Path = Utils::localToUtf8(mTempPath);
+    }
+    if (!(mFormatCtx->oformat->flags & AVFMT_NOFILE) &&
+        (ret = avio_open(&mFormatCtx->pb, utf8Path.c_str(), AVIO_FLAG_WRITE)) < 0)
+    {
+        std::cerr << "无法打开输出文件：" << mOutputPath << std::endl;
+        return ret;
+    }
+    if ((ret = avformat_write_header(mFormatCtx, nullptr)) < 0)
+        return ret;
+
+    if (!(mPacket = av_packet_alloc()))
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
+int FrameSequenceWriter::writeAnimated(AVFrame const *frame)
+{
+    int ret = 0;
+    if (!mCodecCtx && (ret = openAnimated(frame)) < 0)
+    {
+        release();
+        return ret;
+    }
+
+    // 转换为编码器（GIF为量化器）的像素格式与尺寸  转换上下文按需重建
+    auto targetFmt = mQuantizer ? PaletteQuantizer::kInputFormat : mCodecCtx->pix_fmt;
+    AVFrame const *frameToEncode = frame;
+    if (frame->format != targetFmt ||
+        frame->width != mCodecCtx->width ||
+        frame->height != mCodecCtx->height)
+    {
+        mSwsCtx = sws_getCachedContext(
+            mSwsCtx,
+            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+            mCodecCtx->width, mCodecCtx->height, targetFmt,
+            SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!mSwsCtx)
+        {
+            std::cerr << "无法创建转换上下文" << std::endl;
+            return AVERROR(EINVAL);
+        }
+        if (!mConverted)
+        {
+            if (!(mConverted = av_frame_alloc()))
+                return AVERROR(ENOMEM);
+            mConverted->format = targetFmt;
+            mConverted->width = mCodecCtx->width;
+            mConverted->height = mCodecCtx->height;
+            if ((ret = av_frame_get_buffer(mConverted, 0)) < 0)
+                return ret;
+        }
+        // 编码器可能仍引用上一帧的缓冲
+        if ((ret = av_frame_make_writable(mConverted)) < 0)
+            return ret;
+        sws_scale(mSwsCtx,
+                  frame->data, frame->linesize, 0, frame->height,
+                  mConverted->data, mConverted->linesize);
+        av_frame_copy_props(mConverted, frame);
+        frameToEncode = mConverted;
+    }
+
+    // 编码器要求时间戳严格递增
+    int64_t pts = frame->pts;
+    if (pts == AV_NOPTS_VALUE || (mLastPts != AV_NOPTS_VALUE && pts <= mLastPts))
+        pts = mLastPts == AV_NOPTS_VALUE ? 0 : mLastPts + 1;
+    mLastPts = pts;
+
+    AVFrame *timed = av_frame_clone(frameToEncode);
+    if (!timed)
+        return AVERROR(ENOMEM);
+    timed->pts = pts;
+    if (mQuantizer)
+    {
+        ret = mQuantizer->send(timed);
+        av_frame_free(&timed);
+        return ret < 0 ? ret : drainQuantizer();
+    }
+    ret = avcodec_send_frame(mCodecCtx, timed);
+    av_frame_free(&timed);
+    if (ret < 0)
+    {
+        std::cerr << "向编码器发送帧时出错" << std::endl;
+        return ret;
+    }
+    return drainPackets();
+}
+
+int FrameSequenceWriter::writePage(AVFrame const *frame)
+{
+    std::vector<uint8_t> encoded;
+    int ret = ImageEncoder::encode(frame, mFormat, mOptions, mThreadCount, encoded);
+    if (ret < 0)
+        return ret;
+
+    // <文件名>_0001.<格式>
+    std::filesystem::path path{mOutputPath};
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "_%04lld", static_cast<long long>(mFrameCount + 1));
+    auto pagePath = path.parent_path() / (path.stem().string() + suffix + path.extension().string());
+    bool written = mCommitter ? mCommitter->write(pagePath.string(), encoded.data(), encoded.size())
+                              : Utils::writeFile(pagePath.string(), encoded.data(), encoded.size());
+    if (!written)
+        return AVERROR(EIO);
+    mBytesWritten += static_cast<int64_t>(encoded.size());
+    return 0;
+}
+
+int FrameSequenceWriter::drainQuantizer()
+{
+    AVFrame *quantized = av_frame_alloc();
+    if (!quantized)
+        return AVERROR(ENOMEM);
+
+    int ret = 0;
+    while ((ret = mQuantizer->receive(quantized)) >= 0)
+    {
+        ret = avcodec_send_frame(mCodecCtx, quantized);
+        av_frame_unref(quantized);
+        if (ret < 0 || (ret = drainPackets()) < 0)
+            break;
+    }
+    av_frame_free(&quantized);
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+int FrameSequenceWriter::drainPackets()
+{
+    int ret = 0;
+    while ((ret = avcodec_receive_packet(mCodecCtx, mPacket)) >= 0)
+    {
+        av_packet_rescale_ts(mPacket, mCodecCtx->time_base, mFormatCtx->streams[0]->time_base);
+        mPacket->stream_index = 0;
+        if ((ret = av_interleaved_write_frame(mFormatCtx, mPacket)) < 0)
+        {
+            av_packet_unref(mPacket);
+            return ret;
+        }
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+void FrameSequenceWriter::release()
+{
+    if (mFormatCtx)
+    {
+        if (mFormatCtx->pb && !(mFormatCtx->oformat->flags & AVFMT_NOFILE))
+            avio_closep(&mFormatCtx->pb);
+        avformat_free_context(mFormatCtx);
+        mFormatCtx = nullptr;
+    }
+    if (mCodecCtx)
+        avcodec_free_context(&mCodecCtx);
+    if (mSwsCtx)
+    {
+        sws_freeContext(mSwsCtx);
+        mSwsCtx = nullptr;
+    }
+    if (mConverted)
+        av_frame_free(&mConverted);
+    mQuantizer.reset();
+    if (mPacket)
+        av_packet_free(&mPacket);
+
+    // 未经close提交的临时文件
+    if (!mTempPath.empty())
+    {
+        std::error_code ec;
+        std::filesystem::remove(mTempPath, ec);
+        mTempPath.clear();
+    }
+}
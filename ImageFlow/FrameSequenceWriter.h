@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+//--------------------------
+#include "ImageEncoder.h"
+#include "OutputCommitter.h"
+#include "PaletteQuantizer.h"
+
+namespace ImageFlow
+{
+
+/* 帧序列写出器
+ * 逐帧增量编码  动图格式（gif、webp）写入单个动图文件
+ * 其余格式按页写出 <文件名>_0001.<格式>  不在内存中累积帧
+ * 指定OutputCommitter时各文件先写临时文件  动图在close成功后才改名为最终文件名
+ */
+class FrameSequenceWriter
+{
+private:
+    std::string mOutputPath;                      // 输出路径（按页写出时作为文件名模板）
+    std::string mFormat;                          // 输出格式
+    AVRational mTimeBase{1, 1};                   // 输入帧时间戳的时间基
+    EncoderOptions mOptions;                      // 编码参数
+    int mThreadCount = 1;                         // 编码线程数
+    AVFormatContext *mFormatCtx = nullptr;        // 动图封装上下文
+    AVCodecContext *mCodecCtx = nullptr;          // 动图编码器上下文
+    SwsContext *mSwsCtx = nullptr;                // 像素格式转换
+    AVFrame *mConverted = nullptr;                // 转换后的帧
+    std::unique_ptr<PaletteQuantizer> mQuantizer; // GIF调色板量化
+    AVPacket *mPacket = nullptr;                  // 编码输出包
+    int64_t mFrameCount = 0;                      // 已写出帧数
+    int64_t mLastPts = AV_NOPTS_VALUE;            // 上一帧时间戳  保证单调递增
+    int64_t mBytesWritten = 0;                    // 已写出字节数（动图在close后计入）
+    OutputCommitter *mCommitter = nullptr;        // 输出提交 为空时直接写最终文件
+    std::string mTempPath;                        // 动图的临时文件  提交前为非空
+
+public:
+    FrameSequenceWriter() = default;
+    ~FrameSequenceWriter();
+
+    FrameSequenceWriter(FrameSequenceWriter const &) = delete;
+    FrameSequenceWriter &operator=(FrameSequenceWriter const &) = delete;
+
+public:
+    // 是否以单个动图文件输出
+    static bool isAnimatedFormat(std::string const &format);
+
+    // 设置输出  编码器在写入第一帧时按帧尺寸创建
+    void open(
+        std::string const &outputPath,
+        std::string const &format,
+        AVRational timeBase,
+        EncoderOptions const &options,
+        int threadCount,
+        OutputCommitter *committer = nullptr);
+
+    // 编码并写出一帧  frame->pts为timeBase下的时间戳
+    int write(AVFrame const *frame);
+
+    // 冲刷编码器并写入文件尾  成功时提交动图文件  失败时删除
+    int close();
+
+    int64_t getFrameCount() const;
+
+    int64_t getBytesWritten() const;
+
+private:
+    int openAnimated(AVFrame const *frame);
+    int writeAnimated(AVFrame const *frame);
+    int writePage(AVFrame const *frame);
+
+    // 取出量化器中所有可用的帧送入编码器
+    int drainQuantizer();
+
+    // 取出编码器中所有可用的包写入文件
+    int drainPackets();
+
+    void release();
+};
+
+} // namespace ImageFlow
@@ -0,0 +1,303 @@
+#include "ImageEncoder.h"
+//--------------------------
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavcodec/codec.h>
+#include <libavcodec/packet.h>
+#include <libavutil/error.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+//--------------------------
+#include "Defer.hpp"
+#include "PaletteQuantizer.h"
+#include "Tracer.h"
+
+using namespace ImageFlow;
+
+EncoderOptions ImageEncoder::fromPreset(EncodePreset preset)
+{
+    // 各预设画质相同（JPEG量化参数、WebP画质不变） 只调整熵编码与压缩力度
+    EncoderOptions options;
+    switch (preset)
+    {
+    case EncodePreset::FASTEST:
+        options.jpegOptimalHuffman = false;
+        options.pngLevel = 1;
+        options.pngPredictor = "none";
+        options.webpMethod = 0;
+        break;
+    case EncodePreset::SMALLEST:
+        options.jpegOptimalHuffman = true;
+        options.pngLevel = 9;
+        options.pngPredictor = "mixed";
+        options.webpMethod = 6;
+        break;
+    default:
+        break;
+    }
+    return options;
+}
+
+bool ImageEncoder::parsePreset(std::string_view name, EncodePreset &preset)
+{
+    if (name == "fastest")
+        preset = EncodePreset::FASTEST;
+    else if (name == "balanced")
+        preset = EncodePreset::BALANCED;
+    else if (name == "smallest")
+        preset = EncodePreset::SMALLEST;
+    else
+        return false;
+    return true;
+}
+
+const char *ImageEncoder::presetName(EncodePreset preset)
+{
+    switch (preset)
+    {
+    case EncodePreset::FASTEST:
+        return "fastest";
+    case EncodePreset::SMALLEST:
+        return "smallest";
+    default:
+        return "balanced";
+    }
+}
+
+bool ImageEncoder::isKnownFormat(std::string const &format)
+{
+    return format == "jpg" || format == "jpeg" || format == "png" ||
+           format == "bmp" || format == "webp" || format == "gif";
+}
+
+const char *ImageEncoder::encoderName(std::string const &format)
+{
+    if (format == "jpg" || format == "jpeg")
+        return "mjpeg";
+    else if (format == "bmp")
+        return "bmp";
+    else if (format == "webp")
+        return "libwebp";
+    else if (format == "gif")
+        return "gif";
+    return "png"; // 默认PNG
+}
+
+AVCodecID ImageEncoder::codecId(std::string const &format)
+{
+    if (format == "jpg" || format == "jpeg")
+        return AV_CODEC_ID_MJPEG;
+    else if (format == "bmp")
+        return AV_CODEC_ID_BMP;
+    else if (format == "webp")
+        return AV_CODEC_ID_WEBP;
+    else if (format == "gif")
+        return AV_CODEC_ID_GIF;
+    return AV_CODEC_ID_PNG;
+}
+
+const char *ImageEncoder::animatedEncoderName(std::string const &format)
+{
+    if (format == "gif")
+        return "gif";
+    else if (format == "webp")
+        return "libwebp_anim";
+    return nullptr;
+}
+
+AVPixelFormat ImageEncoder::encoderPixelFormat(
+    const char *codecName,
+    AVPixelFormat srcFmt,
+    EncoderOptions const &options)
+{
+    if (strcmp(codecName, "mjpeg") == 0)
+        return AV_PIX_FMT_YUVJ420P; // JPEG 常用格式
+    else if (strcmp(codecName, "png") == 0)
+    {
+        // 不透明的照片输出RGB  省去恒为255的透明通道
+        if (options.pngAlpha == PngAlpha::AUTO)
+        {
+            auto desc = av_pix_fmt_desc_get(srcFmt);
+            return desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA) ? AV_PIX_FMT_RGBA : AV_PIX_FMT_RGB24;
+        }
+        return options.pngAlpha == PngAlpha::RGBA ? AV_PIX_FMT_RGBA : AV_PIX_FMT_RGB24;
+    }
+    else if (strcmp(codecName, "bmp") == 0)
+        return AV_PIX_FMT_BGR24; // BMP 常用格式
+    else if (strcmp(codecName, "gif") == 0)
+        return AV_PIX_FMT_PAL8; // 由PaletteQuantizer逐帧生成调色板
+    else if (strcmp(codecName, "libwebp_anim") == 0)
+    {
+        // 动图保留透明通道（GIF源帧通常带透明）
+        auto desc = av_pix_fmt_desc_get(srcFmt);
+        return desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA) ? AV_PIX_FMT_YUVA420P : AV_PIX_FMT_YUV420P;
+    }
+    return AV_PIX_FMT_YUV420P; // 默认格式
+}
+
+void ImageEncoder::applyOptions(
+    AVCodecContext *codecCtx,
+    const char *codecName,
+    EncoderOptions const &options)
+{
+    if (strcmp(codecName, "mjpeg") == 0)
+    {
+        // 固定量化参数编码
+        int qscale = std::clamp(options.jpegQScale, 2, 31);
+        codecCtx->flags |= AV_CODEC_FLAG_QSCALE;
+        codecCtx->global_quality = FF_QP2LAMBDA * qscale;
+        codecCtx->qmin = 2;  // 最好质量
+        codecCtx->qmax = 31; // 最差质量
+        av_opt_set(codecCtx->priv_data, "huffman",
+                   options.jpegOptimalHuffman ? "optimal" : "default", 0);
+    }
+    else if (strcmp(codecName, "libwebp") == 0 || strcmp(codecName, "libwebp_anim") == 0)
+    {
+        // 压缩方法通过compression_level传给libwebp
+        float quality = std::clamp(options.webpQuality, 0.0f, 100.0f);
+        codecCtx->compression_level = std::clamp(options.webpMethod, 0, 6);
+        codecCtx->global_quality = static_cast<int>(quality * FF_QP2LAMBDA);
+        av_opt_set_int(codecCtx->priv_data, "quality", static_cast<int64_t>(quality), 0);
+    }
+    else if (strcmp(codecName, "png") == 0)
+    {
+        // 设置 PNG 压缩级别与行预测器
+        codecCtx->compression_level = std::clamp(options.pngLevel, 0, 9);
+        av_opt_set(codecCtx->priv_data, "pred", options.pngPredictor.c_str(), 0);
+    }
+}
+
+int ImageEncoder::encode(
+    AVFrame const *frame,
+    std::string const &format,
+    EncoderOptions const &options,
+    int threadCount,
+    std::vector<uint8_t> &output)
+{
+    TraceScope span("encode");
+
+    // 根据格式确定输出编码器
+    const char *codecName = encoderName(format);
+
+    auto outputCodec = avcodec_find_encoder_by_name(codecName);
+    if (!outputCodec)
+    {
+        std::cerr << "未找到编解码器：" << codecName << std::endl;
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    AVCodecContext *outputCodecCtx = avcodec_alloc_context3(outputCodec);
+    SwsContext *conversionCtx = nullptr;
+    AVFrame *convertedFrame = nullptr;
+    AVPacket *pkt = nullptr;
+    DEFER({
+        if (conversionCtx)
+            sws_freeContext(conversionCtx);
+        if (convertedFrame)
+            av_frame_free(&convertedFrame);
+        if (pkt)
+            av_packet_free(&pkt);
+        avcodec_free_context(&outputCodecCtx);
+    });
+    if (!outputCodecCtx)
+    {
+        std::cerr << "无法分配视频编解码器上下文" << std::endl;
+        return AVERROR(ENOMEM);
+    }
+
+    // 配置编码器参数
+    outputCodecCtx->width = frame->width;
+    outputCodecCtx->height = frame->height;
+    outputCodecCtx->time_base = {1, 25};
+    outputCodecCtx->thread_count = std::max(threadCount, 1);
+    outputCodecCtx->thread_type = FF_THREAD_SLICE;
+
+    // 根据编码器类型设置合适的像素格式与编码参数
+    outputCodecCtx->pix_fmt = encoderPixelFormat(
+        codecName, static_cast<AVPixelFormat>(frame->format), options);
+    applyOptions(outputCodecCtx, codecName, options);
+
+    // 打开编码器
+    int ret = avcodec_open2(outputCodecCtx, outputCodec, nullptr);
+    if (ret < 0)
+    {
+        std::cerr << "无法打开输出编解码器" << std::endl;
+        return ret;
+    }
+
+    // GIF按图像内容生成调色板并抖动  其余格式直接转换像素格式
+    if (outputCodecCtx->pix_fmt == AV_PIX_FMT_PAL8)
+    {
+        TraceScope convertSpan("quantize");
+        PaletteQuantizer quantizer;
+        if (!(convertedFrame = av_frame_alloc()))
+            return AVERROR(ENOMEM);
+        if ((ret = quantizer.send(frame)) < 0 ||
+            (ret = quantizer.send(nullptr)) < 0 ||
+            (ret = quantizer.receive(convertedFrame)) < 0)
+        {
+            std::cerr << "调色板量化失败" << std::endl;
+            return ret;
+        }
+    }
+    else if (frame->format != outputCodecCtx->pix_fmt)
+    {
+        TraceScope convertSpan("convert");
+        conversionCtx = sws_getContext(
+            frame->width, frame->height, (AVPixelFormat)frame->format,
+            outputCodecCtx->width, outputCodecCtx->height, outputCodecCtx->pix_fmt,
+            SWS_BILINEAR, nullptr, nullptr, nullptr);
+
+        if (!conversionCtx)
+        {
+            std::cerr << "无法创建转换上下文" << std::endl;
+            return AVERROR(EINVAL);
+        }
+
+        // 创建转换后的帧
+        convertedFrame = av_frame_alloc();
+        if (!convertedFrame)
+            return AVERROR(ENOMEM);
+        convertedFrame->format = outputCodecCtx->pix_fmt;
+        convertedFrame->width = outputCodecCtx->width;
+        convertedFrame->height = outputCodecCtx->height;
+
+        if ((ret = av_frame_get_buffer(convertedFrame, 0)) < 0)
+        {
+            std::cerr << "无法分配转换后的帧" << std::endl;
+            return ret;
+        }
+
+        // 执行格式转换
+        sws_scale(conversionCtx,
+                  frame->data, frame->linesize, 0, frame->height,
+                  convertedFrame->data, convertedFrame->linesize);
+    }
+
+    // 发送帧到编码器  随后发送空帧flush  确保所有包都写出
+    AVFrame const *frameToEncode = convertedFrame ? convertedFrame : frame;
+    if ((ret = avcodec_send_frame(outputCodecCtx, frameToEncode)) < 0)
+    {
+        std::cerr << "向编码器发送帧时出错" << std::endl;
+        return ret;
+    }
+    avcodec_send_frame(outputCodecCtx, nullptr);
+
+    // 接收编码后的包
+    if (!(pkt = av_packet_alloc()))
+        return AVERROR(ENOMEM);
+    while ((ret = avcodec_receive_packet(outputCodecCtx, pkt)) >= 0)
+    {
+        output.insert(output.end(), pkt->data, pkt->data + pkt->size);
+        av_packet_unref(pkt);
+    }
+    return ret == AVERROR_EOF || ret == AVERROR(EAGAIN) ? 0 : ret;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace ImageFlow
+{
+
+// 编码预设  在相同画质下取舍编码速度与输出体积
+enum class EncodePreset
+{
+    FASTEST,  // 编码最快
+    BALANCED, // 速度与体积均衡（默认）
+    SMALLEST  // 体积最小
+};
+
+// PNG输出的通道选择
+enum class PngAlpha
+{
+    AUTO, // 源图带透明通道时输出RGBA 否则输出RGB
+    RGB,
+    RGBA
+};
+
+/* 编码参数 */
+struct EncoderOptions
+{
+    // JPEG
+    int jpegQScale = 2;             // 量化参数 2~31 越小质量越高
+    bool jpegOptimalHuffman = true; // 按图像统计生成最优霍夫曼表（多一次扫描）
+
+    // PNG
+    int pngLevel = 6;                   // zlib压缩级别 0~9
+    std::string pngPredictor = "none";  // 行预测器 none/sub/up/avg/paeth/mixed
+    PngAlpha pngAlpha = PngAlpha::AUTO; // 输出通道
+
+    // WebP
+    int webpMethod = 4;        // 压缩方法 0~6 越大越慢体积越小
+    float webpQuality = 90.0f; // 画质 0~100
+
+    bool operator==(EncoderOptions const &) const = default;
+};
+
+/* 图像编码器 */
+class ImageEncoder
+{
+public:
+    // 预设对应的编码参数
+    static EncoderOptions fromPreset(EncodePreset preset);
+
+    // 解析预设名称 fastest/balanced/smallest
+    static bool parsePreset(std::string_view name, EncodePreset &preset);
+
+    static const char *presetName(EncodePreset preset);
+
+    // 支持的输出格式 jpg/jpeg/png/bmp/webp/gif
+    static bool isKnownFormat(std::string const &format);
+
+    // 根据输出格式确定编码器名称
+    static const char *encoderName(std::string const &format);
+
+    // 输出格式对应的编码格式  与输入的编码格式比较时使用
+    static AVCodecID codecId(std::string const &format);
+
+    // 动图输出格式（gif、webp）对应的编码器名称  其余格式返回nullptr
+    static const char *animatedEncoderName(std::string const &format);
+
+    // 编码器使用的像素格式  srcFmt用于判断是否保留透明通道
+    static AVPixelFormat encoderPixelFormat(
+        const char *codecName,
+        AVPixelFormat srcFmt,
+        EncoderOptions const &options);
+
+    // 按编码器类型设置编码参数  在avcodec_open2之前调用
+    static void applyOptions(
+        AVCodecContext *codecCtx,
+        const char *codecName,
+        EncoderOptions const &options);
+
+    // 将帧编码为单张图像并追加到output
+    // 成功返回0  失败返回负的错误码
+    static int encode(
+        AVFrame const *frame,
+        std::string const &format,
+        EncoderOptions const &options,
+        int threadCount,
+        std::vector<uint8_t> &output);
+};
+
+} // namespace ImageFlow
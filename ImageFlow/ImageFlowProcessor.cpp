@@ -1,10 +1,15 @@
 #include "ImageFlowProcessor.h"
 //----------------------------
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
+#include <deque>
 #include <exception>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <queue>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -18,383 +23,1330 @@ extern "C"
 #include <libavformat/avformat.h>
 #include <libavutil/error.h>
 #include <libavutil/frame.h>
-#include <libavutil/opt.h>
-#include <libswscale/swscale.h>
 }
 //----------------------------
 #include "Defer.hpp"
+#include "FilterChainPlanner.h"
 #include "FilterGraphPool.h"
+#include "FrameSequenceWriter.h"
+#include "JpegThumbnail.h"
+#include "Logger.hpp"
+#include "MetadataStripper.h"
+#include "PackFile.h"
+#include "TileProcessor.h"
+#include "Tracer.h"
 #include "Utils.h"
 
 using namespace ImageFlow;
 
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+size_t ioThreadCount(ProcessConfig const &config)
+{
+    // I/O线程大部分时间阻塞在读写上  线程数可以远多于CPU数
+    return config.ioThreads > 0 ? config.ioThreads : std::max<size_t>(Utils::cpuLimit(), 1) * 4;
+}
+
+} // namespace
+
 ImageFlowProcessor::ImageFlowProcessor(ProcessConfig const &config)
-    : mConfig(config)
+    : mConfig(config), mTileProcessor(mFilterGraphPool),
+      mOutputCommitter(config.durability, config.groupCommitFiles, config.groupCommitDelay),
+      mThreadPool(std::max<size_t>(Utils::cpuLimit(), 1), 1000, RejectPolicy::BLOCK, "ThreadPool(compute)::mQueueMutex"),
+      mIoPool(0, 1000, RejectPolicy::BLOCK, "ThreadPool(io)::mQueueMutex"),
+      mPrefetcher(mIoPool), mScheduler(mThreadPool)
 {
     mFilterDesc = toFilterDesc(mConfig);
-    if (mFilterDesc.empty())
-        throw std::exception("ĲЧ");
+    if (!isValidConfig(mConfig))
+        throw std::exception("传入的参数无效");
+
+    mMemoryBudget.setBudget(std::max<int64_t>(mConfig.memoryBudget, 0));
+    mFrameCache.setBudget(mConfig.frameCacheBytes);
+
+    if (mConfig.threadCount > 0)
+        mThreadPool.resize(mConfig.threadCount);
+    if (mConfig.autoscaleThreads)
+    {
+        // 计算任务先在调度器中排队  线程池中不超过线程数  积压以调度器的排队数为准
+        // 计算线程不做阻塞I/O  空闲时也保留初始线程数（CPU配额）  突发任务不必等待扩容
+        AutoscaleOptions options;
+        options.minThreads = mThreadPool.getThreadCount();
+        mAutoscaler = std::make_unique<ThreadPoolAutoscaler>(
+            mThreadPool, options, [this]
+            { return mScheduler.getQueuedCount(); });
+    }
+    if (!mConfig.tracePath.empty())
+        Tracer::getInstance().start(mConfig.traceEventsPerThread);
 }
 
 ImageFlowProcessor::~ImageFlowProcessor()
 {
+    // 先停止自动调整  再等异步任务走完读取、计算、写出三个阶段
+    mAutoscaler.reset();
+    {
+        std::unique_lock<std::mutex> lock(mStageMutex);
+        mStageCondition.wait(lock, [this]
+                             { return mAsyncJobs == 0; });
+    }
+    mScheduler.waitIdle();
     mThreadPool.shutdownGraceful();
+    mIoPool.shutdownGraceful();
+    if (!mConfig.tracePath.empty())
+    {
+        writeTrace();
+        Tracer::getInstance().stop();
+    }
 }
 
 int ImageFlowProcessor::processImage(
     std::string const &inputPath,
     std::string const &outputFolder)
 {
-    auto inputFrame = decodeImage(inputPath);
+    return processJob(makeImageRequest(inputPath, outputFolder)).status;
+}
+
+std::future<JobResult> ImageFlowProcessor::processImageAsync(
+    std::string const &inputPath,
+    std::string const &outputFolder)
+{
+    return processJobAsync(makeImageRequest(inputPath, outputFolder));
+}
+
+void ImageFlowProcessor::processImageAsync(
+    std::string const &inputPath,
+    std::string const &outputFolder,
+    std::function<void(JobResult &&)> callback)
+{
+    processJobAsync(makeImageRequest(inputPath, outputFolder), std::move(callback));
+}
+
+JobResult ImageFlowProcessor::processJob(JobRequest const &request)
+{
+    JobResult result;
+    result.jobId = ++mNextJobId;
+    auto begin = Clock::now();
+    result.status = executeJob(request, result);
+    result.elapsedUs = Utils::microsSince(begin);
+    return result;
+}
+
+std::future<JobResult> ImageFlowProcessor::processJobAsync(JobRequest request)
+{
+    auto promise = std::make_shared<std::promise<JobResult>>();
+    auto future = promise->get_future();
+    processJobAsync(std::move(request), [promise](JobResult &&result)
+                    { promise->set_value(std::move(result)); });
+    return future;
+}
+
+ProcessConfig const *ImageFlowProcessor::resolveConfig(
+    JobRequest const &request,
+    std::shared_ptr<ProcessConfig const> &profileConfig) const
+{
+    // 任务自带配置优先  其次为配置档  都没有时使用处理器的配置
+    if (!request.config && !request.profile.empty() &&
+        !(profileConfig = getProfile(request.profile)))
+    {
+        return nullptr;
+    }
+    ProcessConfig const &config = request.config    ? *request.config
+                                  : profileConfig ? *profileConfig
+                                                  : mConfig;
+    if (request.config && !isValidConfig(config))
+    {
+        return nullptr;
+    }
+    return &config;
+}
+
+int ImageFlowProcessor::executeJob(
+    JobRequest const &request,
+    JobResult &result,
+    StagedJob *staged)
+{
+    std::shared_ptr<ProcessConfig const> profileConfig;
+    auto resolved = resolveConfig(request, profileConfig);
+    if (!resolved)
+    {
+        return 1004;
+    }
+    ProcessConfig const &config = *resolved;
+    auto &tracer = Tracer::getInstance();
+    TraceContext trace(result.jobId);
+
+    // 输出与输入相同时直接输出源数据  预读的任务已在I/O线程中检查过
+    if (!(staged && staged->preloaded) && canPassThrough(config, request, staged))
+        return passThrough(config, request, result, staged);
+
+    // 解码帧缓存命中时跳过打开与解码
+    // 使用内嵌缩略图时不查也不放入缓存  缓存中的帧须为原图
+    FrameReader reader;
+    auto stageBegin = Clock::now();
+    std::vector<uint8_t> thumbnail;
+    bool useThumbnail = loadEmbeddedThumbnail(config, request, staged, thumbnail);
+    std::string cacheKey = useThumbnail              ? std::string{}
+                           : staged && staged->keyed ? staged->cacheKey
+                                                     : makeFrameCacheKey(request);
+    AVFrame *inputFrame = cacheKey.empty() ? nullptr : mFrameCache.get(cacheKey);
+    bool cached = inputFrame != nullptr;
+    if (useThumbnail)
+    {
+        inputFrame = decodeImage(config, reader, request, &thumbnail);
+        if (inputFrame)
+            ++mThumbnailJobs;
+    }
+    else if (!cached)
+        inputFrame = decodeImage(config, reader, request, staged && staged->preloaded ? &staged->input : nullptr);
+    result.decodeUs = Utils::microsSince(stageBegin);
+    if (inputFrame)
+        trace.setSize(inputFrame->width, inputFrame->height);
+    tracer.record("decode", stageBegin);
     if (!inputFrame)
+    {
         return 1001;
+    }
+
+    // 能读到第二帧的是动图或多页图像  转为逐帧流式处理  内存输出只处理第一帧
+    // 只缓存确认为单帧的输入  缓存中的帧因此总能代表整个输入
+    // 编码格式只能单帧时不再试读第二帧  省去一次解码
+    bool streamable = config.multiFrame && !request.outputPath.empty();
+    if (!cached && (streamable || !cacheKey.empty()))
+    {
+        if (reader.isSingleFrame())
+        {
+            if (!cacheKey.empty())
+                mFrameCache.put(cacheKey, inputFrame);
+        }
+        else if (auto nextFrame = reader.next())
+        {
+            if (streamable)
+                return processFrameStream(config, reader, inputFrame, nextFrame, request.outputPath, result);
+            av_frame_free(&nextFrame);
+        }
+        else if (!cacheKey.empty())
+        {
+            mFrameCache.put(cacheKey, inputFrame);
+        }
+    }
+
+    // 按源尺寸规划缩放与用户滤镜的先后顺序
+    auto plan = FilterChainPlanner::plan(
+        config.filterDesc,
+        inputFrame->width, inputFrame->height,
+        config.targetWidth, config.targetHeight);
+    LOG_DEBUG("滤镜链规划：{}x{} -> {}x{} [{}] {}",
+              inputFrame->width, inputFrame->height,
+              config.targetWidth, config.targetHeight,
+              plan.decision, plan.filterDesc);
+
+    FilterGraphOptions options;
+    options.threadCount = decideThreadCount(config, inputFrame->width, inputFrame->height);
+    options.allowFastPath = config.fastPath;
 
     AVFrame *outputFrame = nullptr;
-    int ret = mFilterGraphPool.processFrame(inputFrame, mFilterDesc, &outputFrame);
-    if (ret >= 0 && outputFrame)
+    int ret = 0;
+    stageBegin = Clock::now();
+    if (auto tileOptions = makeTileOptions(config, inputFrame, options);
+        isTileCandidate(config, inputFrame) &&
+        TileProcessor::canTile(inputFrame, config.filterDesc, tileOptions))
+    { // 超大图分条带处理  限制滤镜阶段的峰值内存
+        ret = mTileProcessor.process(inputFrame, config.filterDesc, tileOptions, &outputFrame);
+    }
+    else
     {
-        auto outputPath = geneOutputPath(outputFolder, inputPath, mConfig.outputFmt);
-        encodeImage(outputFrame, outputPath, mConfig.outputFmt);
-        av_frame_free(&outputFrame);
+        ret = mFilterGraphPool.processFrame(inputFrame, plan.filterDesc, &outputFrame, options);
     }
     av_frame_free(&inputFrame);
-    return 0;
-}
+    result.filterUs = Utils::microsSince(stageBegin);
+    tracer.record("filter", stageBegin);
+    if (ret < 0 || !outputFrame)
+    {
+        return 1002;
+    }
 
-int ImageFlowProcessor::processImages(
-    std::vector<std::string> const &imagePaths,
-    std::string const &outputFolder)
-{
-    for (auto &&imagePath : imagePaths)
+    stageBegin = Clock::now();
+    std::vector<uint8_t> encoded;
+    ret = ImageEncoder::encode(
+        outputFrame, config.outputFmt, config.encoder,
+        decideThreadCount(config, outputFrame->width, outputFrame->height), encoded);
+    av_frame_free(&outputFrame);
+    if (ret < 0)
     {
-        mThreadPool.submit([this, imagePath, outputFolder]()
-                           { this->processImage(imagePath, outputFolder); });
+        return 1003;
     }
-    mThreadPool.waitAll();
-    mFilterGraphPool.printCacheStatus();
+
+    result.outputSize = static_cast<int64_t>(encoded.size());
+    if (request.outputPath.empty())
+    {
+        result.outputData = std::move(encoded);
+    }
+    else if (staged)
+    { // 交给I/O线程写出
+        staged->output = std::move(encoded);
+        staged->pendingWrite = true;
+    }
+    else
+    {
+        TraceScope span("write");
+        if (!mOutputCommitter.write(request.outputPath, encoded.data(), encoded.size()))
+            return 1003;
+    }
+    result.encodeUs = Utils::microsSince(stageBegin);
     return 0;
 }
 
-//---------------------------------------------------------------------
-
-AVFrame *ImageFlowProcessor::decodeImage(std::string const &inputPath)
+void ImageFlowProcessor::processJobAsync(
+    JobRequest request,
+    std::function<void(JobResult &&)> callback)
 {
-    AVFormatContext *formatCtx = nullptr;
-    AVCodecContext *codecCtx = nullptr;
-    DEFER({
-        if (formatCtx)
-            avformat_close_input(&formatCtx);
-        if (codecCtx)
-            avcodec_free_context(&codecCtx);
-    });
-
-    // ļ
-    auto utf8Filename = Utils::localToUtf8(inputPath);
-    if (avformat_open_input(&formatCtx, utf8Filename.c_str(), nullptr, nullptr) < 0)
+    auto job = std::make_shared<StagedJob>();
+    job->request = std::move(request);
+    job->callback = std::move(callback);
+    job->submitted = Clock::now();
+    job->result.jobId = ++mNextJobId;
+    TraceContext trace(job->result.jobId);
+    TraceScope span("submit");
+    ensureIoPool();
     {
-        std::cerr << "޷ļ" << inputPath << std::endl;
-        return nullptr;
+        std::lock_guard<std::mutex> _(mStageMutex);
+        ++mAsyncJobs;
     }
 
-    // Ϣ
-    if (avformat_find_stream_info(formatCtx, nullptr) < 0)
+    // 内存输入不需要读取  直接进入计算阶段
+    if (job->request.inputPath.empty())
+        runCompute(job);
+    else
+        stageInput(std::move(job));
+}
+
+void ImageFlowProcessor::stageInput(std::shared_ptr<StagedJob> job)
+{
+    // 整个文件读入内存  按文件大小占用内存预算
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(job->request.inputPath, ec);
+    int64_t bytes = ec ? 0 : static_cast<int64_t>(fileSize);
     {
-        std::cerr << "ҲϢ" << std::endl;
-        return nullptr;
+        // 预读的输入要等计算线程处理  限制数量  避免I/O线程读得过远占满内存
+        // 预算不足时推迟到在途的预读归还之后  没有在途预读时直接占用  保证总能推进
+        std::lock_guard<std::mutex> _(mStageMutex);
+        bool full = mPreloaded >= std::max<size_t>(mThreadPool.getThreadCount(), 1) * 2;
+        if (full || (mPreloaded > 0 && !mMemoryBudget.tryAcquire(bytes)))
+        {
+            if (!full)
+                mMemoryBudget.noteDeferred();
+            mDeferredReads.push_back(std::move(job));
+            return;
+        }
+        if (mPreloaded == 0)
+            mMemoryBudget.acquire(bytes);
+        ++mPreloaded;
     }
+    job->preloaded = true;
+    job->reservedBytes = bytes;
+    mIoPool.submit([this, job]
+                   { readInput(job); });
+}
+
+void ImageFlowProcessor::readInput(std::shared_ptr<StagedJob> const &job)
+{
+    auto begin = Clock::now();
+    auto &tracer = Tracer::getInstance();
+    tracer.setThreadName("io");
+    TraceContext trace(job->result.jobId);
+
+    // 帧缓存中已有时不读文件  计算阶段若发现已被淘汰则自行打开文件
+    job->cacheKey = makeFrameCacheKey(job->request);
+    job->keyed = true;
+    bool reading = job->cacheKey.empty() || !mFrameCache.contains(job->cacheKey);
+    if (mConfig.prefetch)
+        mPrefetcher.noteRead(job->request.inputPath, reading);
 
-    // Ƶ  ͼƬҲƵ  ͼƬֻһ֡
-    int videoStreamIdx = -1;
-    for (unsigned int i = 0; i < formatCtx->nb_streams; i++)
+    // 直接输出源数据的任务在I/O线程中完成  不进入计算阶段
+    // 异常不能越过线程池任务  否则finishJob不会执行  等待该任务的调用者将永远阻塞
+    std::shared_ptr<ProcessConfig const> profileConfig;
+    bool passed = false;
+    bool ok = false;
+    // 先读入输入  直通检查直接解析内存中的文件头
+    try
     {
-        if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        ok = !reading || Utils::readFile(job->request.inputPath, job->input);
+        if (auto config = resolveConfig(job->request, profileConfig);
+            ok && config && canPassThrough(*config, job->request, job.get()))
         {
-            videoStreamIdx = static_cast<int>(i);
-            break;
+            job->result.ioUs += Utils::microsSince(begin);
+            job->result.status = passThrough(*config, job->request, job->result, job.get());
+            passed = true;
         }
     }
-    if (videoStreamIdx == -1)
+    catch (std::exception const &e)
     {
-        std::cerr << "ҲƵ" << std::endl;
-        return nullptr;
+        LOG_ERROR("任务 {} 读取输入时出现异常：{}", job->result.jobId, e.what());
+        job->input = {};
     }
-
-    // ȡ
-    AVCodecParameters *codecpar = formatCtx->streams[videoStreamIdx]->codecpar;
-    auto codec = avcodec_find_decoder(codecpar->codec_id);
-    if (!codec)
+    if (passed)
     {
-        std::cerr << "ֵ֧ı" << std::endl;
-        return nullptr;
+        releasePreload(*job);
+        if (job->pendingWrite)
+            writeOutput(job);
+        else
+            finishJob(job);
+        return;
     }
+    job->result.ioUs += Utils::microsSince(begin);
+    tracer.record("read", begin);
 
-    // 
-    if (!(codecCtx = avcodec_alloc_context3(codec)))
+    if (!ok)
     {
-        std::cerr << "޷" << std::endl;
-        return nullptr;
+        job->result.status = 1001;
+        releasePreload(*job);
+        finishJob(job);
+        return;
     }
-    if (avcodec_parameters_to_context(codecCtx, codecpar) < 0)
+    runCompute(job);
+}
+
+void ImageFlowProcessor::runCompute(std::shared_ptr<StagedJob> const &job)
+{
+    auto enqueued = Clock::now();
+    mScheduler.enqueue(job->request.profile, [this, job, enqueued]
+                       {
+                           auto begin = Clock::now();
+                           auto &tracer = Tracer::getInstance();
+                           tracer.setThreadName("compute");
+                           tracer.recordAsync("queue", job->result.jobId, enqueued, begin);
+                           try
+                           {
+                               job->result.status = executeJob(job->request, job->result, job.get());
+                           }
+                           catch (std::exception const &e)
+                           {
+                               // 按滤镜处理失败返回  保证回调与批次计数照常进行
+                               LOG_ERROR("任务 {} 处理时出现异常：{}", job->result.jobId, e.what());
+                               job->result.status = 1002;
+                               job->pendingWrite = false;
+                               job->output = {};
+                           }
+                           job->computeUs = Utils::microsSince(begin);
+
+                           if (job->preloaded)
+                           {
+                               job->input = {};
+                               releasePreload(*job);
+                           }
+
+                           // 写出优先于预读  尽早释放编码结果并回调
+                           if (job->pendingWrite)
+                           {
+                               try
+                               {
+                                   mIoPool.submitWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), [this, job]
+                                                              { writeOutput(job); });
+                                   return;
+                               }
+                               catch (std::exception const &e)
+                               {
+                                   LOG_ERROR("任务 {} 无法提交写出：{}", job->result.jobId, e.what());
+                                   job->result.status = 1003;
+                               }
+                           }
+                           finishJob(job); });
+}
+
+void ImageFlowProcessor::writeOutput(std::shared_ptr<StagedJob> const &job)
+{
+    // 组提交时回调在提交线程中  落盘后才回调  I/O线程不等待
+    auto begin = Clock::now();
+    Tracer::getInstance().setThreadName("io");
+    auto done = [this, job, begin](bool ok)
     {
-        std::cerr << "޷" << std::endl;
-        return nullptr;
+        if (!ok)
+            job->result.status = 1003;
+        job->output = {};
+        job->result.ioUs += Utils::microsSince(begin);
+        Tracer::getInstance().recordAsync("write", job->result.jobId, begin, Clock::now());
+        finishJob(job);
+    };
+    try
+    {
+        if (!job->pendingCommit.empty())
+            mOutputCommitter.commit(job->pendingCommit, job->request.outputPath, done);
+        else
+            mOutputCommitter.write(job->request.outputPath, job->output.data(), job->output.size(), done);
     }
-    // 򿪽
-    if (avcodec_open2(codecCtx, codec, nullptr) < 0)
+    catch (std::exception const &e)
     {
-        std::cerr << "޷򿪱" << std::endl;
-        return nullptr;
+        LOG_ERROR("任务 {} 写出时出现异常：{}", job->result.jobId, e.what());
+        done(false);
     }
+}
+
+void ImageFlowProcessor::finishJob(std::shared_ptr<StagedJob> const &job)
+{
+    auto &result = job->result;
+    result.elapsedUs = job->computeUs + result.ioUs;
+    result.queueUs = std::max<int64_t>(Utils::microsSince(job->submitted) - result.elapsedUs, 0);
+    mScheduler.noteResult(job->request.profile, result.status == 0, result.outputSize);
+    job->callback(std::move(result));
+
+    std::lock_guard<std::mutex> _(mStageMutex);
+    if (--mAsyncJobs == 0)
+        mStageCondition.notify_all();
+}
+
+void ImageFlowProcessor::ensureIoPool()
+{
+    std::call_once(mIoPoolStarted, [this]
+                   { mIoPool.resize(ioThreadCount(mConfig)); });
+}
+
+void ImageFlowProcessor::releasePreload(StagedJob &job)
+{
+    mMemoryBudget.release(job.reservedBytes);
+    job.reservedBytes = 0;
 
-    // ֡
-    auto frame = av_frame_alloc();
-    if (!frame)
+    std::shared_ptr<StagedJob> next;
     {
-        std::cerr << "޷ AVFrame" << std::endl;
-        return nullptr;
+        std::lock_guard<std::mutex> _(mStageMutex);
+        --mPreloaded;
+        if (mDeferredReads.empty())
+            return;
+        next = std::move(mDeferredReads.front());
+        mDeferredReads.pop_front();
     }
+    stageInput(std::move(next));
+}
+
+ProcessConfig const &ImageFlowProcessor::getConfig() const
+{
+    return mConfig;
+}
 
-    AVPacket packet;
-    AVFrame *cloned = nullptr;
-    while (av_read_frame(formatCtx, &packet) >= 0)
+bool ImageFlowProcessor::setProfile(
+    std::string const &name,
+    ProcessConfig const &config,
+    int weight)
+{
+    if (!isValidConfig(config))
+        return false;
+
+    auto shared = std::make_shared<ProcessConfig const>(config);
     {
-        // ֻƵ
-        if (packet.stream_index == videoStreamIdx)
-        {
-            int ret = avcodec_send_packet(codecCtx, &packet);
-            if (ret < 0)
-            {
-                av_packet_unref(&packet);
-                continue;
-            }
+        std::lock_guard<std::mutex> _(mProfilesMutex);
+        mProfiles[name] = std::move(shared);
+    }
+    mScheduler.setWeight(name, weight);
+    return true;
+}
 
-            ret = avcodec_receive_frame(codecCtx, frame);
-            if (ret == 0)
-            {
-                // ¡һ֡ݣ codecCtx 
-                cloned = av_frame_clone(frame);
-                av_frame_unref(frame);
-                av_packet_unref(&packet);
-                break;
-            }
-        }
-        av_packet_unref(&packet);
+std::shared_ptr<ProcessConfig const> ImageFlowProcessor::getProfile(std::string const &name) const
+{
+    std::lock_guard<std::mutex> _(mProfilesMutex);
+    auto it = mProfiles.find(name);
+    return it != mProfiles.end() ? it->second : nullptr;
+}
+
+std::vector<ProfileScheduler::Stats> ImageFlowProcessor::getProfileStats() const
+{
+    return mScheduler.getStats();
+}
+
+void ImageFlowProcessor::printProfileStats() const
+{
+    for (auto &&stats : getProfileStats())
+    {
+        size_t done = std::max<size_t>(stats.completed, 1);
+        LOG_INFO("配置档 {}（权重 {}）：提交 {}  完成 {}  失败 {}  排队中 {}  平均排队 {:.2f} ms  平均处理 {:.2f} ms  输出 {} KB",
+                 stats.profile.empty() ? "默认" : stats.profile, stats.weight,
+                 stats.submitted, stats.completed, stats.failed, stats.queued,
+                 stats.queueUs / 1000.0 / done, stats.busyUs / 1000.0 / done,
+                 stats.outputBytes >> 10);
     }
+}
 
-    // Դ
-    av_frame_free(&frame);
+FilterGraphPoolMetrics ImageFlowProcessor::getGraphPoolMetrics() const
+{
+    return mFilterGraphPool.getMetrics();
+}
 
-    return cloned;
+OutputCommitter::Stats ImageFlowProcessor::getOutputCommitStats() const
+{
+    return mOutputCommitter.getStats();
 }
 
-bool ImageFlowProcessor::encodeImage(
-    AVFrame *frame,
-    std::string const &outputPath,
-    std::string const &format)
+Prefetcher::Stats ImageFlowProcessor::getPrefetchStats() const
 {
-    // ݸʽȷ
-    const char *codecName = "png"; // ĬPNG
-    if (format == "jpg" || format == "jpeg")
-        codecName = "mjpeg";
-    else if (format == "bmp")
-        codecName = "bmp";
-    else if (format == "webp")
-        codecName = "libwebp";
+    return mPrefetcher.getStats();
+}
+
+size_t ImageFlowProcessor::getThumbnailJobCount() const
+{
+    return mThumbnailJobs.load();
+}
 
-    auto outputCodec = avcodec_find_encoder_by_name(codecName);
-    if (!outputCodec)
+size_t ImageFlowProcessor::getPassThroughJobCount() const
+{
+    return mPassThroughJobs.load();
+}
+
+std::vector<LockStats> ImageFlowProcessor::getLockStats() const
+{
+    return InstrumentedMutex::collect();
+}
+
+void ImageFlowProcessor::printLockStats() const
+{
+    for (auto &&stats : getLockStats())
     {
-        std::cerr << "δҵ" << codecName << std::endl;
-        return false;
+        LOG_INFO("锁 {}：加锁 {} 次  竞争 {} 次（{:.2f}%）  累计等待 {:.3f} 毫秒  最长持有 {:.3f} 毫秒",
+                 stats.name, stats.acquisitions, stats.contended,
+                 stats.acquisitions ? stats.contended * 100.0 / stats.acquisitions : 0.0,
+                 stats.waitNanos / 1e6, stats.maxHoldNanos / 1e6);
     }
+}
+
+ProcessorMetrics ImageFlowProcessor::getMetrics() const
+{
+    ProcessorMetrics metrics;
+    metrics.graphPool = getGraphPoolMetrics();
+    metrics.frameCache = getFrameCacheStats();
+    metrics.prefetch = getPrefetchStats();
+    metrics.outputCommit = getOutputCommitStats();
+    metrics.executors = getExecutorStats();
+    metrics.locks = getLockStats();
+    metrics.thumbnailJobs = getThumbnailJobCount();
+    metrics.passThroughJobs = getPassThroughJobCount();
+    return metrics;
+}
 
-    AVCodecContext *outputCodecCtx = avcodec_alloc_context3(outputCodec);
-    if (!outputCodecCtx)
+FrameCache::Stats ImageFlowProcessor::getFrameCacheStats() const
+{
+    return mFrameCache.getStats();
+}
+
+std::vector<ExecutorStats> ImageFlowProcessor::getExecutorStats() const
+{
+    auto collect = [](char const *name, ThreadPool const &pool)
     {
-        std::cerr << "޷Ƶ" << std::endl;
-        return false;
+        auto status = pool.getStatus();
+        auto utilization = pool.getUtilization();
+        return ExecutorStats{name, status.totalThreads, status.queueSize, status.activeTasks,
+                             utilization.busySeconds, utilization.utilization};
+    };
+    return {collect("compute", mThreadPool), collect("io", mIoPool)};
+}
+
+void ImageFlowProcessor::printExecutorStats() const
+{
+    for (auto &&stats : getExecutorStats())
+    {
+        LOG_INFO("线程池 {}：{} 线程  排队 {}  执行中 {}  累计执行 {:.2f} 秒  利用率 {:.1f}%",
+                 stats.name, stats.threads, stats.queued, stats.active,
+                 stats.busySeconds, stats.utilization * 100.0);
     }
+}
+
+void ImageFlowProcessor::printFrameCacheStats() const
+{
+    auto stats = mFrameCache.getStats();
+    if (stats.budget <= 0)
+        return;
+    size_t lookups = stats.hits + stats.misses;
+    LOG_INFO("解码帧缓存：{} / {} MB  {} 条  命中率 {:.1f}%（{}/{}）  节省解码 {} MB  淘汰 {}",
+             stats.bytes >> 20, stats.budget >> 20, stats.entries,
+             lookups ? stats.hits * 100.0 / lookups : 0.0, stats.hits, lookups,
+             stats.bytesSaved >> 20, stats.evictions);
+}
 
-    // ñ
-    outputCodecCtx->width = frame->width;
-    outputCodecCtx->height = frame->height;
-    outputCodecCtx->time_base = {1, 25};
+bool ImageFlowProcessor::isValidConfig(ProcessConfig const &config)
+{
+    return !toFilterDesc(config).empty();
+}
 
-    // ݱúʵظʽ
-    if (strcmp(codecName, "mjpeg") == 0)
+int ImageFlowProcessor::processImages(
+    std::vector<std::string> const &imagePaths,
+    std::string const &outputFolder)
+{
+    bool budgeted = mMemoryBudget.getBudget() > 0;
+    bool scheduled = mConfig.schedule == ScheduleOrder::LARGEST_FIRST;
+
+    // 准入控制与调度都需要文件头信息  两者都关闭时不探测
+    std::vector<ImageJob> jobs;
+    jobs.reserve(imagePaths.size());
+    for (auto &&imagePath : imagePaths)
     {
-        outputCodecCtx->pix_fmt = AV_PIX_FMT_YUVJ420P; // JPEG øʽ
-        //  JPEG 
-        outputCodecCtx->qmin = 2;  // 
-        outputCodecCtx->qmax = 31; // 
-        av_opt_set_int(outputCodecCtx->priv_data, "qscale", 2, 0);
+        ImageJob job{imagePath};
+        if (budgeted || scheduled)
+        {
+            ImageInfo info;
+            ImageProbe::probe(imagePath, info); // 探测失败按0字节放行  由解码阶段报错
+            job.bytes = estimateJobBytes(info);
+            job.cost = estimateJobCost(info);
+        }
+        jobs.push_back(std::move(job));
     }
-    else if (strcmp(codecName, "libwebp") == 0)
+
+    std::vector<double> submitCosts;
+    if (scheduled)
     {
-        outputCodecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
-        //  WebP 
-        av_opt_set_int(outputCodecCtx->priv_data, "quality", 90, 0);
+        for (auto &&job : jobs)
+            submitCosts.push_back(job.cost);
+        std::stable_sort(jobs.begin(), jobs.end(), [](ImageJob const &a, ImageJob const &b)
+                         { return a.cost > b.cost; });
     }
-    else if (strcmp(codecName, "png") == 0)
+
+    // 按提交顺序预取  读取位置推进时窗口随之前移
+    if (mConfig.prefetch)
     {
-        outputCodecCtx->pix_fmt = AV_PIX_FMT_RGBA; // PNG ֧͸ͨ
-        //  PNG ѹ
-        outputCodecCtx->compression_level = 6;
+        ensureIoPool();
+        std::vector<std::string> order;
+        order.reserve(jobs.size());
+        for (auto &&job : jobs)
+            order.push_back(job.path);
+        mPrefetcher.enqueue(order);
     }
-    else if (strcmp(codecName, "bmp") == 0)
+
+    // 只等待本批任务  不受其他调用者提交到同一线程池的任务影响
+    auto batch = std::make_shared<Batch>();
+    auto start = Clock::now();
+    if (budgeted)
     {
-        outputCodecCtx->pix_fmt = AV_PIX_FMT_BGR24; // BMP øʽ
+        submitWithinBudget(jobs, outputFolder, batch);
     }
     else
     {
-        outputCodecCtx->pix_fmt = AV_PIX_FMT_YUV420P; // Ĭϸʽ
+        for (auto &&job : jobs)
+            submitJob(job, outputFolder, false, batch);
     }
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->condition.wait(lock, [&]
+                              { return batch->remaining == 0; });
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
 
-    // ͨñ
-    outputCodecCtx->flags |= AV_CODEC_FLAG_QSCALE;
+    if (scheduled)
+    {
+        std::vector<double> scheduledCosts;
+        for (auto &&job : jobs)
+            scheduledCosts.push_back(job.cost);
+        reportMakespan(submitCosts, scheduledCosts, batch->busyNanos / 1e9, elapsed.count());
+    }
+    mFilterGraphPool.printCacheStatus();
+    printFrameCacheStats();
+    printExecutorStats();
+    printLockStats();
+    if (mConfig.durability != Durability::NONE)
+    {
+        auto stats = mOutputCommitter.getStats();
+        LOG_INFO("输出提交：{} 个文件  失败 {}  组提交 {} 批  fsync 文件 {} 次  目录 {} 次  刷盘耗时 {:.3f} 秒",
+                 stats.files, stats.failures, stats.groups,
+                 stats.fileSyncs, stats.dirSyncs, stats.syncUs / 1e6);
+    }
+    if (mConfig.prefetch)
+    {
+        auto stats = mPrefetcher.getStats();
+        LOG_INFO("预取：窗口 {}  读取速率 {:.1f} 个/秒  已预取 {}  读取时已在缓存 {:.1f}%（{}/{}）",
+                 stats.window, stats.rate, stats.hinted,
+                 stats.reads ? stats.resident * 100.0 / stats.reads : 0.0, stats.resident, stats.reads);
+    }
+    if (mConfig.embeddedThumbnail)
+        LOG_INFO("内嵌缩略图：累计 {} 张图像只解码了缩略图", mThumbnailJobs.load());
+    if (auto count = mPassThroughJobs.load())
+        LOG_INFO("直通：累计 {} 张图像未解码直接输出源数据", count);
+    writeTrace();
+    return static_cast<int>(batch->failed.load());
+}
+
+int ImageFlowProcessor::processPack(
+    std::string const &inputPack,
+    std::string const &outputPack)
+{
+    // 映射在所有任务完成前保持有效
+    PackReader reader;
+    PackWriter writer;
+    if (!reader.open(inputPack) || !writer.open(outputPack))
+        return -1;
 
-    // 򿪱
-    if (avcodec_open2(outputCodecCtx, outputCodec, nullptr) < 0)
+    // 条目可能多达数百万  限制在途任务数  不一次性全部排队
+    size_t const maxInFlight = std::max<size_t>(mThreadPool.getThreadCount(), 1) * 4;
+    auto batch = std::make_shared<Batch>();
+    auto start = Clock::now();
+    for (auto &&entry : reader.getEntries())
     {
-        std::cerr << "޷" << std::endl;
-        avcodec_free_context(&outputCodecCtx);
-        return false;
+        {
+            std::unique_lock<std::mutex> lock(batch->mutex);
+            batch->condition.wait(lock, [&]
+                                  { return batch->remaining < maxInFlight; });
+            ++batch->remaining;
+        }
+
+        JobRequest request;
+        request.inputView = reader.getData(entry);
+        auto name = std::filesystem::path{entry.name}.replace_extension(mConfig.outputFmt).generic_string();
+        processJobAsync(std::move(request), [&writer, batch, name = std::move(name)](JobResult &&result)
+                        {
+                            if (result.status == 0 && !writer.add(name, result.outputData.data(), result.outputData.size()))
+                                result.status = 1003;
+                            batch->busyNanos += result.elapsedUs * 1000;
+                            if (result.status != 0)
+                                ++batch->failed;
+
+                            std::lock_guard<std::mutex> _(batch->mutex);
+                            --batch->remaining;
+                            batch->condition.notify_all(); });
+    }
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->condition.wait(lock, [&]
+                              { return batch->remaining == 0; });
     }
 
-    // ļ
-    std::filesystem::path outPath{std::string(outputPath)};
-    FILE *outputFile = nullptr;
-#if defined(_WIN32)
-    // ʹÿַ·ļ֧ Unicode ·
-    std::wstring wpath = outPath.wstring();
-    if (_wfopen_s(&outputFile, wpath.c_str(), L"wb") != 0)
-        outputFile = nullptr;
-#else
-    std::string outPathStr = outPath.string();
-    outputFile = fopen(outPathStr.c_str(), "wb");
-#endif
+    size_t failed = batch->failed.load();
+    if (!writer.close(mConfig.durability != Durability::NONE))
+        ++failed;
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    LOG_INFO("打包处理：输入 {} 条  失败 {}  输出包共 {} 条 {} MB  耗时 {:.3f} 秒",
+             reader.getEntries().size(), failed,
+             writer.getEntryCount(), writer.getSize() >> 20, elapsed.count());
+    mFilterGraphPool.printCacheStatus();
+    printExecutorStats();
+    printLockStats();
+    writeTrace();
+    return static_cast<int>(failed);
+}
 
-    if (!outputFile)
+void ImageFlowProcessor::submitJob(
+    ImageJob const &job,
+    std::string const &outputFolder,
+    bool budgeted,
+    std::shared_ptr<Batch> const &batch)
+{
     {
-        std::cerr << "޷ļ" << outPath << std::endl;
-        avcodec_free_context(&outputCodecCtx);
-        return false;
+        std::lock_guard<std::mutex> _(batch->mutex);
+        ++batch->remaining;
     }
+    processImageAsync(job.path, outputFolder, [this, bytes = budgeted ? job.bytes : 0, batch](JobResult &&result)
+                      {
+                          if (bytes > 0)
+                              mMemoryBudget.release(bytes);
+                          batch->busyNanos += result.elapsedUs * 1000;
+                          if (result.status != 0)
+                              ++batch->failed;
 
-    // ظʽת
-    SwsContext *conversionCtx = nullptr;
-    AVFrame *convertedFrame = nullptr;
+                          std::lock_guard<std::mutex> _(batch->mutex);
+                          if (--batch->remaining == 0)
+                              batch->condition.notify_all(); });
+}
 
-    if (frame->format != outputCodecCtx->pix_fmt)
+void ImageFlowProcessor::submitWithinBudget(
+    std::vector<ImageJob> &jobs,
+    std::string const &outputFolder,
+    std::shared_ptr<Batch> const &batch)
+{
+    std::deque<ImageJob *> pending;
+    for (auto &&job : jobs)
+        pending.push_back(&job);
+
+    // 越过次数上限  防止大图一直被小图插队
+    size_t const maxBypass = std::max<size_t>(mThreadPool.getStatus().totalThreads * 4, 16);
+
+    while (!pending.empty())
     {
-        conversionCtx = sws_getContext(
-            frame->width, frame->height, (AVPixelFormat)frame->format,
-            outputCodecCtx->width, outputCodecCtx->height, outputCodecCtx->pix_fmt,
-            SWS_BILINEAR, nullptr, nullptr, nullptr);
+        uint64_t seen = mMemoryBudget.generation();
 
-        if (!conversionCtx)
+        auto head = pending.front();
+        if (mMemoryBudget.tryAcquire(head->bytes))
         {
-            std::cerr << "޷ת" << std::endl;
-            fclose(outputFile);
-            avcodec_free_context(&outputCodecCtx);
-            return false;
+            submitJob(*head, outputFolder, true, batch);
+            pending.pop_front();
+            continue;
         }
 
-        // ת֡
-        convertedFrame = av_frame_alloc();
-        convertedFrame->format = outputCodecCtx->pix_fmt;
-        convertedFrame->width = outputCodecCtx->width;
-        convertedFrame->height = outputCodecCtx->height;
-
-        if (av_frame_get_buffer(convertedFrame, 0) < 0)
+        // 队首放不下时  放行后面第一个放得下的任务
+        bool admitted = false;
+        if (head->bypassed < maxBypass)
         {
-            std::cerr << "޷ת֡" << std::endl;
-            sws_freeContext(conversionCtx);
-            fclose(outputFile);
-            avcodec_free_context(&outputCodecCtx);
-            av_frame_free(&convertedFrame);
-            return false;
+            for (auto it = pending.begin() + 1; it != pending.end(); ++it)
+            {
+                if (mMemoryBudget.tryAcquire((*it)->bytes))
+                {
+                    submitJob(**it, outputFolder, true, batch);
+                    pending.erase(it);
+                    ++head->bypassed;
+                    admitted = true;
+                    break;
+                }
+            }
+        }
+        if (!admitted)
+        {
+            mMemoryBudget.noteDeferred();
+            mMemoryBudget.waitForRelease(seen);
         }
+    }
+
+    auto stats = mMemoryBudget.getStats();
+    LOG_INFO("准入控制：预算 {} MB  峰值 {} MB  放行 {}  等待 {}  超预算单独放行 {}",
+             stats.budget >> 20, stats.peak >> 20,
+             stats.admitted, stats.deferred, stats.oversized);
+}
+
+//---------------------------------------------------------------------
+
+int64_t ImageFlowProcessor::estimateJobBytes(ImageInfo const &info) const
+{
+    if (info.width <= 0 || info.height <= 0)
+        return 0;
+
+    // 解码帧  缩放/滤镜输出帧  编码前的像素格式转换帧各一份  另加编码输出缓冲
+    int64_t srcBytes = ImageProbe::frameBytes(info.width, info.height, info.pixelFmt);
+    int dstWidth = mConfig.targetWidth > 0 ? mConfig.targetWidth : info.width;
+    int dstHeight = mConfig.targetHeight > 0 ? mConfig.targetHeight : info.height;
+    int64_t dstBytes = ImageProbe::frameBytes(dstWidth, dstHeight, AV_PIX_FMT_RGBA);
 
-        // ִиʽת
-        sws_scale(conversionCtx,
-                  frame->data, frame->linesize, 0, frame->height,
-                  convertedFrame->data, convertedFrame->linesize);
+    // 条带处理时滤镜阶段只占用条带预算
+    bool tiled = mConfig.tilePixelThreshold > 0 &&
+                 static_cast<int64_t>(info.width) * info.height >= mConfig.tilePixelThreshold;
+    int64_t filterBytes = tiled ? static_cast<int64_t>(mConfig.tileMemoryBudget) : srcBytes;
+    return srcBytes + filterBytes + dstBytes * 2;
+}
+
+double ImageFlowProcessor::estimateJobCost(ImageInfo const &info) const
+{
+    // 解码与源尺寸成正比  缩放/滤镜取两端较大者  编码与目标尺寸成正比
+    if (info.width > 0 && info.height > 0)
+    {
+        double srcPixels = static_cast<double>(info.width) * info.height;
+        double dstPixels = mConfig.targetWidth > 0 && mConfig.targetHeight > 0
+                               ? static_cast<double>(mConfig.targetWidth) * mConfig.targetHeight
+                               : srcPixels;
+        return srcPixels + std::max(srcPixels, dstPixels) + dstPixels;
     }
 
-    // ֡
-    AVFrame *frameToEncode = convertedFrame ? convertedFrame : frame;
-    int ret = avcodec_send_frame(outputCodecCtx, frameToEncode);
-    if (ret < 0)
+    // 无法探测时以文件大小代替  压缩图像约每字节4个像素
+    constexpr double kPixelsPerByte = 4.0;
+    return static_cast<double>(info.fileSize) * kPixelsPerByte * 3.0;
+}
+
+void ImageFlowProcessor::reportMakespan(
+    std::vector<double> const &submitCosts,
+    std::vector<double> const &scheduledCosts,
+    double busySeconds,
+    double elapsedSeconds) const
+{
+    // 按线程池的行为模拟  每个任务交给最早空闲的线程
+    size_t workers = std::max<size_t>(mThreadPool.getStatus().totalThreads, 1);
+    auto simulate = [workers](std::vector<double> const &costs)
     {
-        std::cerr << "֡ʱ" << std::endl;
-        if (conversionCtx)
-            sws_freeContext(conversionCtx);
-        if (convertedFrame)
-            av_frame_free(&convertedFrame);
-        fclose(outputFile);
-        avcodec_free_context(&outputCodecCtx);
+        std::priority_queue<double, std::vector<double>, std::greater<double>> finish;
+        for (size_t i = 0; i < workers; ++i)
+            finish.push(0.0);
+        double makespan = 0.0;
+        for (double cost : costs)
+        {
+            double end = finish.top() + cost;
+            finish.pop();
+            finish.push(end);
+            makespan = std::max(makespan, end);
+        }
+        return makespan;
+    };
+
+    // 以本批实际处理耗时标定单位代价的耗时
+    double totalCost = 0.0;
+    for (double cost : scheduledCosts)
+        totalCost += cost;
+    if (totalCost <= 0.0 || busySeconds <= 0.0)
+        return;
+    double secondsPerCost = busySeconds / totalCost;
+
+    double estimated = simulate(scheduledCosts) * secondsPerCost;
+    double unordered = simulate(submitCosts) * secondsPerCost;
+    double lowerBound = std::max(busySeconds / workers,
+                                 *std::max_element(scheduledCosts.begin(), scheduledCosts.end()) * secondsPerCost);
+    LOG_INFO("调度：实际完成 {:.3f} 秒  估算 {:.3f} 秒（偏差 {:+.1f}%）  原顺序估算 {:.3f} 秒  下界 {:.3f} 秒",
+             elapsedSeconds, estimated, (elapsedSeconds / estimated - 1.0) * 100.0,
+             unordered, lowerBound);
+}
+
+AVFrame *ImageFlowProcessor::decodeImage(
+    ProcessConfig const &config,
+    FrameReader &reader,
+    JobRequest const &request,
+    std::vector<uint8_t> const *preloaded)
+{
+    bool opened = false;
+    if (preloaded && !preloaded->empty())
+        opened = reader.openMemory(preloaded->data(), preloaded->size());
+    else if (!request.inputView.empty())
+        opened = reader.openMemory(request.inputView.data(), request.inputView.size());
+    else if (request.inputPath.empty())
+        opened = reader.openMemory(request.inputData.data(), request.inputData.size());
+    else
+        opened = reader.open(request.inputPath);
+    if (!opened)
+        return nullptr;
+
+    // 按图像尺寸决定解码线程数
+    if (!reader.openDecoder(decideThreadCount(config, reader.width(), reader.height())))
+        return nullptr;
+    return reader.next();
+}
+
+std::span<uint8_t const> ImageFlowProcessor::inputBytes(JobRequest const &request, StagedJob const *staged)
+{
+    if (staged && !staged->input.empty())
+        return staged->input;
+    if (!request.inputView.empty())
+        return request.inputView;
+    if (request.inputPath.empty())
+        return request.inputData;
+    return {};
+}
+
+bool ImageFlowProcessor::canPassThrough(
+    ProcessConfig const &config,
+    JobRequest const &request,
+    StagedJob const *staged) const
+{
+    // 先做不需要读取输入的检查
+    if (!config.passThrough || !FilterChainPlanner::isNoOpChain(config.filterDesc))
         return false;
-    }
 
-    // ձİ
-    AVPacket *pkt = av_packet_alloc();
+    // 调整过编码参数说明调用者要的是重新编码的结果
+    if (config.encoder != EncoderOptions{})
+        return false;
 
-    // ڷʵ֡flush ȷад
-    // pkt ں av_packet_alloc()
-    int recvRet = 0;
-    while (true)
+    // 动图格式只取第一帧时（关闭逐帧处理或输出到内存）输出与输入不同
+    if (ImageEncoder::animatedEncoderName(config.outputFmt) && (!config.multiFrame || request.outputPath.empty()))
+        return false;
+
+    AVCodecID codecId = ImageEncoder::codecId(config.outputFmt);
+    if (config.stripMetadata && codecId != AV_CODEC_ID_MJPEG && codecId != AV_CODEC_ID_PNG)
+        return false;
+
+    // 从已读入的数据或文件开头解析文件头  编码格式相同且尺寸不变
+    // 不经过libavformat  需要缩放的任务只多读一次文件开头  识别不了的格式（如TIFF）不直通
+    constexpr size_t kHeadBytes = 256 << 10;
+    std::vector<uint8_t> head;
+    auto data = inputBytes(request, staged);
+    if (data.empty() && Utils::readFileHead(request.inputPath, kHeadBytes, head))
+        data = head;
+
+    ImageInfo info;
+    if (!ImageProbe::probeHeader(data.data(), data.size(), info))
+        return false;
+    bool scaled = config.targetWidth > 0 && config.targetHeight > 0 &&
+                  (config.targetWidth != info.width || config.targetHeight != info.height);
+    return !scaled && info.codecId == codecId;
+}
+
+int ImageFlowProcessor::passThrough(
+    ProcessConfig const &config,
+    JobRequest const &request,
+    JobResult &result,
+    StagedJob *staged)
+{
+    auto begin = Clock::now();
+    TraceScope span("copy");
+    auto data = inputBytes(request, staged);
+
+    // 剥离元数据或输出到内存时需要读入整个文件  否则文件到文件直接复制
+    std::vector<uint8_t> owned;
+    if (data.empty() && (config.stripMetadata || request.outputPath.empty()))
     {
-        recvRet = avcodec_receive_packet(outputCodecCtx, pkt);
-        if (recvRet == AVERROR(EAGAIN))
-            break;
-        else if (recvRet < 0)
-            break;
+        if (!Utils::readFile(request.inputPath, owned))
+            return 1001;
+        data = owned;
+    }
+    if (config.stripMetadata)
+    {
+        std::vector<uint8_t> stripped;
+        if (!MetadataStripper::strip(data.data(), data.size(), stripped))
+            return 1001;
+        owned = std::move(stripped);
+        data = owned;
+    }
+    auto takeBytes = [&]
+    {
+        // 预读的输入不再需要  直接转交  不复制
+        if (!owned.empty())
+            return std::move(owned);
+        if (staged && data.data() == staged->input.data())
+            return std::move(staged->input);
+        return std::vector<uint8_t>(data.begin(), data.end());
+    };
 
-        fwrite(pkt->data, 1, pkt->size, outputFile);
-        av_packet_unref(pkt);
+    bool ok = true;
+    if (data.empty())
+    { // 先复制到临时文件再提交  文件系统支持时只共享数据块
+        std::error_code ec;
+        result.outputSize = static_cast<int64_t>(std::filesystem::file_size(std::filesystem::path{request.inputPath}, ec));
+        auto tempPath = OutputCommitter::makeTempPath(request.outputPath);
+        ok = Utils::copyFile(request.inputPath, tempPath);
+        if (!ok)
+        {
+            std::filesystem::remove(tempPath, ec);
+        }
+        else if (staged)
+        {
+            staged->pendingCommit = std::move(tempPath);
+            staged->pendingWrite = true;
+        }
+        else
+            ok = mOutputCommitter.commit(tempPath, request.outputPath);
+    }
+    else
+    {
+        result.outputSize = static_cast<int64_t>(data.size());
+        if (request.outputPath.empty())
+        {
+            result.outputData = takeBytes();
+        }
+        else if (staged)
+        {
+            staged->output = takeBytes();
+            staged->pendingWrite = true;
+        }
+        else
+            ok = mOutputCommitter.write(request.outputPath, data.data(), data.size());
     }
+    if (ok)
+        ++mPassThroughJobs;
+    result.ioUs += Utils::microsSince(begin);
+    return ok ? 0 : 1003;
+}
 
-    // Ϳ֡Դ flush
-    avcodec_send_frame(outputCodecCtx, nullptr);
-    while (true)
+bool ImageFlowProcessor::loadEmbeddedThumbnail(
+    ProcessConfig const &config,
+    JobRequest const &request,
+    StagedJob const *staged,
+    std::vector<uint8_t> &thumbnail) const
+{
+    if (!config.embeddedThumbnail || config.targetWidth <= 0 || config.targetHeight <= 0)
+        return false;
+
+    // 缩略图在APP1段内（不超过64KB）  主图SOF通常紧随其后  文件输入只读开头
+    constexpr size_t kHeadBytes = 256 << 10;
+    std::vector<uint8_t> head;
+    auto data = inputBytes(request, staged);
+    if (data.empty() && Utils::readFileHead(request.inputPath, kHeadBytes, head))
+        data = head;
+
+    EmbeddedThumbnail thumb;
+    if (!JpegThumbnail::find(data.data(), data.size(), thumb) ||
+        !JpegThumbnail::canServe(thumb, config.targetWidth, config.targetHeight))
     {
-        recvRet = avcodec_receive_packet(outputCodecCtx, pkt);
-        if (recvRet == AVERROR(EAGAIN) || recvRet == AVERROR_EOF)
-            break;
-        else if (recvRet < 0)
+        return false;
+    }
+    LOG_DEBUG("使用内嵌缩略图：{}x{}（原图 {}x{}） -> {}x{}",
+              thumb.width, thumb.height, thumb.imageWidth, thumb.imageHeight,
+              config.targetWidth, config.targetHeight);
+    thumbnail.assign(thumb.data.begin(), thumb.data.end());
+    return true;
+}
+
+int ImageFlowProcessor::processFrameStream(
+    ProcessConfig const &config,
+    FrameReader &reader,
+    AVFrame *firstFrame,
+    AVFrame *secondFrame,
+    std::string const &outputPath,
+    JobResult &result)
+{
+    auto plan = FilterChainPlanner::plan(
+        config.filterDesc,
+        firstFrame->width, firstFrame->height,
+        config.targetWidth, config.targetHeight);
+
+    FilterGraphOptions options;
+    options.threadCount = decideThreadCount(config, firstFrame->width, firstFrame->height);
+    options.allowFastPath = config.fastPath;
+
+    auto &tracer = Tracer::getInstance();
+    FrameSequenceWriter writer;
+    writer.open(
+        outputPath, config.outputFmt, reader.timeBase(),
+        config.encoder, options.threadCount, &mOutputCommitter);
+
+    // 整个序列只获取一次滤镜图  帧尺寸或像素格式变化时才重新获取
+    FilterGraphPool::FilterGraphPtr graph;
+    int graphWidth = 0;
+    int graphHeight = 0;
+    int graphFormat = AV_PIX_FMT_NONE;
+    DEFER(mFilterGraphPool.releaseFilterGraph(graph));
+
+    // 任意时刻只持有当前帧、预读帧与输出帧
+    int ret = 0;
+    AVFrame *frame = firstFrame;
+    AVFrame *pending = secondFrame;
+    while (frame)
+    {
+        if (!graph ||
+            frame->width != graphWidth ||
+            frame->height != graphHeight ||
+            frame->format != graphFormat)
+        {
+            mFilterGraphPool.releaseFilterGraph(graph);
+            graph = mFilterGraphPool.getFilterGraph(frame, plan.filterDesc, true, options);
+            if (!graph)
+            {
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+            graphWidth = frame->width;
+            graphHeight = frame->height;
+            graphFormat = frame->format;
+        }
+
+        AVFrame *outputFrame = nullptr;
+        auto stageBegin = Clock::now();
+        ret = mFilterGraphPool.processFrame(graph, frame, &outputFrame);
+        result.filterUs += Utils::microsSince(stageBegin);
+        tracer.record("filter", stageBegin);
+        if (ret >= 0)
+        {
+            // 保留源帧的显示时间  编码器据此计算帧间延时
+            outputFrame->pts = frame->pts;
+            outputFrame->duration = frame->duration;
+            stageBegin = Clock::now();
+            ret = writer.write(outputFrame);
+            result.encodeUs += Utils::microsSince(stageBegin);
+            tracer.record("encode", stageBegin);
+            av_frame_free(&outputFrame);
+        }
+        else if (ret == AVERROR(EAGAIN))
+        {
+            ret = 0;
+        }
+        av_frame_free(&frame);
+        if (ret < 0)
             break;
 
-        fwrite(pkt->data, 1, pkt->size, outputFile);
-        av_packet_unref(pkt);
+        if (pending)
+        {
+            frame = pending;
+            pending = nullptr;
+        }
+        else
+        {
+            auto stageBegin = Clock::now();
+            frame = reader.next();
+            result.decodeUs += Utils::microsSince(stageBegin);
+            tracer.record("decode", stageBegin);
+        }
     }
+    av_frame_free(&frame);
+    av_frame_free(&pending);
 
-    // Դ
-    if (conversionCtx)
-        sws_freeContext(conversionCtx);
-    if (convertedFrame)
-        av_frame_free(&convertedFrame);
-    fclose(outputFile);
-    avcodec_free_context(&outputCodecCtx);
-    av_packet_free(&pkt);
-
-    return true;
+    auto closeBegin = Clock::now();
+    if (int closeRet = writer.close(); ret >= 0)
+        ret = closeRet;
+    result.encodeUs += Utils::microsSince(closeBegin);
+    result.outputSize = writer.getBytesWritten();
+    LOG_DEBUG("逐帧处理：共{}帧 -> {}", writer.getFrameCount(), outputPath);
+    return ret < 0 ? 1002 : 0;
 }
 
-std::string ImageFlowProcessor::toFilterDesc(ProcessConfig const &config)
+void ImageFlowProcessor::writeTrace() const
 {
-    std::string desc{config.filterDesc};
-    std::string sizeStr;
-    if (config.targetWidth > 0 && config.targetHeight > 0)
+    if (mConfig.tracePath.empty())
+        return;
+
+    // 每次写出全部已记录的事件  覆盖上一次的文件
+    auto &tracer = Tracer::getInstance();
+    auto stats = tracer.getStats();
+    if (tracer.write(mConfig.tracePath))
     {
-        sizeStr = "scale=" + std::to_string(config.targetWidth) + ":" + std::to_string(config.targetHeight);
+        LOG_INFO("追踪：{} 个事件  {} 个线程  缓冲已满丢弃 {}  估算记录开销 {:.3f} 秒 -> {}",
+                 stats.events, stats.threads, stats.dropped, stats.overheadSeconds, mConfig.tracePath);
     }
+}
+
+std::string ImageFlowProcessor::makeFrameCacheKey(JobRequest const &request) const
+{
+    if (!mFrameCache.isEnabled())
+        return {};
+    if (!request.inputView.empty())
+        return FrameCache::makeMemoryKey(request.inputView.data(), request.inputView.size());
+    if (request.inputPath.empty())
+        return FrameCache::makeMemoryKey(request.inputData.data(), request.inputData.size());
+
+    std::string key;
+    return FrameCache::makeFileKey(request.inputPath, key) ? key : std::string{};
+}
+
+JobRequest ImageFlowProcessor::makeImageRequest(
+    std::string const &inputPath,
+    std::string const &outputFolder)
+{
+    JobRequest request;
+    request.inputPath = inputPath;
+    request.outputPath = geneOutputPath(outputFolder, inputPath, mConfig.outputFmt);
+    return request;
+}
+
+int ImageFlowProcessor::decideThreadCount(
+    ProcessConfig const &config,
+    int width, int height) const
+{
+    auto status = mThreadPool.getStatus();
+    size_t workers = std::max<size_t>(status.totalThreads, 1);
+
+    // 排队与执行中的任务已能占满所有核心时  只做图像间并行
+    size_t outstanding = std::max<size_t>(status.queueSize + status.activeTasks, 1);
+    if (outstanding >= workers)
+        return 1;
 
-    if (!desc.empty() && !sizeStr.empty())
-        desc = sizeStr + "," + desc;
-    else if (!sizeStr.empty())
-        desc = sizeStr;
-    return desc;
+    // 队列见底  空闲核心平分给执行中的图像  再按像素数限制避免小图白白开线程
+    int64_t share = static_cast<int64_t>(workers / outstanding);
+    int64_t byPixels = static_cast<int64_t>(width) * height / std::max<int64_t>(config.pixelsPerThread, 1);
+    int64_t threads = std::clamp<int64_t>(std::min(share, byPixels), 1, static_cast<int64_t>(workers));
+    if (config.maxThreadsPerImage > 0)
+        threads = std::min<int64_t>(threads, config.maxThreadsPerImage);
+
+    // 向下取整到2的幂  限制滤镜图缓存中按线程数区分的变体数量
+    int count = 1;
+    while (count * 2 <= threads)
+        count *= 2;
+    return count;
+}
+
+bool ImageFlowProcessor::isTileCandidate(
+    ProcessConfig const &config,
+    AVFrame const *frame)
+{
+    return config.tilePixelThreshold > 0 &&
+           static_cast<int64_t>(frame->width) * frame->height >= config.tilePixelThreshold;
+}
+
+TileOptions ImageFlowProcessor::makeTileOptions(
+    ProcessConfig const &config,
+    AVFrame const *frame,
+    FilterGraphOptions const &graphOptions)
+{
+    TileOptions options;
+    options.targetWidth = config.targetWidth;
+    options.targetHeight = config.targetHeight;
+    options.memoryBudget = config.tileMemoryBudget;
+    options.outputFmt = ImageEncoder::encoderPixelFormat(
+        ImageEncoder::encoderName(config.outputFmt),
+        static_cast<AVPixelFormat>(frame->format),
+        config.encoder);
+    options.graphOptions = graphOptions;
+    return options;
+}
+
+std::string ImageFlowProcessor::toFilterDesc(ProcessConfig const &config)
+{
+    // 源尺寸未知  按缩小规划（缩放在前）  实际处理时再按源尺寸重新规划
+    return FilterChainPlanner::plan(
+               config.filterDesc, 0, 0,
+               config.targetWidth, config.targetHeight)
+        .filterDesc;
 }
 
 std::string ImageFlowProcessor::geneOutputPath(
@@ -1,6 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 //--------------------------
 extern "C"
@@ -9,27 +20,213 @@ extern "C"
 }
 //--------------------------
 #include "FilterGraphPool.h"
+#include "FrameCache.h"
+#include "FrameReader.h"
+#include "ImageEncoder.h"
+#include "ImageProbe.h"
+#include "InstrumentedMutex.h"
+#include "MemoryBudget.h"
+#include "OutputCommitter.h"
+#include "Prefetcher.h"
+#include "ProfileScheduler.h"
 #include "ThreadPool.hpp"
+#include "ThreadPoolAutoscaler.h"
+#include "TileProcessor.h"
 
 namespace ImageFlow
 {
 
-// 
+// 批处理的提交顺序
+enum class ScheduleOrder
+{
+    SUBMIT,       // 按传入顺序
+    LARGEST_FIRST // 按估算代价从大到小（LPT）  缩短整批的完成时间
+};
+
+// 处理配置
 struct ProcessConfig
 {
     int targetWidth = 0;
     int targetHeight = 0;
     std::string filterDesc;
     std::string outputFmt;
+
+    // 图像内并行  大图在队列见底时使用编解码器与滤镜图的slice线程
+    int maxThreadsPerImage = 0;        // 单张图像的线程上限 0表示不限（受线程池大小约束）
+    int64_t pixelsPerThread = 2000000; // 每增加一个图像内线程所需的像素数
+
+    // 条带处理  超大图分条带送入滤镜图以限制峰值内存
+    int64_t tilePixelThreshold = 0;     // 达到该像素数的图像分条带处理 0表示关闭
+    size_t tileMemoryBudget = 64 << 20; // 单个条带的工作内存预算（字节）
+
+    // 缩放与色相使用原生快速路径代替libavfilter  输出与滤镜图不逐位一致  误差可用bench-fastpath查看
+    bool fastPath = false;
+
+    // 准入控制  按文件头估算每个任务的峰值内存  在途总量超出预算时推迟解码
+    // 批处理开始前逐个探测输入的文件头  只在指定预算时开启  可取Utils::memoryLimitBytes()的一半
+    int64_t memoryBudget = 0; // 在途内存预算（字节） 不大于0表示关闭
+
+    // 批处理调度  探测文件头估算代价（探测失败时以文件大小代替）
+    ScheduleOrder schedule = ScheduleOrder::SUBMIT;
+
+    // 动图与多页图像逐帧处理  动图格式输出为动图  其余格式按页输出  关闭时只处理第一帧
+    bool multiFrame = true;
+
+    // 解码帧缓存  同一输入以不同尺寸或格式再次处理时跳过解码  只取处理器的配置
+    int64_t frameCacheBytes = 0; // 缓存的字节预算 0表示关闭
+
+    // 线程池  只取处理器的配置
+    size_t threadCount = 0;        // 线程数 0表示取容器CPU配额
+    bool autoscaleThreads = false; // 按队列积压与CPU利用率自动增减线程
+
+    // 异步任务的文件读写放到单独的I/O线程池  计算线程池只做解码、滤镜与编码  只取处理器的配置
+    size_t ioThreads = 0; // I/O线程数 0表示CPU配额的4倍
+
+    // 输出先写临时文件再改名  按持久化策略刷盘  只取处理器的配置
+    Durability durability = Durability::NONE;
+    size_t groupCommitFiles = 64;                   // 组提交凑满该数量立即提交
+    std::chrono::milliseconds groupCommitDelay{20}; // 组提交凑批的最长等待时间
+
+    // 批处理时按处理顺序提前把后续输入读入页缓存  窗口随读取速率调整  只取处理器的配置
+    bool prefetch = false;
+
+    // 时间线追踪文件  非空时记录各线程的处理区间  只取处理器的配置
+    // 批处理结束与处理器析构时写出为Chrome trace-event JSON  同时存在的处理器共用一轮记录
+    std::string tracePath;
+    size_t traceEventsPerThread = 1 << 16; // 每个线程的事件上限  超出的事件丢弃并计数
+
+    // JPEG输入带有不小于目标尺寸且宽高比一致的内嵌缩略图（EXIF或JFXX）时只解码缩略图  需指定目标宽高
+    bool embeddedThumbnail = false;
+
+    // 不改变像素时直接输出源数据  不解码与编码
+    // 条件：滤镜为空或只有null、copy  目标尺寸未指定或与源相同  输出格式与输入的编码格式相同
+    //       编码参数为默认值（指定了预设或单项参数时重新编码）
+    //       输入为JPEG、PNG、GIF、BMP或WebP（按文件头判断  TIFF等其余格式重新编码）
+    bool passThrough = true;
+    bool stripMetadata = false; // 直通时去掉EXIF、XMP、文本块等元数据（保留ICC）  只支持JPEG与PNG  其余格式重新编码
+
+    // 编码参数  默认为均衡预设  可用ImageEncoder::fromPreset获取预设后再调整单项
+    EncoderOptions encoder;
+};
+
+/* 单个任务  输入为文件路径或内存中的图像数据 */
+struct JobRequest
+{
+    std::string inputPath;                       // 输入路径 为空时使用inputView或inputData
+    std::vector<uint8_t> inputData;              // 内存中的输入图像
+    std::span<uint8_t const> inputView;          // 调用者持有的输入（如映射的打包文件）  不复制  处理期间须保持有效
+    std::string outputPath;                      // 输出路径 为空时编码结果写入JobResult::outputData（只处理第一帧）
+    std::string profile;                         // 配置档名称  决定公平调度的队列与统计归属 为空时为默认配置档
+    std::shared_ptr<ProcessConfig const> config; // 按任务覆盖的配置 为空时使用配置档的配置
+};
+
+/* 任务结果  耗时均为微秒 */
+struct JobResult
+{
+    int status = 0;                  // 0表示成功 1001解码失败 1002处理失败 1003编码或写出失败 1004配置无效
+    uint64_t jobId = 0;              // 处理器分配的任务编号  追踪事件中的图像编号
+    int64_t queueUs = 0;             // 在线程池中排队的时间（同步调用为0）
+    int64_t ioUs = 0;                // 在I/O线程池中读取输入与写出结果（同步调用为0）
+    int64_t decodeUs = 0;            // 打开输入与解码
+    int64_t filterUs = 0;            // 缩放与滤镜
+    int64_t encodeUs = 0;            // 编码与写出（异步调用时写出计入ioUs）
+    int64_t elapsedUs = 0;           // 处理耗时（不含排队）
+    int64_t outputSize = 0;          // 输出字节数
+    std::vector<uint8_t> outputData; // 未指定输出路径时的编码结果
+};
+
+/* 执行器（线程池）的利用率 */
+struct ExecutorStats
+{
+    std::string name;         // io 或 compute
+    size_t threads = 0;       // 当前线程数
+    size_t queued = 0;        // 排队任务数
+    size_t active = 0;        // 执行中的任务数
+    double busySeconds = 0.0; // 累计执行任务的时间
+    double utilization = 0.0; // 自创建以来的利用率
+};
+
+/* 处理器的指标快照  各部分分别读取  彼此之间不保证一致 */
+struct ProcessorMetrics
+{
+    FilterGraphPoolMetrics graphPool;     // 滤镜图池
+    FrameCache::Stats frameCache;         // 解码帧缓存
+    Prefetcher::Stats prefetch;           // 输入预读
+    OutputCommitter::Stats outputCommit;  // 输出提交
+    std::vector<ExecutorStats> executors; // 计算与I/O线程池
+    std::vector<LockStats> locks;         // 热点锁的竞争  未定义IMAGEFLOW_LOCK_STATS时为空
+    size_t thumbnailJobs = 0;             // 由内嵌缩略图代替主图解码的任务数
+    size_t passThroughJobs = 0;           // 未解码直接输出源数据的任务数
 };
 
 class ImageFlowProcessor
 {
+private:
+    /* 批处理中的单个任务 */
+    struct ImageJob
+    {
+        std::string path;    // 输入路径
+        int64_t bytes = 0;   // 估算的峰值内存
+        double cost = 0.0;   // 估算的处理代价（等效像素数）
+        size_t bypassed = 0; // 被后续任务越过的次数
+    };
+
+    /* 异步任务  依次经过I/O线程池读取、计算线程池处理、I/O线程池写出 */
+    struct StagedJob
+    {
+        JobRequest request;
+        std::function<void(JobResult &&)> callback;
+        std::chrono::steady_clock::time_point submitted; // 提交时间
+        bool preloaded = false;                          // 输入由I/O线程预读  占用一个预读名额
+        int64_t reservedBytes = 0;                       // 预读缓冲从内存预算占用的字节数
+        bool keyed = false;                              // cacheKey已在I/O线程计算
+        std::string cacheKey;                            // 解码帧缓存的键
+        std::vector<uint8_t> input;                      // 预读的输入文件 帧缓存命中时为空
+        bool pendingWrite = false;                       // output等待I/O线程写出
+        std::string pendingCommit;                       // 直通复制的临时文件  代替output等待提交
+        std::vector<uint8_t> output;                     // 编码结果
+        int64_t computeUs = 0;                           // 计算阶段耗时
+        JobResult result;
+    };
+
+    /* 一次批处理的完成状态  只等待本批提交的任务 */
+    struct Batch
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        size_t remaining = 0;               // 未完成的任务数
+        std::atomic<int64_t> busyNanos = 0; // 累计处理耗时
+        std::atomic<size_t> failed = 0;     // 失败的任务数
+    };
+
 private:
     ProcessConfig mConfig;
     FilterGraphPool mFilterGraphPool;
-    ThreadPool mThreadPool;
+    TileProcessor mTileProcessor;
+    MemoryBudget mMemoryBudget;
+    FrameCache mFrameCache;
+    OutputCommitter mOutputCommitter;
+    ThreadPool mThreadPool;                            // 计算线程池  线程数按CPU配额
+    ThreadPool mIoPool;                                // I/O线程池  线程多于CPU数  阻塞在读写上时不占用计算线程
+    std::once_flag mIoPoolStarted;                     // I/O线程在首次异步处理时才创建  同步调用不需要
+    Prefetcher mPrefetcher;                            // 批处理输入的预取
+    ProfileScheduler mScheduler;                       // 异步任务按配置档公平送入线程池
+    std::unique_ptr<ThreadPoolAutoscaler> mAutoscaler; // 线程数自动调整 未启用时为空
     std::string mFilterDesc;
+    std::atomic<size_t> mThumbnailJobs = 0;   // 由内嵌缩略图生成输出的任务数
+    std::atomic<size_t> mPassThroughJobs = 0; // 直接输出源数据的任务数
+    std::atomic<uint64_t> mNextJobId = 0;     // 最近分配的任务编号
+
+    // 配置档  共享同一个线程池与滤镜图缓存
+    mutable std::mutex mProfilesMutex;
+    std::unordered_map<std::string, std::shared_ptr<ProcessConfig const>> mProfiles;
+
+    // 异步任务的阶段交接
+    std::mutex mStageMutex;
+    std::condition_variable mStageCondition;               // 异步任务全部完成通知
+    size_t mAsyncJobs = 0;                                 // 未完成的异步任务数
+    size_t mPreloaded = 0;                                 // 已预读、等待或正在计算的输入数
+    std::deque<std::shared_ptr<StagedJob>> mDeferredReads; // 预读名额用完时推迟的读取
 
 public:
     ImageFlowProcessor(ProcessConfig const &config);
@@ -41,19 +238,203 @@ public:
         std::string const &inputPath,
         std::string const &outputPath);
 
+    // 处理一批图像并等待完成  返回失败的图像数
     int processImages(
         std::vector<std::string> const &imagePaths,
         std::string const &outputFolder);
 
+    // 处理打包文件（tar或ImageFlow打包格式）中的全部图像  结果追加到打包文件outputPack
+    // 输入从映射区域直接解码  输出条目名为输入条目名换成输出格式的扩展名  返回失败的图像数  打包文件无法打开时返回-1
+    int processPack(
+        std::string const &inputPack,
+        std::string const &outputPack);
+
+    // 异步处理单张图像  多个调用者可共享同一个处理器  互不等待
+    std::future<JobResult> processImageAsync(
+        std::string const &inputPath,
+        std::string const &outputFolder);
+
+    // 完成后在工作线程中调用callback  callback中不应长时间阻塞
+    void processImageAsync(
+        std::string const &inputPath,
+        std::string const &outputFolder,
+        std::function<void(JobResult &&)> callback);
+
+    // 同步处理单个任务
+    JobResult processJob(JobRequest const &request);
+
+    std::future<JobResult> processJobAsync(JobRequest request);
+
+    // 读写在I/O线程池  解码、滤镜与编码在计算线程池  完成后在其中一个工作线程中调用callback
+    void processJobAsync(
+        JobRequest request,
+        std::function<void(JobResult &&)> callback);
+
+    ProcessConfig const &getConfig() const;
+
+    // 注册或替换配置档  weight为公平调度的轮转权重  配置无效时返回false
+    bool setProfile(
+        std::string const &name,
+        ProcessConfig const &config,
+        int weight = 1);
+
+    // 查找配置档  不存在时返回nullptr
+    std::shared_ptr<ProcessConfig const> getProfile(std::string const &name) const;
+
+    // 各配置档的调度统计
+    std::vector<ProfileScheduler::Stats> getProfileStats() const;
+
+    void printProfileStats() const;
+
+    FilterGraphPoolMetrics getGraphPoolMetrics() const;
+
+    FrameCache::Stats getFrameCacheStats() const;
+
+    void printFrameCacheStats() const;
+
+    // 计算与I/O两个线程池的利用率
+    std::vector<ExecutorStats> getExecutorStats() const;
+
+    void printExecutorStats() const;
+
+    Prefetcher::Stats getPrefetchStats() const;
+
+    OutputCommitter::Stats getOutputCommitStats() const;
+
+    // 由内嵌缩略图代替主图解码的任务数
+    size_t getThumbnailJobCount() const;
+
+    // 未解码直接输出源数据的任务数
+    size_t getPassThroughJobCount() const;
+
+    // 各热点锁的加锁次数、竞争次数、等待与持有时间  须以IMAGEFLOW_LOCK_STATS编译
+    std::vector<LockStats> getLockStats() const;
+
+    void printLockStats() const;
+
+    ProcessorMetrics getMetrics() const;
+
+    // 配置至少包含缩放或滤镜之一
+    static bool isValidConfig(ProcessConfig const &config);
+
 private:
-    AVFrame *decodeImage(std::string const &inputPath);
+    // 任务使用的配置  配置档不存在或任务自带的配置无效时返回nullptr  profileConfig持有配置档的配置
+    ProcessConfig const *resolveConfig(
+        JobRequest const &request,
+        std::shared_ptr<ProcessConfig const> &profileConfig) const;
+
+    // 执行任务  返回状态码  输出信息写入result
+    // staged不为空时使用I/O线程预读的输入  编码结果留给I/O线程写出
+    int executeJob(
+        JobRequest const &request,
+        JobResult &result,
+        StagedJob *staged = nullptr);
+
+    // 打开输入并解码第一帧  后续帧通过reader继续读取  preloaded不为空时从预读的数据解码
+    AVFrame *decodeImage(
+        ProcessConfig const &config,
+        FrameReader &reader,
+        JobRequest const &request,
+        std::vector<uint8_t> const *preloaded = nullptr);
+
+    // 已在内存中的输入数据  文件输入未预读时为空
+    static std::span<uint8_t const> inputBytes(JobRequest const &request, StagedJob const *staged);
 
-    bool encodeImage(
-        AVFrame *frame,
+    // 探测文件头判断能否直接输出源数据
+    bool canPassThrough(
+        ProcessConfig const &config,
+        JobRequest const &request,
+        StagedJob const *staged) const;
+
+    // 复制（或剥离元数据后写出）源数据  返回状态码  staged不为空时写出与提交留给I/O线程
+    int passThrough(
+        ProcessConfig const &config,
+        JobRequest const &request,
+        JobResult &result,
+        StagedJob *staged);
+
+    // 输入为JPEG且内嵌缩略图足以生成目标尺寸时取出缩略图数据  未启用或不满足条件时返回false
+    bool loadEmbeddedThumbnail(
+        ProcessConfig const &config,
+        JobRequest const &request,
+        StagedJob const *staged,
+        std::vector<uint8_t> &thumbnail) const;
+
+    // 异步任务的各阶段
+    void stageInput(std::shared_ptr<StagedJob> job);
+    void readInput(std::shared_ptr<StagedJob> const &job);
+    void runCompute(std::shared_ptr<StagedJob> const &job);
+    void writeOutput(std::shared_ptr<StagedJob> const &job);
+    void finishJob(std::shared_ptr<StagedJob> const &job);
+
+    // 创建I/O线程  只在第一次调用时生效
+    void ensureIoPool();
+
+    // 归还预读名额与占用的内存预算  有推迟的读取时送入I/O线程池
+    void releasePreload(StagedJob &job);
+
+    // 逐帧处理多帧图像  接管firstFrame与secondFrame
+    int processFrameStream(
+        ProcessConfig const &config,
+        FrameReader &reader,
+        AVFrame *firstFrame,
+        AVFrame *secondFrame,
         std::string const &outputPath,
-        std::string const &format);
+        JobResult &result);
+
+    // 提交单个任务  budgeted为true时任务结束后归还内存预算
+    void submitJob(
+        ImageJob const &job,
+        std::string const &outputFolder,
+        bool budgeted,
+        std::shared_ptr<Batch> const &batch);
+
+    // 在内存预算内提交任务  放不下的大图可被后面的小图越过
+    void submitWithinBudget(
+        std::vector<ImageJob> &jobs,
+        std::string const &outputFolder,
+        std::shared_ptr<Batch> const &batch);
+
+    // 根据文件头估算单个任务的峰值内存（字节）
+    int64_t estimateJobBytes(ImageInfo const &info) const;
+
+    // 根据文件头估算单个任务的处理代价
+    double estimateJobCost(ImageInfo const &info) const;
+
+    // 对比实际完成时间与按代价模拟的完成时间
+    void reportMakespan(
+        std::vector<double> const &submitCosts,
+        std::vector<double> const &scheduledCosts,
+        double busySeconds,
+        double elapsedSeconds) const;
+
+    // 配置了追踪文件时写出已记录的事件
+    void writeTrace() const;
+
+    // 解码帧缓存的键  缓存关闭或无法标识输入时返回空串
+    std::string makeFrameCacheKey(JobRequest const &request) const;
+
+    // 按处理器配置生成单张图像的任务
+    JobRequest makeImageRequest(
+        std::string const &inputPath,
+        std::string const &outputFolder);
+
+    // 根据图像像素数与剩余任务量决定图像内线程数
+    int decideThreadCount(
+        ProcessConfig const &config,
+        int width, int height) const;
+
+    // 是否达到条带处理的像素阈值
+    static bool isTileCandidate(
+        ProcessConfig const &config,
+        AVFrame const *frame);
+
+    static TileOptions makeTileOptions(
+        ProcessConfig const &config,
+        AVFrame const *frame,
+        FilterGraphOptions const &graphOptions);
 
-    std::string toFilterDesc(ProcessConfig const &config);
+    static std::string toFilterDesc(ProcessConfig const &config);
 
     std::string geneOutputPath(
         std::string const &outputFolder,
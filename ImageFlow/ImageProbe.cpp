@@ -0,0 +1,195 @@
+#include "ImageProbe.h"
+//--------------------------
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/codec_par.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+}
+//--------------------------
+#include "Defer.hpp"
+#include "JpegThumbnail.h"
+#include "Tracer.h"
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+uint8_t const kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+uint32_t loadBigEndian32(uint8_t const *p)
+{
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+uint32_t loadLittleEndian16(uint8_t const *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8;
+}
+
+uint32_t loadLittleEndian24(uint8_t const *p)
+{
+    return loadLittleEndian16(p) | uint32_t(p[2]) << 16;
+}
+
+uint32_t loadLittleEndian32(uint8_t const *p)
+{
+    return loadLittleEndian24(p) | uint32_t(p[3]) << 24;
+}
+
+bool parsePng(uint8_t const *data, size_t size, ImageInfo &info)
+{
+    // IHDR必须是第一个块  acTL在第一个IDAT之前  出现时为动态PNG
+    if (size < 33 || memcmp(data + 12, "IHDR", 4) != 0)
+        return false;
+    info.width = static_cast<int>(loadBigEndian32(data + 16));
+    info.height = static_cast<int>(loadBigEndian32(data + 20));
+    info.codecId = AV_CODEC_ID_PNG;
+    for (size_t pos = 8; pos + 8 <= size;)
+    {
+        size_t length = loadBigEndian32(data + pos);
+        char const *type = reinterpret_cast<char const *>(data + pos + 4);
+        if (memcmp(type, "acTL", 4) == 0)
+        {
+            info.codecId = AV_CODEC_ID_APNG;
+            break;
+        }
+        if (memcmp(type, "IDAT", 4) == 0 || length > size - pos - 8)
+            break;
+        pos += 12 + length;
+    }
+    return true;
+}
+
+bool parseWebp(uint8_t const *data, size_t size, ImageInfo &info)
+{
+    // RIFF头之后的第一个块：VP8（有损）、VP8L（无损）或VP8X（扩展  带画布尺寸）
+    if (size < 30)
+        return false;
+    uint8_t const *chunk = data + 12;
+    if (memcmp(chunk, "VP8 ", 4) == 0)
+    {
+        if (chunk[11] != 0x9D || chunk[12] != 0x01 || chunk[13] != 0x2A)
+            return false;
+        info.width = static_cast<int>(loadLittleEndian16(chunk + 14) & 0x3FFF);
+        info.height = static_cast<int>(loadLittleEndian16(chunk + 16) & 0x3FFF);
+    }
+    else if (memcmp(chunk, "VP8L", 4) == 0)
+    {
+        if (chunk[8] != 0x2F)
+            return false;
+        uint32_t bits = loadLittleEndian32(chunk + 9);
+        info.width = static_cast<int>((bits & 0x3FFF) + 1);
+        info.height = static_cast<int>(((bits >> 14) & 0x3FFF) + 1);
+    }
+    else if (memcmp(chunk, "VP8X", 4) == 0)
+    {
+        info.width = static_cast<int>(loadLittleEndian24(chunk + 12) + 1);
+        info.height = static_cast<int>(loadLittleEndian24(chunk + 15) + 1);
+    }
+    else
+        return false;
+    info.codecId = AV_CODEC_ID_WEBP;
+    return true;
+}
+
+} // namespace
+
+bool ImageProbe::probe(std::string const &inputPath, ImageInfo &info)
+{
+    TraceScope span("probe");
+    info = ImageInfo{};
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(std::filesystem::path{inputPath}, ec);
+    info.fileSize = ec ? 0 : static_cast<int64_t>(size);
+
+    AVFormatContext *formatCtx = nullptr;
+    DEFER({
+        if (formatCtx)
+            avformat_close_input(&formatCtx);
+    });
+
+    auto utf8Filename = Utils::localToUtf8(inputPath);
+    if (avformat_open_input(&formatCtx, utf8Filename.c_str(), nullptr, nullptr) < 0)
+        return false;
+
+    // 图像解封装器在打开时通常已从文件头得到尺寸  缺失时再查找流信息
+    auto findVideo = [&]() -> AVCodecParameters const *
+    {
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++)
+        {
+            auto codecpar = formatCtx->streams[i]->codecpar;
+            if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+                return codecpar;
+        }
+        return nullptr;
+    };
+    auto codecpar = findVideo();
+    if (!codecpar || codecpar->width <= 0 || codecpar->height <= 0)
+    {
+        if (avformat_find_stream_info(formatCtx, nullptr) < 0 || !(codecpar = findVideo()))
+            return false;
+    }
+
+    info.width = codecpar->width;
+    info.height = codecpar->height;
+    info.pixelFmt = static_cast<AVPixelFormat>(codecpar->format);
+    info.codecId = codecpar->codec_id;
+    return info.width > 0 && info.height > 0;
+}
+
+bool ImageProbe::probeHeader(uint8_t const *data, size_t size, ImageInfo &info)
+{
+    info = ImageInfo{};
+    bool ok = false;
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xD8)
+    {
+        ok = JpegThumbnail::imageSize(data, size, info.width, info.height);
+        info.codecId = AV_CODEC_ID_MJPEG;
+    }
+    else if (size >= sizeof(kPngSignature) && memcmp(data, kPngSignature, sizeof(kPngSignature)) == 0)
+    {
+        ok = parsePng(data, size, info);
+    }
+    else if (size >= 10 && (memcmp(data, "GIF87a", 6) == 0 || memcmp(data, "GIF89a", 6) == 0))
+    {
+        info.width = static_cast<int>(loadLittleEndian16(data + 6));
+        info.height = static_cast<int>(loadLittleEndian16(data + 8));
+        info.codecId = AV_CODEC_ID_GIF;
+        ok = true;
+    }
+    else if (size >= 26 && memcmp(data, "BM", 2) == 0)
+    {
+        // 高度为负表示自上而下存储
+        info.width = static_cast<int>(loadLittleEndian32(data + 18));
+        info.height = std::abs(static_cast<int32_t>(loadLittleEndian32(data + 22)));
+        info.codecId = AV_CODEC_ID_BMP;
+        ok = true;
+    }
+    else if (size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WEBP", 4) == 0)
+    {
+        ok = parseWebp(data, size, info);
+    }
+    return ok && info.width > 0 && info.height > 0;
+}
+
+int64_t ImageProbe::frameBytes(int width, int height, AVPixelFormat pixelFmt)
+{
+    if (width <= 0 || height <= 0)
+        return 0;
+    if (pixelFmt != AV_PIX_FMT_NONE)
+    {
+        int size = av_image_get_buffer_size(pixelFmt, width, height, 1);
+        if (size > 0)
+            return size;
+    }
+    return static_cast<int64_t>(width) * height * 4;
+}
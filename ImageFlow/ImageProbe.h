@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+//--------------------------
+extern "C"
+{
+#include <libavcodec/codec_id.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace ImageFlow
+{
+
+/* 图像头信息 */
+struct ImageInfo
+{
+    int width = 0;                            // 图像宽度
+    int height = 0;                           // 图像高度
+    AVPixelFormat pixelFmt = AV_PIX_FMT_NONE; // 解码后的像素格式 未知时为NONE
+    int64_t fileSize = 0;                     // 文件大小（字节）
+    AVCodecID codecId = AV_CODEC_ID_NONE;     // 编码格式
+};
+
+/* 图像头探测  只解析文件头  不解码像素 */
+class ImageProbe
+{
+public:
+    // 读取尺寸与像素格式  失败时只填写fileSize并返回false
+    static bool probe(std::string const &inputPath, ImageInfo &info);
+
+    // 从内存中的文件头读取尺寸与编码格式  不经过libavformat  不填写像素格式与fileSize
+    // 只识别JPEG（SOF）、PNG（IHDR  带acTL时为APNG）、GIF、BMP与WebP  其余格式返回false
+    static bool probeHeader(uint8_t const *data, size_t size, ImageInfo &info);
+
+    // 单帧解码后的字节数  像素格式未知时按每像素4字节估算
+    static int64_t frameBytes(int width, int height, AVPixelFormat pixelFmt);
+};
+
+} // namespace ImageFlow
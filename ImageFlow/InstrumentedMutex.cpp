@@ -0,0 +1,120 @@
+#include "InstrumentedMutex.h"
+//--------------------------
+#include <algorithm>
+#include <map>
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+// 合并同名统计
+void merge(LockStats &total, LockStats const &stats)
+{
+    total.acquisitions += stats.acquisitions;
+    total.contended += stats.contended;
+    total.waitNanos += stats.waitNanos;
+    total.maxHoldNanos = std::max(total.maxHoldNanos, stats.maxHoldNanos);
+}
+
+/* 所有锁的登记表  函数内静态  先于任何锁构造  晚于其析构 */
+struct LockRegistry
+{
+    std::mutex mutex;
+    std::vector<InstrumentedMutex *> live;    // 存活的锁
+    std::map<std::string, LockStats> retired; // 已析构的锁  按名称合并
+
+    static LockRegistry &get()
+    {
+        static LockRegistry registry;
+        return registry;
+    }
+};
+
+} // namespace
+
+InstrumentedMutex::InstrumentedMutex(char const *name)
+    : mName(name)
+{
+    auto &registry = LockRegistry::get();
+    std::lock_guard<std::mutex> _(registry.mutex);
+    registry.live.push_back(this);
+}
+
+InstrumentedMutex::~InstrumentedMutex()
+{
+    auto &registry = LockRegistry::get();
+    std::lock_guard<std::mutex> _(registry.mutex);
+    std::erase(registry.live, this);
+    auto &total = registry.retired[mName];
+    total.name = mName;
+    merge(total, getStats());
+}
+
+void InstrumentedMutex::lock()
+{
+    if (!mMutex.try_lock())
+    {
+        auto begin = Utils::nowNanos();
+        mMutex.lock();
+        mLockedAt = Utils::nowNanos();
+        mContended.fetch_add(1, std::memory_order_relaxed);
+        mWaitNanos.fetch_add(mLockedAt - begin, std::memory_order_relaxed);
+    }
+    else
+    {
+        mLockedAt = Utils::nowNanos();
+    }
+    mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool InstrumentedMutex::try_lock()
+{
+    if (!mMutex.try_lock())
+        return false;
+    mLockedAt = Utils::nowNanos();
+    mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void InstrumentedMutex::unlock()
+{
+    // 只有持有者写入最大值  无需比较交换
+    uint64_t hold = Utils::nowNanos() - mLockedAt;
+    if (hold > mMaxHoldNanos.load(std::memory_order_relaxed))
+        mMaxHoldNanos.store(hold, std::memory_order_relaxed);
+    mMutex.unlock();
+}
+
+LockStats InstrumentedMutex::getStats() const
+{
+    LockStats stats;
+    stats.name = mName;
+    stats.acquisitions = mAcquisitions.load(std::memory_order_relaxed);
+    stats.contended = mContended.load(std::memory_order_relaxed);
+    stats.waitNanos = mWaitNanos.load(std::memory_order_relaxed);
+    stats.maxHoldNanos = mMaxHoldNanos.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::vector<LockStats> InstrumentedMutex::collect()
+{
+    auto &registry = LockRegistry::get();
+    std::lock_guard<std::mutex> _(registry.mutex);
+    auto totals = registry.retired;
+    for (auto mutex : registry.live)
+    {
+        auto stats = mutex->getStats();
+        auto &total = totals[stats.name];
+        total.name = stats.name;
+        merge(total, stats);
+    }
+
+    std::vector<LockStats> ret;
+    ret.reserve(totals.size());
+    for (auto &&[name, stats] : totals)
+        ret.push_back(stats);
+    return ret;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ImageFlow
+{
+
+/* 单个锁的竞争统计  同名的锁合并 */
+struct LockStats
+{
+    std::string name;          // 锁名称
+    uint64_t acquisitions = 0; // 加锁次数
+    uint64_t contended = 0;    // 未能立即取得而等待的次数
+    uint64_t waitNanos = 0;    // 累计等待耗时
+    uint64_t maxHoldNanos = 0; // 单次持有的最长时间
+};
+
+/* 带统计的互斥锁
+ * 满足Lockable要求  可用于lock_guard、unique_lock与condition_variable_any
+ * 先try_lock  失败才计时等待  未竞争时的额外开销为两次读时钟与一次原子加
+ * 条件变量等待期间会解锁  不计入持有时间
+ * 构造时登记  析构时把统计并入同名的历史记录
+ */
+class InstrumentedMutex
+{
+private:
+    std::mutex mMutex;
+    char const *mName;                       // 须为字符串字面量
+    int64_t mLockedAt = 0;                   // 取得锁的时间（纳秒）  由锁本身保护
+    std::atomic<uint64_t> mAcquisitions = 0; // 以下计数在持有锁时更新  读取时不加锁
+    std::atomic<uint64_t> mContended = 0;
+    std::atomic<uint64_t> mWaitNanos = 0;
+    std::atomic<uint64_t> mMaxHoldNanos = 0;
+
+public:
+    explicit InstrumentedMutex(char const *name);
+    ~InstrumentedMutex();
+
+    InstrumentedMutex(InstrumentedMutex const &) = delete;
+    InstrumentedMutex &operator=(InstrumentedMutex const &) = delete;
+
+public:
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    LockStats getStats() const;
+
+    // 所有锁的统计  按名称合并并排序  包括已析构的锁
+    static std::vector<LockStats> collect();
+};
+
+// 以IMAGEFLOW_LOCK_STATS编译时  热点锁使用InstrumentedMutex  否则仍为std::mutex  没有任何额外开销
+#ifdef IMAGEFLOW_LOCK_STATS
+using ProfiledMutex = InstrumentedMutex;
+using ProfiledLock = std::unique_lock<InstrumentedMutex>;
+using ProfiledCondition = std::condition_variable_any;
+#else
+/* 与InstrumentedMutex相同的构造方式  名称不使用 */
+class ProfiledMutex : public std::mutex
+{
+public:
+    explicit ProfiledMutex(char const *) {}
+};
+using ProfiledLock = std::unique_lock<std::mutex>;
+using ProfiledCondition = std::condition_variable;
+#endif
+
+} // namespace ImageFlow
@@ -0,0 +1,221 @@
+#include "JobClient.h"
+//--------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+//--------------------------
+#include "JobProtocol.h"
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// 解析正整数  整个字符串须为数字
+bool parsePositive(std::string const &text, int &value)
+{
+    return Utils::parseNumber(text, value) && value > 0;
+}
+
+// 输出文件名沿用输入文件名  指定了输出格式时替换扩展名  重复提交时追加序号避免覆盖
+// 服务端按自己的工作目录解析相对路径  与输入一样转为绝对路径
+std::string makeOutputPath(
+    JobClient::ClientOptions const &options,
+    std::string const &input,
+    int round)
+{
+    std::filesystem::path path{input};
+    std::string extension = path.extension().string();
+    for (auto &&[key, value] : options.options)
+    {
+        if (key == "format")
+            extension = "." + value;
+    }
+    std::string name = path.stem().string();
+    if (options.repeat > 1)
+        name += "_" + std::to_string(round);
+    return std::filesystem::absolute(std::filesystem::path{options.outputFolder} / (name + extension)).string();
+}
+
+} // namespace
+
+bool JobClient::parseArgs(std::vector<std::string> const &args, ClientOptions &options)
+{
+    if (args.empty())
+        return false;
+    options.socketPath = args[0];
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        auto const &arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--inline")
+            options.inlineInput = true;
+        else if (arg == "-v")
+            options.verbose = true;
+        else if (arg == "--repeat" && hasValue)
+        {
+            if (!parsePositive(args[++i], options.repeat))
+                return false;
+        }
+        else if (arg == "--window" && hasValue)
+        {
+            if (!parsePositive(args[++i], options.window))
+                return false;
+        }
+        else if (arg == "--out" && hasValue)
+            options.outputFolder = args[++i];
+        else if (arg == "--set" && hasValue)
+        {
+            auto const &pair = args[++i];
+            auto pos = pair.find('=');
+            if (pos == std::string::npos)
+                return false;
+            options.options.emplace_back(pair.substr(0, pos), pair.substr(pos + 1));
+        }
+        else if (arg.starts_with("-"))
+            return false;
+        else
+            options.inputs.push_back(arg);
+    }
+    return !options.inputs.empty();
+}
+
+int JobClient::run(ClientOptions const &options)
+{
+    // 内联模式预先读入输入  计时不包含客户端读盘
+    std::vector<std::vector<uint8_t>> inputData;
+    if (options.inlineInput)
+    {
+        inputData.resize(options.inputs.size());
+        for (size_t i = 0; i < options.inputs.size(); ++i)
+        {
+            if (!Utils::readFile(options.inputs[i], inputData[i]))
+                return -1;
+        }
+    }
+
+    auto socket = JobProtocol::connectLocal(options.socketPath);
+    if (socket == JobProtocol::kInvalidSocket)
+    {
+        std::cerr << "无法连接任务服务：" << options.socketPath << std::endl;
+        return -1;
+    }
+
+    size_t total = options.inputs.size() * static_cast<size_t>(options.repeat);
+    std::vector<Clock::time_point> sendTimes(total);
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t inFlight = 0;
+    bool aborted = false;
+
+    auto begin = Clock::now();
+
+    // 发送线程按窗口流水线提交  接收在当前线程进行
+    std::thread sender([&]
+                       {
+        for (size_t jobId = 0; jobId < total; ++jobId)
+        {
+            size_t inputIdx = jobId % options.inputs.size();
+            JobProtocol::JobMessage message;
+            message.jobId = static_cast<uint32_t>(jobId);
+            message.options = options.options;
+            if (options.inlineInput)
+                message.inputData = inputData[inputIdx];
+            else
+                message.inputPath = std::filesystem::absolute(options.inputs[inputIdx]).string();
+            if (!options.outputFolder.empty())
+                message.outputPath = makeOutputPath(
+                    options, options.inputs[inputIdx], static_cast<int>(jobId / options.inputs.size()));
+            auto payload = JobProtocol::encodeJob(message);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]
+                               { return aborted || inFlight < static_cast<size_t>(options.window); });
+                if (aborted)
+                    return;
+                ++inFlight;
+                sendTimes[jobId] = Clock::now();
+            }
+            if (!JobProtocol::sendFrame(socket, JobProtocol::MessageType::JOB, payload))
+            {
+                std::cerr << "发送任务失败" << std::endl;
+                return;
+            }
+        } });
+
+    std::vector<double> latencies;
+    latencies.reserve(total);
+    size_t failed = 0;
+    int64_t serverUs = 0;
+    int64_t outputBytes = 0;
+    JobProtocol::MessageType type;
+    std::vector<uint8_t> payload;
+    while (latencies.size() < total &&
+           JobProtocol::recvFrame(socket, type, payload))
+    {
+        JobProtocol::ReplyMessage reply;
+        if (type != JobProtocol::MessageType::REPLY ||
+            !JobProtocol::decodeReply(payload, reply) ||
+            reply.jobId >= total)
+        {
+            std::cerr << "收到无法解析的回复" << std::endl;
+            break;
+        }
+
+        Clock::time_point sent;
+        {
+            std::lock_guard<std::mutex> _(mutex);
+            sent = sendTimes[reply.jobId];
+            --inFlight;
+        }
+        condition.notify_one();
+
+        double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - sent).count();
+        latencies.push_back(latencyMs);
+        serverUs += reply.elapsedUs;
+        outputBytes += reply.outputSize;
+        if (reply.status != 0)
+            ++failed;
+        if (options.verbose)
+        {
+            printf("#%u %s 状态 %d  延迟 %.2f ms  服务端 %.2f ms  输出 %lld 字节\n",
+                   reply.jobId, options.inputs[reply.jobId % options.inputs.size()].c_str(),
+                   reply.status, latencyMs, reply.elapsedUs / 1000.0,
+                   static_cast<long long>(reply.outputSize));
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    {
+        std::lock_guard<std::mutex> _(mutex);
+        aborted = true;
+    }
+    condition.notify_all();
+    // 未收齐回复时关闭连接  使阻塞在发送中的线程退出
+    if (latencies.size() < total)
+        JobProtocol::shutdownSocket(socket);
+    sender.join();
+    JobProtocol::closeSocket(socket);
+
+    size_t done = latencies.size();
+    std::sort(latencies.begin(), latencies.end());
+    printf("任务 %zu/%zu  失败 %zu  窗口 %d  %s输入\n",
+           done, total, failed, options.window, options.inlineInput ? "内联" : "路径");
+    printf("耗时 %.3f s  吞吐 %.1f 张/s  输出 %.2f MB\n",
+           seconds, seconds > 0 ? done / seconds : 0.0, outputBytes / 1048576.0);
+    printf("延迟 ms  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f  服务端均值 %.2f\n",
+           Utils::percentile(latencies, 0.50), Utils::percentile(latencies, 0.90),
+           Utils::percentile(latencies, 0.99), latencies.empty() ? 0.0 : latencies.back(),
+           done ? serverUs / 1000.0 / done : 0.0);
+    return done == total && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ImageFlow
+{
+namespace JobClient
+{
+
+/* 客户端参数 */
+struct ClientOptions
+{
+    std::string socketPath;                                   // 服务端套接字路径
+    std::vector<std::string> inputs;                          // 输入文件
+    std::string outputFolder;                                 // 输出目录 为空时结果随回复返回且不落盘
+    std::vector<std::pair<std::string, std::string>> options; // 按任务覆盖的配置
+    bool inlineInput = false;                                 // 以内联字节发送输入（服务端无需访问输入路径）
+    int repeat = 1;                                           // 输入列表的重复次数
+    int window = 16;                                          // 在途任务上限
+    bool verbose = false;                                     // 逐个打印任务结果
+};
+
+// 连接服务端流水线提交任务  打印吞吐量与延迟分位数
+// 全部任务成功时返回0
+int run(ClientOptions const &options);
+
+// 解析子命令参数 <套接字> [--inline] [--repeat N] [--window N] [--out 目录] [--set 键=值] [-v] 文件...
+bool parseArgs(std::vector<std::string> const &args, ClientOptions &options);
+
+} // namespace JobClient
+} // namespace ImageFlow
@@ -0,0 +1,431 @@
+#include "JobProtocol.h"
+//--------------------------
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+//--------------------------
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace ImageFlow;
+
+namespace
+{
+
+//----------------------------------------------------------------
+// 负载编解码
+
+class Writer
+{
+private:
+    std::vector<uint8_t> &mOut;
+
+public:
+    explicit Writer(std::vector<uint8_t> &out) : mOut(out) {}
+
+    template <typename T>
+    void integer(T value)
+    {
+        for (size_t i = 0; i < sizeof(T); ++i)
+            mOut.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+
+    void bytes(void const *data, size_t size)
+    {
+        integer<uint32_t>(static_cast<uint32_t>(size));
+        auto p = static_cast<uint8_t const *>(data);
+        mOut.insert(mOut.end(), p, p + size);
+    }
+
+    void string(std::string const &s)
+    {
+        bytes(s.data(), s.size());
+    }
+};
+
+class Reader
+{
+private:
+    std::vector<uint8_t> const &mIn;
+    size_t mPos = 0;
+    bool mOk = true;
+
+public:
+    explicit Reader(std::vector<uint8_t> const &in) : mIn(in) {}
+
+    bool ok() const
+    {
+        return mOk && mPos == mIn.size();
+    }
+
+    template <typename T>
+    T integer()
+    {
+        if (mPos + sizeof(T) > mIn.size())
+        {
+            mOk = false;
+            return T{};
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+            value |= static_cast<uint64_t>(mIn[mPos + i]) << (8 * i);
+        mPos += sizeof(T);
+        return static_cast<T>(value);
+    }
+
+    std::vector<uint8_t> bytes()
+    {
+        auto size = integer<uint32_t>();
+        if (!mOk || mPos + size > mIn.size())
+        {
+            mOk = false;
+            return {};
+        }
+        std::vector<uint8_t> out(mIn.begin() + mPos, mIn.begin() + mPos + size);
+        mPos += size;
+        return out;
+    }
+
+    std::string string()
+    {
+        auto raw = bytes();
+        return {raw.begin(), raw.end()};
+    }
+};
+
+//----------------------------------------------------------------
+// 套接字
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+
+constexpr int kSendFlags = 0;
+
+void ensureStartup()
+{
+    static std::once_flag once;
+    std::call_once(once, []
+                   { WSADATA data; WSAStartup(MAKEWORD(2, 2), &data); });
+}
+
+NativeSocket native(JobProtocol::Socket socket)
+{
+    return socket == JobProtocol::kInvalidSocket ? INVALID_SOCKET : static_cast<NativeSocket>(socket);
+}
+#else
+using NativeSocket = int;
+
+// 对端已关闭时send返回错误而不是触发SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+void ensureStartup() {}
+
+NativeSocket native(JobProtocol::Socket socket)
+{
+    return static_cast<NativeSocket>(socket);
+}
+#endif
+
+// 按错误码区分accept失败能否重试
+JobProtocol::AcceptError classifyAcceptError()
+{
+#ifdef _WIN32
+    switch (WSAGetLastError())
+    {
+    case WSAEINTR:
+    case WSAECONNRESET:
+    case WSAEWOULDBLOCK:
+        return JobProtocol::AcceptError::RETRY;
+    case WSAEMFILE:
+    case WSAENOBUFS:
+        return JobProtocol::AcceptError::BACKOFF;
+    default:
+        return JobProtocol::AcceptError::FATAL;
+    }
+#else
+    switch (errno)
+    {
+    case EINTR:
+    case ECONNABORTED:
+    case EAGAIN:
+    case EPROTO:
+    case EPERM: // 被防火墙规则拒绝
+        return JobProtocol::AcceptError::RETRY;
+    case EMFILE:
+    case ENFILE:
+    case ENOBUFS:
+    case ENOMEM:
+        return JobProtocol::AcceptError::BACKOFF;
+    default:
+        return JobProtocol::AcceptError::FATAL;
+    }
+#endif
+}
+
+bool makeAddress(std::string const &path, sockaddr_un &addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+bool sendAll(JobProtocol::Socket socket, uint8_t const *data, size_t size)
+{
+    while (size > 0)
+    {
+        auto sent = send(native(socket), reinterpret_cast<char const *>(data), static_cast<int>(size), kSendFlags);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recvAll(JobProtocol::Socket socket, uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        auto received = recv(native(socket), reinterpret_cast<char *>(data), static_cast<int>(size), 0);
+        if (received <= 0)
+            return false;
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<uint8_t> JobProtocol::encodeJob(JobMessage const &message)
+{
+    std::vector<uint8_t> payload;
+    Writer writer(payload);
+    writer.integer<uint32_t>(message.jobId);
+    writer.string(message.inputPath);
+    writer.string(message.outputPath);
+    writer.integer<uint16_t>(static_cast<uint16_t>(message.options.size()));
+    for (auto &&[key, value] : message.options)
+    {
+        writer.string(key);
+        writer.string(value);
+    }
+    writer.bytes(message.inputData.data(), message.inputData.size());
+    return payload;
+}
+
+bool JobProtocol::decodeJob(std::vector<uint8_t> const &payload, JobMessage &message)
+{
+    Reader reader(payload);
+    message.jobId = reader.integer<uint32_t>();
+    message.inputPath = reader.string();
+    message.outputPath = reader.string();
+    auto count = reader.integer<uint16_t>();
+    message.options.clear();
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        auto key = reader.string();
+        auto value = reader.string();
+        message.options.emplace_back(std::move(key), std::move(value));
+    }
+    message.inputData = reader.bytes();
+    return reader.ok();
+}
+
+std::vector<uint8_t> JobProtocol::encodeReply(ReplyMessage const &message)
+{
+    std::vector<uint8_t> payload;
+    Writer writer(payload);
+    writer.integer<uint32_t>(message.jobId);
+    writer.integer<int32_t>(message.status);
+    writer.integer<int64_t>(message.elapsedUs);
+    writer.integer<int64_t>(message.outputSize);
+    writer.bytes(message.outputData.data(), message.outputData.size());
+    return payload;
+}
+
+bool JobProtocol::decodeReply(std::vector<uint8_t> const &payload, ReplyMessage &message)
+{
+    Reader reader(payload);
+    message.jobId = reader.integer<uint32_t>();
+    message.status = reader.integer<int32_t>();
+    message.elapsedUs = reader.integer<int64_t>();
+    message.outputSize = reader.integer<int64_t>();
+    message.outputData = reader.bytes();
+    return reader.ok();
+}
+
+JobProtocol::Socket JobProtocol::listenLocal(std::string const &path)
+{
+    ensureStartup();
+    sockaddr_un addr;
+    if (!makeAddress(path, addr))
+        return kInvalidSocket;
+
+    auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    Socket socket = static_cast<Socket>(fd);
+#ifdef _WIN32
+    if (fd == INVALID_SOCKET)
+        return kInvalidSocket;
+    DeleteFileA(path.c_str());
+#else
+    if (fd < 0)
+        return kInvalidSocket;
+    unlink(path.c_str());
+#endif
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        closeSocket(socket);
+        return kInvalidSocket;
+    }
+#ifndef _WIN32
+    // 在listen之前收紧权限  此前无法建立连接  不存在竞争窗口
+    if (chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0)
+    {
+        closeSocket(socket);
+        unlink(path.c_str());
+        return kInvalidSocket;
+    }
+#endif
+    if (listen(fd, SOMAXCONN) != 0)
+    {
+        closeSocket(socket);
+        return kInvalidSocket;
+    }
+    return socket;
+}
+
+JobProtocol::Socket JobProtocol::acceptLocal(Socket listener, AcceptError *error)
+{
+    auto fd = accept(native(listener), nullptr, nullptr);
+#ifdef _WIN32
+    bool failed = fd == INVALID_SOCKET;
+#else
+    bool failed = fd < 0;
+#endif
+    if (error)
+        *error = failed ? classifyAcceptError() : AcceptError::NONE;
+    return failed ? kInvalidSocket : static_cast<Socket>(fd);
+}
+
+JobProtocol::Socket JobProtocol::connectLocal(std::string const &path)
+{
+    ensureStartup();
+    sockaddr_un addr;
+    if (!makeAddress(path, addr))
+        return kInvalidSocket;
+
+    auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    Socket socket = static_cast<Socket>(fd);
+#ifdef _WIN32
+    if (fd == INVALID_SOCKET)
+        return kInvalidSocket;
+#else
+    if (fd < 0)
+        return kInvalidSocket;
+#endif
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        closeSocket(socket);
+        return kInvalidSocket;
+    }
+    return socket;
+}
+
+bool JobProtocol::isPeerSameUser(Socket socket)
+{
+#if defined(SO_PEERCRED)
+    ucred cred{};
+    socklen_t length = sizeof(cred);
+    return getsockopt(native(socket), SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0 &&
+           cred.uid == getuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    uid_t uid = 0;
+    gid_t gid = 0;
+    return getpeereid(native(socket), &uid, &gid) == 0 && uid == getuid();
+#else
+    (void)socket;
+    return true;
+#endif
+}
+
+void JobProtocol::closeSocket(Socket &socket)
+{
+    if (socket == kInvalidSocket)
+        return;
+#ifdef _WIN32
+    closesocket(native(socket));
+#else
+    close(native(socket));
+#endif
+    socket = kInvalidSocket;
+}
+
+void JobProtocol::shutdownSocket(Socket socket)
+{
+    if (socket == kInvalidSocket)
+        return;
+#ifdef _WIN32
+    shutdown(native(socket), SD_BOTH);
+#else
+    shutdown(native(socket), SHUT_RDWR);
+#endif
+}
+
+bool JobProtocol::sendFrame(Socket socket, MessageType type, std::vector<uint8_t> const &payload)
+{
+    if (payload.size() > kMaxFrameSize)
+        return false;
+
+    uint8_t header[5];
+    auto size = static_cast<uint32_t>(payload.size());
+    for (int i = 0; i < 4; ++i)
+        header[i] = static_cast<uint8_t>(size >> (8 * i));
+    header[4] = static_cast<uint8_t>(type);
+    return sendAll(socket, header, sizeof(header)) &&
+           sendAll(socket, payload.data(), payload.size());
+}
+
+bool JobProtocol::recvFrame(Socket socket, MessageType &type, std::vector<uint8_t> &payload)
+{
+    uint8_t header[5];
+    if (!recvAll(socket, header, sizeof(header)))
+        return false;
+
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i)
+        size |= static_cast<uint32_t>(header[i]) << (8 * i);
+    if (size > kMaxFrameSize)
+        return false;
+
+    // 随数据到达逐块扩大缓冲  长度字段不可信  不预先按声明的长度分配
+    constexpr size_t kChunkSize = 1u << 20;
+    type = static_cast<MessageType>(header[4]);
+    payload.clear();
+    while (payload.size() < size)
+    {
+        size_t offset = payload.size();
+        size_t chunk = std::min<size_t>(size - offset, kChunkSize);
+        payload.resize(offset + chunk);
+        if (!recvAll(socket, payload.data() + offset, chunk))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ImageFlow
+{
+namespace JobProtocol
+{
+
+// 帧格式：u32负载长度（小端） + u8消息类型 + 负载
+// 负载中的整数均为小端  字符串与字节串为u32长度 + 数据
+enum class MessageType : uint8_t
+{
+    JOB = 1,   // 客户端提交任务
+    REPLY = 2, // 服务端逐个返回任务结果
+};
+
+constexpr uint32_t kMaxFrameSize = 256u << 20; // 单帧负载上限
+
+/* 任务消息 */
+struct JobMessage
+{
+    uint32_t jobId = 0;                                       // 客户端分配的任务编号  回复中原样返回
+    std::string inputPath;                                    // 输入路径 为空时使用inputData
+    std::string outputPath;                                   // 输出路径 为空时编码结果随回复返回
+    std::vector<std::pair<std::string, std::string>> options; // 按任务覆盖的配置 profile/width/height/filter/format/preset/multiframe/passthrough/strip
+    std::vector<uint8_t> inputData;                           // 内联的输入图像
+};
+
+/* 回复消息 */
+struct ReplyMessage
+{
+    uint32_t jobId = 0;              // 任务编号
+    int32_t status = 0;              // 任务状态码 0表示成功
+    int64_t elapsedUs = 0;           // 服务端处理耗时（微秒）
+    int64_t outputSize = 0;          // 输出字节数
+    std::vector<uint8_t> outputData; // 未指定输出路径时的编码结果
+};
+
+std::vector<uint8_t> encodeJob(JobMessage const &message);
+bool decodeJob(std::vector<uint8_t> const &payload, JobMessage &message);
+
+std::vector<uint8_t> encodeReply(ReplyMessage const &message);
+bool decodeReply(std::vector<uint8_t> const &payload, ReplyMessage &message);
+
+//----------------------------------------------------------------
+// 本地套接字（Unix域套接字  Windows 10起同样支持AF_UNIX）
+
+using Socket = intptr_t;
+constexpr Socket kInvalidSocket = -1;
+
+// accept失败的原因
+enum class AcceptError
+{
+    NONE,
+    RETRY,   // 暂时性错误（被信号中断、连接在接受前中止）  可立即重试
+    BACKOFF, // 描述符或内存耗尽  稍后重试
+    FATAL,   // 监听套接字已关闭或无效
+};
+
+// 监听指定路径  已存在的套接字文件会被删除
+// 套接字文件权限为0600  只有同一用户可以连接
+Socket listenLocal(std::string const &path);
+
+// 接受连接  失败时返回kInvalidSocket  error给出失败原因
+Socket acceptLocal(Socket listener, AcceptError *error = nullptr);
+
+Socket connectLocal(std::string const &path);
+
+// 对端进程是否与本进程属于同一用户  无法取得对端凭据的平台返回true
+bool isPeerSameUser(Socket socket);
+
+void closeSocket(Socket &socket);
+
+// 中断阻塞中的读写与accept
+void shutdownSocket(Socket socket);
+
+bool sendFrame(Socket socket, MessageType type, std::vector<uint8_t> const &payload);
+
+// 读取一帧  对端关闭或出错时返回false  负载缓冲随实际收到的数据增长
+bool recvFrame(Socket socket, MessageType &type, std::vector<uint8_t> &payload);
+
+} // namespace JobProtocol
+} // namespace ImageFlow
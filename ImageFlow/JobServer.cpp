@@ -0,0 +1,349 @@
+#include "JobServer.h"
+//--------------------------
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <thread>
+//--------------------------
+#include "ImageEncoder.h"
+
+using namespace ImageFlow;
+
+/* 连接状态  由连接线程、写线程与任务回调共同持有 */
+struct JobServer::Connection
+{
+    JobProtocol::Socket socket = JobProtocol::kInvalidSocket;
+    std::mutex mutex;                         // 保护以下状态
+    std::condition_variable condition;        // 回复入队与写出通知
+    size_t pending = 0;                       // 尚未写出回复的任务数
+    std::deque<std::vector<uint8_t>> replies; // 待写出的回复负载
+    bool closing = false;                     // 读取已结束  回复写完后写线程退出
+};
+
+namespace
+{
+
+bool parseInt(std::string const &text, int &value)
+{
+    auto end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && ptr == end && value >= 0;
+}
+
+} // namespace
+
+JobServer::JobServer(
+    ImageFlowProcessor &processor,
+    std::string socketPath,
+    size_t maxPendingPerConnection)
+    : mProcessor(processor),
+      mSocketPath(std::move(socketPath)),
+      mMaxPendingPerConnection(std::max<size_t>(maxPendingPerConnection, 1)),
+      mListener(JobProtocol::kInvalidSocket)
+{
+}
+
+JobServer::~JobServer()
+{
+    stop();
+}
+
+int JobServer::run()
+{
+    auto listener = JobProtocol::listenLocal(mSocketPath);
+    if (listener == JobProtocol::kInvalidSocket)
+    {
+        std::cerr << "无法监听套接字：" << mSocketPath << std::endl;
+        return -1;
+    }
+    mListener = listener;
+    std::cout << "任务服务已启动：" << mSocketPath << std::endl;
+
+    while (!mStopping)
+    {
+        // 暂时性错误立即重试  描述符耗尽时等待连接关闭释放  只有停止或监听套接字失效才退出
+        JobProtocol::AcceptError error;
+        auto socket = JobProtocol::acceptLocal(listener, &error);
+        if (socket == JobProtocol::kInvalidSocket)
+        {
+            if (mStopping || error == JobProtocol::AcceptError::FATAL)
+                break;
+            if (error == JobProtocol::AcceptError::BACKOFF)
+            {
+                std::cerr << "接受连接时资源不足  稍后重试" << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+        // 套接字文件权限之外再核对对端用户  防止其他用户借服务进程读写文件
+        if (!JobProtocol::isPeerSameUser(socket))
+        {
+            std::cerr << "拒绝其他用户的连接" << std::endl;
+            JobProtocol::closeSocket(socket);
+            continue;
+        }
+
+        auto connection = std::make_shared<Connection>();
+        connection->socket = socket;
+        {
+            std::lock_guard<std::mutex> _(mMutex);
+            if (mStopping)
+            {
+                JobProtocol::closeSocket(connection->socket);
+                break;
+            }
+            mConnections.push_back(connection);
+        }
+        std::thread(&JobServer::serve, this, std::move(connection)).detach();
+    }
+
+    // 等待所有连接线程退出（其中会等待各自的在途任务）
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]
+                    { return mConnections.empty(); });
+    lock.unlock();
+
+    if (auto socket = mListener.exchange(JobProtocol::kInvalidSocket);
+        socket != JobProtocol::kInvalidSocket)
+        JobProtocol::closeSocket(socket);
+    mProcessor.printProfileStats();
+    mProcessor.printFrameCacheStats();
+    mProcessor.printExecutorStats();
+    mProcessor.printLockStats();
+    return 0;
+}
+
+void JobServer::stop()
+{
+    if (mStopping.exchange(true))
+        return;
+
+    // 中断阻塞中的accept与recv  连接线程随后自行收尾
+    JobProtocol::shutdownSocket(mListener);
+    std::lock_guard<std::mutex> _(mMutex);
+    for (auto &&connection : mConnections)
+        JobProtocol::shutdownSocket(connection->socket);
+}
+
+bool JobServer::setAllowedRoots(std::vector<std::string> const &roots)
+{
+    mAllowedRoots.clear();
+    for (auto &&root : roots)
+    {
+        std::error_code ec;
+        auto canonical = std::filesystem::canonical(root, ec);
+        if (ec || !std::filesystem::is_directory(canonical, ec))
+        {
+            std::cerr << "无效的允许目录：" << root << std::endl;
+            return false;
+        }
+        mAllowedRoots.push_back(std::move(canonical));
+    }
+    return true;
+}
+
+bool JobServer::applyOption(
+    ProcessConfig &config,
+    std::string const &key,
+    std::string const &value)
+{
+    if (key == "width")
+        return parseInt(value, config.targetWidth);
+    if (key == "height")
+        return parseInt(value, config.targetHeight);
+    if (key == "filter")
+        config.filterDesc = value;
+    else if (key == "format")
+    {
+        // 未知格式会按PNG编码  写出扩展名与内容不符的文件
+        if (!ImageEncoder::isKnownFormat(value))
+            return false;
+        config.outputFmt = value;
+    }
+    else if (key == "preset")
+    {
+        EncodePreset preset;
+        if (!ImageEncoder::parsePreset(value, preset))
+            return false;
+        config.encoder = ImageEncoder::fromPreset(preset);
+    }
+    else if (key == "multiframe")
+        config.multiFrame = value != "0";
+    else if (key == "passthrough")
+        config.passThrough = value != "0";
+    else if (key == "strip")
+        config.stripMetadata = value != "0";
+    else
+        return false;
+    return true;
+}
+
+void JobServer::serve(std::shared_ptr<Connection> connection)
+{
+    std::thread writer(&JobServer::sendReplies, connection);
+
+    JobProtocol::MessageType type;
+    std::vector<uint8_t> payload;
+    while (JobProtocol::recvFrame(connection->socket, type, payload))
+    {
+        JobProtocol::JobMessage message;
+        if (type != JobProtocol::MessageType::JOB ||
+            !JobProtocol::decodeJob(payload, message))
+        {
+            std::cerr << "收到无法解析的任务帧  断开连接" << std::endl;
+            break;
+        }
+
+        JobRequest request;
+        if (!makeRequest(message, request))
+        {
+            {
+                std::lock_guard<std::mutex> _(connection->mutex);
+                ++connection->pending;
+            }
+            reply(*connection, {message.jobId, 1004});
+            continue;
+        }
+
+        // 在途任务达到上限时暂停读取  背压传递给客户端
+        {
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->condition.wait(lock, [&]
+                                       { return connection->pending < mMaxPendingPerConnection; });
+            ++connection->pending;
+        }
+
+        mProcessor.processJobAsync(
+            std::move(request),
+            [connection, jobId = message.jobId](JobResult &&result)
+            {
+                JobProtocol::ReplyMessage replyMessage;
+                replyMessage.jobId = jobId;
+                replyMessage.status = result.status;
+                replyMessage.elapsedUs = result.elapsedUs;
+                replyMessage.outputSize = result.outputSize;
+                replyMessage.outputData = std::move(result.outputData);
+                reply(*connection, replyMessage);
+            });
+    }
+
+    // 对端关闭后等待在途任务的回复写完再关闭套接字
+    {
+        std::unique_lock<std::mutex> lock(connection->mutex);
+        connection->condition.wait(lock, [&]
+                                   { return connection->pending == 0; });
+        connection->closing = true;
+        connection->condition.notify_all();
+    }
+    writer.join();
+
+    // 在锁内关闭  避免stop对已关闭的描述符调用shutdown
+    std::lock_guard<std::mutex> _(mMutex);
+    JobProtocol::closeSocket(connection->socket);
+    std::erase(mConnections, connection);
+    mCondition.notify_all();
+}
+
+bool JobServer::isAllowedPath(std::string const &path) const
+{
+    if (mAllowedRoots.empty() || path.empty())
+        return true;
+
+    // 已存在的部分解析符号链接  ".."随之消去
+    std::error_code ec;
+    auto resolved = std::filesystem::weakly_canonical(std::filesystem::absolute(path, ec), ec);
+    if (ec)
+        return false;
+    for (auto &&root : mAllowedRoots)
+    {
+        if (std::mismatch(root.begin(), root.end(), resolved.begin(), resolved.end()).first == root.end())
+            return true;
+    }
+    return false;
+}
+
+bool JobServer::makeRequest(
+    JobProtocol::JobMessage &message,
+    JobRequest &request) const
+{
+    if (message.inputPath.empty() && message.inputData.empty())
+        return false;
+    if (!isAllowedPath(message.inputPath) || !isAllowedPath(message.outputPath))
+    {
+        std::cerr << "任务路径不在允许的目录内" << std::endl;
+        return false;
+    }
+
+    request.inputPath = std::move(message.inputPath);
+    request.inputData = std::move(message.inputData);
+    request.outputPath = std::move(message.outputPath);
+
+    // 配置档决定调度队列  其余选项在配置档（或服务端配置）的基础上覆盖
+    std::shared_ptr<ProcessConfig const> base;
+    size_t overrides = 0;
+    for (auto &&[key, value] : message.options)
+    {
+        if (key != "profile")
+        {
+            ++overrides;
+            continue;
+        }
+        if (!(base = mProcessor.getProfile(value)))
+        {
+            std::cerr << "未知的配置档：" << value << std::endl;
+            return false;
+        }
+        request.profile = value;
+    }
+    if (overrides == 0)
+        return true;
+
+    auto config = std::make_shared<ProcessConfig>(base ? *base : mProcessor.getConfig());
+    for (auto &&[key, value] : message.options)
+    {
+        if (key != "profile" && !applyOption(*config, key, value))
+        {
+            std::cerr << "无效的任务选项：" << key << "=" << value << std::endl;
+            return false;
+        }
+    }
+    if (!ImageFlowProcessor::isValidConfig(*config))
+        return false;
+    request.config = std::move(config);
+    return true;
+}
+
+void JobServer::reply(
+    Connection &connection,
+    JobProtocol::ReplyMessage const &message)
+{
+    auto payload = JobProtocol::encodeReply(message);
+    std::lock_guard<std::mutex> _(connection.mutex);
+    connection.replies.push_back(std::move(payload));
+    connection.condition.notify_all();
+}
+
+void JobServer::sendReplies(std::shared_ptr<Connection> connection)
+{
+    bool broken = false;
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    while (true)
+    {
+        connection->condition.wait(lock, [&]
+                                   { return !connection->replies.empty() || connection->closing; });
+        if (connection->replies.empty())
+            break;
+        auto payload = std::move(connection->replies.front());
+        connection->replies.pop_front();
+
+        // 写出时不持锁  对端不读取时只阻塞本连接的写线程
+        lock.unlock();
+        if (!broken && !JobProtocol::sendFrame(connection->socket, JobProtocol::MessageType::REPLY, payload))
+            broken = true; // 写出失败后丢弃其余回复  在途计数照常递减
+        lock.lock();
+        --connection->pending;
+        connection->condition.notify_all();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+//--------------------------
+#include "ImageFlowProcessor.h"
+#include "JobProtocol.h"
+
+namespace ImageFlow
+{
+
+/* 任务服务
+ * 常驻进程监听本地套接字  复用同一个处理器的线程池与滤镜图缓存
+ * 每个连接可流水线提交任务  结果按完成顺序逐个回复
+ */
+class JobServer
+{
+private:
+    struct Connection;
+
+private:
+    ImageFlowProcessor &mProcessor;
+    std::string mSocketPath;                               // 监听路径
+    size_t mMaxPendingPerConnection;                       // 单个连接的在途任务上限  超出时暂停读取
+    std::atomic<JobProtocol::Socket> mListener;            // 监听套接字
+    std::atomic<bool> mStopping = false;                   // 正在停止
+    std::mutex mMutex;                                     // 保护连接列表
+    std::condition_variable mCondition;                    // 连接线程退出通知
+    std::vector<std::shared_ptr<Connection>> mConnections; // 活动连接
+    std::vector<std::filesystem::path> mAllowedRoots;      // 任务路径须位于其中之一  为空时不限制
+
+public:
+    JobServer(
+        ImageFlowProcessor &processor,
+        std::string socketPath,
+        size_t maxPendingPerConnection = 64);
+
+    ~JobServer();
+
+    JobServer(JobServer const &) = delete;
+    JobServer &operator=(JobServer const &) = delete;
+
+public:
+    // 监听并处理连接  直到stop被调用  监听失败时返回非0
+    int run();
+
+    // 停止接受连接  中断现有连接并等待在途任务完成
+    void stop();
+
+    // 限制任务的输入与输出路径  在run之前调用  目录不存在时返回false
+    bool setAllowedRoots(std::vector<std::string> const &roots);
+
+    // 将单个任务选项应用到配置  未知选项或取值无效时返回false
+    static bool applyOption(
+        ProcessConfig &config,
+        std::string const &key,
+        std::string const &value);
+
+private:
+    // 读取连接上的任务帧并提交
+    void serve(std::shared_ptr<Connection> connection);
+
+    // 路径（解析符号链接后）是否位于允许的目录内
+    bool isAllowedPath(std::string const &path) const;
+
+    // 将任务消息转换为处理请求  配置无效或路径不允许时返回false
+    bool makeRequest(
+        JobProtocol::JobMessage &message,
+        JobRequest &request) const;
+
+    // 回复入队  由连接的写线程写出  任务线程不会阻塞在套接字上
+    static void reply(
+        Connection &connection,
+        JobProtocol::ReplyMessage const &message);
+
+    // 连接的写线程  依次写出回复  直到读取结束且回复全部写出
+    static void sendReplies(std::shared_ptr<Connection> connection);
+};
+
+} // namespace ImageFlow
@@ -0,0 +1,186 @@
+#include "JpegThumbnail.h"
+//--------------------------
+#include <cstdlib>
+#include <cstring>
+
+using namespace ImageFlow;
+
+namespace
+{
+
+uint16_t loadBigEndian16(uint8_t const *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// TIFF按文件头指定的字节序读取
+struct TiffReader
+{
+    uint8_t const *data;
+    size_t size;
+    bool little;
+
+    bool has(size_t offset, size_t length) const
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    uint16_t u16(size_t offset) const
+    {
+        auto p = data + offset;
+        return little ? static_cast<uint16_t>(p[0] | (p[1] << 8))
+                      : static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    uint32_t u32(size_t offset) const
+    {
+        auto p = data + offset;
+        return little ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+                      : (uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]));
+    }
+};
+
+bool isStartOfFrame(uint8_t marker)
+{
+    // SOF0-SOF15  除去DHT(C4)、JPG(C8)、DAC(CC)
+    return marker >= 0xC0 && marker <= 0xCF &&
+           marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+}
+
+} // namespace
+
+bool JpegThumbnail::find(uint8_t const *data, size_t size, EmbeddedThumbnail &thumb)
+{
+    thumb = {};
+    if (!parseSegments(data, size, thumb.imageWidth, thumb.imageHeight, &thumb) || thumb.data.empty())
+        return false;
+
+    // 缩略图本身也是JPEG  从它的SOF取尺寸
+    return parseSegments(thumb.data.data(), thumb.data.size(), thumb.width, thumb.height, nullptr);
+}
+
+bool JpegThumbnail::imageSize(uint8_t const *data, size_t size, int &width, int &height)
+{
+    return parseSegments(data, size, width, height, nullptr);
+}
+
+bool JpegThumbnail::canServe(EmbeddedThumbnail const &thumb, int dstWidth, int dstHeight)
+{
+    if (dstWidth <= 0 || dstHeight <= 0 ||
+        thumb.width < dstWidth || thumb.height < dstHeight ||
+        thumb.imageWidth <= 0 || thumb.imageHeight <= 0)
+    {
+        return false;
+    }
+
+    // 缩略图须比主图小  宽高比相差不超过2%
+    int64_t thumbPixels = static_cast<int64_t>(thumb.width) * thumb.height;
+    int64_t imagePixels = static_cast<int64_t>(thumb.imageWidth) * thumb.imageHeight;
+    int64_t cross1 = static_cast<int64_t>(thumb.width) * thumb.imageHeight;
+    int64_t cross2 = static_cast<int64_t>(thumb.height) * thumb.imageWidth;
+    return thumbPixels < imagePixels && std::llabs(cross1 - cross2) * 50 <= cross2;
+}
+
+bool JpegThumbnail::parseSegments(
+    uint8_t const *data, size_t size,
+    int &width, int &height,
+    EmbeddedThumbnail *thumb)
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+        return false;
+
+    size_t pos = 2;
+    while (pos + 4 <= size)
+    {
+        if (data[pos] != 0xFF)
+            return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF)
+        { // 填充字节
+            ++pos;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+        { // 无长度的标记
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9)
+            return false; // 到达图像数据仍未找到SOF
+
+        size_t length = loadBigEndian16(data + pos + 2);
+        if (length < 2 || pos + 2 + length > size)
+            return false;
+        uint8_t const *segment = data + pos + 4;
+        size_t segmentSize = length - 2;
+
+        if (isStartOfFrame(marker) && segmentSize >= 5)
+        {
+            height = loadBigEndian16(segment + 1);
+            width = loadBigEndian16(segment + 3);
+            return width > 0 && height > 0;
+        }
+
+        if (thumb && thumb->data.empty())
+        {
+            if (marker == 0xE1 && segmentSize > 6 && memcmp(segment, "Exif\0\0", 6) == 0)
+            {
+                thumb->data = parseExif(segment + 6, segmentSize - 6);
+            }
+            else if (marker == 0xE0 && segmentSize > 6 && memcmp(segment, "JFXX\0", 5) == 0 && segment[5] == 0x10)
+            {
+                thumb->data = {segment + 6, segmentSize - 6}; // 扩展码0x10为JPEG编码的缩略图
+            }
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+std::span<uint8_t const> JpegThumbnail::parseExif(uint8_t const *tiff, size_t size)
+{
+    if (size < 8)
+        return {};
+    TiffReader reader{tiff, size, false};
+    if (memcmp(tiff, "II", 2) == 0)
+        reader.little = true;
+    else if (memcmp(tiff, "MM", 2) != 0)
+        return {};
+    if (reader.u16(2) != 42)
+        return {};
+
+    // IFD0之后的下一个IFD即为描述缩略图的IFD1
+    size_t ifd0 = reader.u32(4);
+    if (!reader.has(ifd0, 2))
+        return {};
+    size_t count0 = reader.u16(ifd0);
+    if (!reader.has(ifd0 + 2, count0 * 12 + 4))
+        return {};
+    size_t ifd1 = reader.u32(ifd0 + 2 + count0 * 12);
+    if (ifd1 == 0 || !reader.has(ifd1, 2))
+        return {};
+    size_t count1 = reader.u16(ifd1);
+    if (!reader.has(ifd1 + 2, count1 * 12))
+        return {};
+
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    for (size_t i = 0; i < count1; ++i)
+    {
+        size_t entry = ifd1 + 2 + i * 12;
+        uint16_t tag = reader.u16(entry);
+        uint16_t type = reader.u16(entry + 2);
+        uint32_t value = type == 3 ? reader.u16(entry + 8) : reader.u32(entry + 8); // SHORT或LONG
+        if (tag == 0x0201)
+            offset = value;
+        else if (tag == 0x0202)
+            length = value;
+    }
+
+    if (offset == 0 || length < 4 || !reader.has(offset, length) ||
+        tiff[offset] != 0xFF || tiff[offset + 1] != 0xD8)
+    {
+        return {};
+    }
+    return {tiff + offset, length};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace ImageFlow
+{
+
+/* JPEG内嵌缩略图 */
+struct EmbeddedThumbnail
+{
+    std::span<uint8_t const> data; // 缩略图的JPEG数据  指向传入的缓冲
+    int width = 0;                 // 缩略图宽度
+    int height = 0;                // 缩略图高度
+    int imageWidth = 0;            // 主图宽度
+    int imageHeight = 0;           // 主图高度
+};
+
+/* JPEG内嵌缩略图解析
+ * 只解析文件头中的APP0（JFXX扩展中的JPEG缩略图）与APP1（EXIF IFD1）段  以及主图的SOF段
+ */
+class JpegThumbnail
+{
+public:
+    // 文件头足够长时只需传入前几百KB  主图SOF不在范围内时返回false
+    static bool find(uint8_t const *data, size_t size, EmbeddedThumbnail &thumb);
+
+    // 主图尺寸（SOF）  不查找缩略图
+    static bool imageSize(uint8_t const *data, size_t size, int &width, int &height);
+
+    // 缩略图能否代替主图生成dstWidth x dstHeight的输出
+    // 目标尺寸有效  缩略图不需要放大  且宽高比与主图一致（部分相机的缩略图带黑边）
+    static bool canServe(EmbeddedThumbnail const &thumb, int dstWidth, int dstHeight);
+
+private:
+    // 遍历标记段直到SOS  读取SOF中的尺寸  thumb不为空时同时查找缩略图
+    static bool parseSegments(
+        uint8_t const *data, size_t size,
+        int &width, int &height,
+        EmbeddedThumbnail *thumb);
+
+    // 解析EXIF的TIFF结构  取IFD1中的JPEGInterchangeFormat与其长度
+    static std::span<uint8_t const> parseExif(uint8_t const *tiff, size_t size);
+};
+
+} // namespace ImageFlow
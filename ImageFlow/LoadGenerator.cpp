@@ -0,0 +1,293 @@
+#include "LoadGenerator.h"
+//--------------------------
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+//--------------------------
+#include "ImageFlowProcessor.h"
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* 任务组合  输入与配置在提交时随机选取 */
+struct Workload
+{
+    std::vector<std::string> paths;                            // 输入路径
+    std::vector<std::vector<uint8_t>> data;                    // 预先读入的输入  非内联时为空
+    std::vector<std::shared_ptr<ProcessConfig const>> configs; // 尺寸、格式与滤镜的全部组合
+};
+
+/* 单个速率的结果 */
+struct RateResult
+{
+    double offered = 0.0;          // 目标到达率（张/s）
+    size_t sent = 0;               // 提交的任务数
+    size_t failed = 0;             // 失败的任务数
+    double throughput = 0.0;       // 实际完成率（张/s）
+    double serviceMs = 0.0;        // 平均处理耗时（不含排队）
+    double maxLagMs = 0.0;         // 提交相对计划时间的最大滞后
+    std::vector<double> latencies; // 从计划提交时间到完成的延迟（毫秒）  已排序
+};
+
+bool buildWorkload(ImageFlowProcessor const &processor, LoadGenerator::LoadOptions const &options, Workload &workload)
+{
+    workload.paths = options.inputs;
+    if (options.inlineInput)
+    {
+        workload.data.resize(options.inputs.size());
+        for (size_t i = 0; i < options.inputs.size(); ++i)
+        {
+            if (!Utils::readFile(options.inputs[i], workload.data[i]))
+                return false;
+        }
+    }
+
+    auto const &base = processor.getConfig();
+    auto sizes = options.sizes;
+    if (sizes.empty())
+        sizes.emplace_back(base.targetWidth, base.targetHeight);
+    auto formats = options.formats;
+    if (formats.empty())
+        formats.push_back(base.outputFmt);
+    auto filters = options.filters;
+    if (filters.empty())
+        filters.push_back(base.filterDesc);
+
+    for (auto &&[width, height] : sizes)
+    {
+        for (auto &&format : formats)
+        {
+            for (auto &&filter : filters)
+            {
+                auto config = std::make_shared<ProcessConfig>(base);
+                config->targetWidth = width;
+                config->targetHeight = height;
+                config->outputFmt = format;
+                config->filterDesc = filter;
+                if (!ImageFlowProcessor::isValidConfig(*config))
+                {
+                    std::cerr << "无效的任务配置：" << width << "x" << height
+                              << " " << format << " \"" << filter << "\"" << std::endl;
+                    return false;
+                }
+                workload.configs.push_back(std::move(config));
+            }
+        }
+    }
+    return true;
+}
+
+// 以给定到达率提交seconds秒的任务  等待全部完成后返回
+RateResult runRate(
+    ImageFlowProcessor &processor,
+    Workload const &workload,
+    LoadGenerator::LoadOptions const &options,
+    double rate,
+    double seconds,
+    std::mt19937_64 &rng)
+{
+    RateResult result;
+    result.offered = rate;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t outstanding = 0;
+    int64_t serviceUs = 0;
+    Clock::time_point lastDone;
+
+    std::exponential_distribution<double> interval(rate);
+    std::uniform_int_distribution<size_t> pickInput(0, workload.paths.size() - 1);
+    std::uniform_int_distribution<size_t> pickConfig(0, workload.configs.size() - 1);
+
+    auto begin = Clock::now();
+    auto end = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    auto intended = begin;
+    while (intended < end)
+    {
+        // 已落后于计划时不等待  立即补交  延迟仍从计划时间算起
+        std::this_thread::sleep_until(intended);
+        result.maxLagMs = std::max(result.maxLagMs,
+                                   std::chrono::duration<double, std::milli>(Clock::now() - intended).count());
+
+        size_t inputIdx = pickInput(rng);
+        JobRequest request;
+        if (workload.data.empty())
+            request.inputPath = workload.paths[inputIdx];
+        else
+            request.inputView = workload.data[inputIdx];
+        request.config = workload.configs[pickConfig(rng)];
+
+        {
+            std::lock_guard<std::mutex> _(mutex);
+            ++outstanding;
+        }
+        // 线程池队列已满时此处阻塞  之后的任务随之推迟  推迟的时间同样计入延迟
+        processor.processJobAsync(
+            std::move(request),
+            [&, intended](JobResult &&jobResult)
+            {
+                auto done = Clock::now();
+                std::lock_guard<std::mutex> _(mutex);
+                result.latencies.push_back(std::chrono::duration<double, std::milli>(done - intended).count());
+                serviceUs += jobResult.elapsedUs;
+                if (jobResult.status != 0)
+                    ++result.failed;
+                lastDone = std::max(lastDone, done);
+                --outstanding;
+                condition.notify_all(); // 持锁通知  等待者返回后局部变量才会销毁
+            });
+        ++result.sent;
+
+        double gap = options.poisson ? interval(rng) : 1.0 / rate;
+        intended += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&]
+                   { return outstanding == 0; });
+
+    // 未饱和时完成率受到达率限制  按运行时间与最后完成时间中较长者计算
+    double elapsed = std::chrono::duration<double>(std::max(end, lastDone) - begin).count();
+    size_t done = result.latencies.size();
+    result.throughput = elapsed > 0.0 ? done / elapsed : 0.0;
+    result.serviceMs = done ? serviceUs / 1000.0 / done : 0.0;
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+// 完成率明显低于到达率（队列持续增长）或p99超出上限时视为饱和
+bool isSaturated(RateResult const &result, double sloMs)
+{
+    if (result.throughput < result.offered * 0.9)
+        return true;
+    return sloMs > 0.0 && Utils::percentile(result.latencies, 0.99) > sloMs;
+}
+
+} // namespace
+
+bool LoadGenerator::parseArgs(std::vector<std::string> const &args, LoadOptions &options)
+{
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        auto const &arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--constant")
+            options.poisson = false;
+        else if (arg == "--inline")
+            options.inlineInput = true;
+        else if (arg == "--no-stop")
+            options.stopAtKnee = false;
+        else if (arg == "--rate" && hasValue)
+        {
+            double rate = 0.0;
+            if (!Utils::parseNumber(args[++i], rate) || rate <= 0.0)
+                return false;
+            options.rates.push_back(rate);
+        }
+        else if (arg == "--sweep" && hasValue)
+        {
+            // 按倍数从最小速率增长到最大速率
+            double minRate = 0.0, maxRate = 0.0, factor = 0.0;
+            if (sscanf(args[++i].c_str(), "%lf:%lf:%lf", &minRate, &maxRate, &factor) != 3 ||
+                minRate <= 0.0 || maxRate < minRate || factor <= 1.0)
+                return false;
+            for (double rate = minRate; rate <= maxRate * 1.0001; rate *= factor)
+                options.rates.push_back(rate);
+        }
+        else if ((arg == "--duration" || arg == "--warmup" || arg == "--slo") && hasValue)
+        {
+            double value = 0.0;
+            if (!Utils::parseNumber(args[++i], value))
+                return false;
+            if (arg == "--duration")
+                options.duration = std::max(value, 0.1);
+            else if (arg == "--warmup")
+                options.warmup = std::max(value, 0.0);
+            else
+                options.sloMs = std::max(value, 0.0);
+        }
+        else if (arg == "--seed" && hasValue)
+        {
+            if (!Utils::parseNumber(args[++i], options.seed))
+                return false;
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            int width = 0, height = 0;
+            if (sscanf(args[++i].c_str(), "%dx%d", &width, &height) != 2 || width < 0 || height < 0)
+                return false;
+            options.sizes.emplace_back(width, height);
+        }
+        else if (arg == "--format" && hasValue)
+            options.formats.push_back(args[++i]);
+        else if (arg == "--filter" && hasValue)
+            options.filters.push_back(args[++i]);
+        else if (arg.starts_with("-"))
+            return false;
+        else
+            options.inputs.push_back(arg);
+    }
+    std::sort(options.rates.begin(), options.rates.end());
+    return !options.inputs.empty() && !options.rates.empty();
+}
+
+int LoadGenerator::run(ImageFlowProcessor &processor, LoadOptions const &options)
+{
+    Workload workload;
+    if (options.inputs.empty() || options.rates.empty() || !buildWorkload(processor, options, workload))
+        return -1;
+
+    std::mt19937_64 rng(options.seed);
+    printf("开环负载：%s到达  %zu 个输入  %zu 种配置  每档 %.1f 秒  %s输入\n",
+           options.poisson ? "泊松" : "固定间隔", workload.paths.size(), workload.configs.size(),
+           options.duration, options.inlineInput ? "内联" : "路径");
+
+    // 预热文件缓存、滤镜图池与线程
+    if (options.warmup > 0.0)
+        runRate(processor, workload, options, options.rates.front(), options.warmup, rng);
+
+    double knee = 0.0;
+    double saturatedRate = 0.0;
+    for (double rate : options.rates)
+    {
+        auto result = runRate(processor, workload, options, rate, options.duration, rng);
+        bool saturated = isSaturated(result, options.sloMs);
+        auto const &latencies = result.latencies;
+        printf("速率 %8.1f  发送 %6zu  失败 %4zu  吞吐 %8.1f 张/s  "
+               "延迟 ms p50 %8.2f  p90 %8.2f  p99 %8.2f  p99.9 %8.2f  max %8.2f  处理均值 %7.2f  最大滞后 %7.2f%s\n",
+               rate, result.sent, result.failed, result.throughput,
+               Utils::percentile(latencies, 0.50), Utils::percentile(latencies, 0.90), Utils::percentile(latencies, 0.99),
+               Utils::percentile(latencies, 0.999), latencies.empty() ? 0.0 : latencies.back(),
+               result.serviceMs, result.maxLagMs, saturated ? "  饱和" : "");
+
+        if (!saturated)
+        {
+            knee = rate;
+            continue;
+        }
+        if (saturatedRate == 0.0)
+            saturatedRate = rate;
+        if (options.stopAtKnee)
+            break;
+    }
+
+    if (saturatedRate == 0.0)
+        printf("扫描范围内未饱和  最高 %.1f 张/s\n", knee);
+    else if (knee == 0.0)
+        printf("最低速率 %.1f 张/s 已饱和\n", saturatedRate);
+    else
+        printf("饱和拐点位于 %.1f 与 %.1f 张/s 之间\n", knee, saturatedRate);
+    processor.printExecutorStats();
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ImageFlow
+{
+
+class ImageFlowProcessor;
+
+namespace LoadGenerator
+{
+
+/* 负载参数 */
+struct LoadOptions
+{
+    std::vector<std::string> inputs;        // 输入文件  每个任务随机选取  以不同尺寸与格式的输入构成混合负载
+    std::vector<std::pair<int, int>> sizes; // 目标尺寸  为空时使用处理器的配置
+    std::vector<std::string> formats;       // 输出格式  为空时使用处理器的配置
+    std::vector<std::string> filters;       // 滤镜描述  为空时使用处理器的配置
+    std::vector<double> rates;              // 到达率（张/s）  多个时从低到高依次运行
+    bool poisson = true;                    // 泊松到达  否则为固定间隔
+    double duration = 10.0;                 // 每个速率的运行时间（秒）
+    double warmup = 1.0;                    // 以最低速率预热的时间（秒）  不计入结果
+    double sloMs = 0.0;                     // p99延迟上限（毫秒）  超出视为饱和 0表示只看吞吐
+    bool stopAtKnee = true;                 // 出现饱和后不再运行更高的速率
+    bool inlineInput = false;               // 预先读入输入  处理时不读盘
+    uint64_t seed = 1;                      // 随机种子  相同种子产生相同的到达序列与任务组合
+};
+
+// 以开环方式提交单图任务  到达时间事先确定  不等待之前的任务完成
+// 延迟从计划提交时间算起  提交被阻塞或推迟的时间也计入  避免协同遗漏
+// 逐个速率打印吞吐量与延迟分位数  并给出饱和拐点  输入无法读取或配置无效时返回-1
+int run(ImageFlowProcessor &processor, LoadOptions const &options);
+
+// 解析子命令参数 [--rate 张/s]... [--sweep 最小:最大:倍数] [--constant] [--duration 秒] [--warmup 秒]
+// [--size 宽x高]... [--format 格式]... [--filter 描述]... [--slo 毫秒] [--no-stop] [--inline] [--seed N] 文件...
+bool parseArgs(std::vector<std::string> const &args, LoadOptions &options);
+
+} // namespace LoadGenerator
+} // namespace ImageFlow
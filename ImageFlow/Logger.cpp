@@ -18,7 +18,7 @@ void Logger::setFile(std::string_view filename)
     mFileStream.emplace(filename.data(), std::ios::app);
     if (!mFileStream->is_open())
     {
-        std::cerr << std::format("־ļʧܣ{}\n", filename);
+        std::cerr << std::format("打开日志文件失败：{}\n", filename);
         mFileStream.reset();
     }
 }
@@ -31,18 +31,18 @@ void Logger::setConsoleOutput(bool enable)
 
 void Logger::outputLogEntry(LogLevel level, std::string_view logEntry)
 {
-    // ̨
+    // 输出到控制台
     if (mConsoleOutput)
     {
         if (level >= LogLevel::ERROR)
             std::cerr << logEntry << '\n';
         else
             std::cout << logEntry << '\n';
-        // ǿˢ£ȷʱ
+        // 强制刷新，确保及时输出
         std::cout.flush();
     }
 
-    // ļ
+    // 输出到文件
     if (mFileStream && mFileStream->is_open())
     {
         *mFileStream << logEntry << '\n';
@@ -85,7 +85,7 @@ std::string Logger::getCurrentTime()
     localtime_r(&time_t, &tm);
 #endif
 
-    // ֶʱַʽ
+    // 手动构建时间字符串，避免更多格式化问题
     char time_buffer[64];
     std::strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &tm);
     return std::format("{}.{:03d}", time_buffer, ms.count());
@@ -7,6 +7,8 @@
 #include <mutex>
 #include <source_location>
 #include <string_view>
+//--------------------------
+#include "InstrumentedMutex.h"
 
 enum class LogLevel
 {
@@ -20,7 +22,7 @@ enum class LogLevel
 class Logger
 {
 private:
-    std::mutex mMutex;
+    ImageFlow::ProfiledMutex mMutex{"Logger::mMutex"};
     bool mConsoleOutput = true;
     LogLevel mCurrentLevel = LogLevel::INFO;
     std::optional<std::ofstream> mFileStream;
@@ -29,23 +31,23 @@ private:
     Logger() = default;
 
 public:
-    // ɾ
+    // 删除拷贝操作
     Logger(Logger const &) = delete;
     Logger &operator=(Logger const &) = delete;
 
 public:
     static Logger &getInstance();
 
-    // ־
+    // 设置日志级别
     void setLevel(LogLevel level);
 
-    // ļ
+    // 设置输出文件
     void setFile(std::string_view filename);
 
-    // ÿ̨
+    // 设置控制台输出
     void setConsoleOutput(bool enable);
 
-    // ʽ־
+    // 格式化日志输出
     template <typename... Args>
     void debug(std::source_location const &location,
                std::format_string<Args...> fmt, Args &&...args)
@@ -100,8 +102,8 @@ private:
                                     getCurrentTime(),
                                     getLevelString(level),
                                     message,
-                                    filename,         // ʹ string_view
-                                    location.line()); // ʹ int
+                                    filename,         // 使用 string_view
+                                    location.line()); // 使用 int
         outputLogEntry(level, logEntry);
     }
 
@@ -0,0 +1,91 @@
+#include "MemoryBudget.h"
+//--------------------------
+#include <algorithm>
+
+using namespace ImageFlow;
+
+MemoryBudget::MemoryBudget(int64_t budget)
+    : mBudget(budget)
+{
+    mStats.budget = budget;
+}
+
+void MemoryBudget::setBudget(int64_t budget)
+{
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        mBudget = budget;
+        mStats.budget = budget;
+        ++mGeneration;
+    }
+    mReleased.notify_all();
+}
+
+int64_t MemoryBudget::getBudget() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mBudget;
+}
+
+bool MemoryBudget::tryAcquire(int64_t bytes)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    bool fits = mBudget <= 0 || mInFlight + bytes <= mBudget;
+    bool alone = mInFlight == 0; // 超大任务独占预算
+    if (!fits && !alone)
+        return false;
+
+    if (!fits)
+        ++mStats.oversized;
+    mInFlight += bytes;
+    mStats.peak = std::max(mStats.peak, mInFlight);
+    ++mStats.admitted;
+    return true;
+}
+
+void MemoryBudget::acquire(int64_t bytes)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    if (mBudget > 0 && mInFlight + bytes > mBudget)
+        ++mStats.oversized;
+    mInFlight += bytes;
+    mStats.peak = std::max(mStats.peak, mInFlight);
+    ++mStats.admitted;
+}
+
+void MemoryBudget::release(int64_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        mInFlight = std::max<int64_t>(mInFlight - bytes, 0);
+        ++mGeneration;
+    }
+    mReleased.notify_all();
+}
+
+uint64_t MemoryBudget::generation() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mGeneration;
+}
+
+void MemoryBudget::waitForRelease(uint64_t seen)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mReleased.wait(lock, [&]
+                   { return mGeneration != seen; });
+}
+
+void MemoryBudget::noteDeferred()
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    ++mStats.deferred;
+}
+
+MemoryBudget::Stats MemoryBudget::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    Stats stats = mStats;
+    stats.inFlight = mInFlight;
+    return stats;
+}
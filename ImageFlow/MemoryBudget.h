@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace ImageFlow
+{
+
+/* 内存预算
+ * 按字节计量在途任务的峰值内存  预算不足时推迟任务的开始
+ * 单个超出总预算的任务在没有其他在途任务时仍然放行  避免永久阻塞
+ */
+class MemoryBudget
+{
+public:
+    /* 预算统计 */
+    struct Stats
+    {
+        int64_t budget = 0;   // 总预算
+        int64_t inFlight = 0; // 当前在途字节数
+        int64_t peak = 0;     // 在途字节数峰值
+        size_t admitted = 0;  // 放行任务数
+        size_t deferred = 0;  // 因预算不足而等待的次数
+        size_t oversized = 0; // 超出总预算而单独放行的任务数
+    };
+
+private:
+    mutable std::mutex mMutex;         // 保护预算状态
+    std::condition_variable mReleased; // 归还条件变量
+    int64_t mBudget;                   // 总预算 0表示不限制
+    int64_t mInFlight = 0;             // 在途字节数
+    uint64_t mGeneration = 0;          // 每次归还递增  用于等待归还
+    Stats mStats;                      // 统计
+
+public:
+    explicit MemoryBudget(int64_t budget = 0);
+
+    MemoryBudget(MemoryBudget const &) = delete;
+    MemoryBudget &operator=(MemoryBudget const &) = delete;
+
+public:
+    // 设置总预算 0表示不限制
+    void setBudget(int64_t budget);
+    int64_t getBudget() const;
+
+    // 预算足够时占用bytes并返回true
+    bool tryAcquire(int64_t bytes);
+
+    // 不论预算是否足够都占用bytes  用于不放行就无法继续推进的任务
+    void acquire(int64_t bytes);
+
+    // 归还占用的字节数并唤醒等待者
+    void release(int64_t bytes);
+
+    // 当前的归还代数  与waitForRelease配合使用
+    uint64_t generation() const;
+
+    // 等待自seen之后发生至少一次归还
+    void waitForRelease(uint64_t seen);
+
+    // 记录一次因预算不足的等待
+    void noteDeferred();
+
+    Stats getStats() const;
+};
+
+} // namespace ImageFlow
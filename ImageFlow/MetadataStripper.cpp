@@ -0,0 +1,207 @@
+#include "MetadataStripper.h"
+//--------------------------
+#include <cstring>
+
+using namespace ImageFlow;
+
+namespace
+{
+
+uint8_t const kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+uint32_t loadBigEndian32(uint8_t const *p)
+{
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+void appendBigEndian16(std::vector<uint8_t> &output, uint32_t value)
+{
+    output.push_back(static_cast<uint8_t>(value >> 8));
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+void appendBigEndian32(std::vector<uint8_t> &output, uint32_t value)
+{
+    appendBigEndian16(output, value >> 16);
+    appendBigEndian16(output, value);
+}
+
+// EXIF（TIFF结构）IFD0中的方向标记  没有或无法解析时返回0
+uint32_t exifOrientation(uint8_t const *tiff, size_t size)
+{
+    if (size < 8)
+        return 0;
+    bool little = memcmp(tiff, "II", 2) == 0;
+    if (!little && memcmp(tiff, "MM", 2) != 0)
+        return 0;
+    auto u16 = [&](size_t offset)
+    {
+        auto p = tiff + offset;
+        return little ? static_cast<uint32_t>(p[0] | (p[1] << 8))
+                      : static_cast<uint32_t>((p[0] << 8) | p[1]);
+    };
+    auto u32 = [&](size_t offset)
+    {
+        auto p = tiff + offset;
+        return little ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+                      : (uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]));
+    };
+    if (u16(2) != 42)
+        return 0;
+
+    size_t ifd0 = u32(4);
+    if (ifd0 > size - 2)
+        return 0;
+    size_t count = u16(ifd0);
+    if (count * 12 > size - ifd0 - 2)
+        return 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t entry = ifd0 + 2 + i * 12;
+        if (u16(entry) == 0x0112 && u16(entry + 2) == 3) // Orientation  SHORT
+            return u16(entry + 8);
+    }
+    return 0;
+}
+
+// 只含方向标记的EXIF（大端TIFF  IFD0一项）
+void appendOrientationExif(std::vector<uint8_t> &output, uint32_t orientation)
+{
+    output.insert(output.end(), {'M', 'M', 0, 42});
+    appendBigEndian32(output, 8); // IFD0偏移
+    appendBigEndian16(output, 1); // 项数
+    appendBigEndian16(output, 0x0112);
+    appendBigEndian16(output, 3); // SHORT
+    appendBigEndian32(output, 1); // 个数
+    appendBigEndian16(output, orientation);
+    appendBigEndian16(output, 0);
+    appendBigEndian32(output, 0); // 没有下一个IFD
+}
+
+size_t const kOrientationExifSize = 26;
+
+// PNG块的CRC-32（ISO 3309）  覆盖类型与数据
+uint32_t pngCrc(uint8_t const *data, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// 影响解码结果的APP段
+bool isRequiredAppSegment(uint8_t marker, uint8_t const *segment, size_t size)
+{
+    if (marker == 0xE0)
+        return true;
+    if (marker == 0xE2)
+        return size >= 12 && memcmp(segment, "ICC_PROFILE\0", 12) == 0;
+    if (marker == 0xEE)
+        return size >= 5 && memcmp(segment, "Adobe", 5) == 0;
+    return false;
+}
+
+} // namespace
+
+bool MetadataStripper::strip(uint8_t const *data, size_t size, std::vector<uint8_t> &output)
+{
+    output.clear();
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xD8)
+        return stripJpeg(data, size, output);
+    if (size >= sizeof(kPngSignature) && memcmp(data, kPngSignature, sizeof(kPngSignature)) == 0)
+        return stripPng(data, size, output);
+    return false;
+}
+
+bool MetadataStripper::stripJpeg(uint8_t const *data, size_t size, std::vector<uint8_t> &output)
+{
+    output.reserve(size);
+    output.insert(output.end(), data, data + 2);
+
+    // 逐段复制到SOS  其后的熵编码数据原样复制
+    size_t pos = 2;
+    while (pos + 4 <= size)
+    {
+        if (data[pos] != 0xFF)
+            return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF)
+        { // 填充字节
+            ++pos;
+            continue;
+        }
+        if (marker == 0xDA)
+        {
+            output.insert(output.end(), data + pos, data + size);
+            return true;
+        }
+
+        size_t length = static_cast<size_t>(data[pos + 2] << 8 | data[pos + 3]);
+        if (length < 2 || pos + 2 + length > size)
+            return false;
+        uint8_t const *segment = data + pos + 4;
+        size_t segmentSize = length - 2;
+        bool metadata = marker == 0xFE || (marker >= 0xE1 && marker <= 0xEF);
+        if (!metadata || isRequiredAppSegment(marker, segment, segmentSize))
+        {
+            output.insert(output.end(), data + pos, data + pos + 2 + length);
+        }
+        else if (marker == 0xE1 && segmentSize > 6 && memcmp(segment, "Exif\0\0", 6) == 0)
+        {
+            // 方向为1（默认）时不必保留
+            uint32_t orientation = exifOrientation(segment + 6, segmentSize - 6);
+            if (orientation > 1)
+            {
+                output.insert(output.end(), {0xFF, 0xE1});
+                appendBigEndian16(output, static_cast<uint32_t>(2 + 6 + kOrientationExifSize));
+                output.insert(output.end(), {'E', 'x', 'i', 'f', 0, 0});
+                appendOrientationExif(output, orientation);
+            }
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+bool MetadataStripper::stripPng(uint8_t const *data, size_t size, std::vector<uint8_t> &output)
+{
+    output.reserve(size);
+    output.insert(output.end(), data, data + sizeof(kPngSignature));
+
+    // 块结构：长度(4) 类型(4) 数据 CRC(4)
+    size_t pos = sizeof(kPngSignature);
+    while (pos + 12 <= size)
+    {
+        size_t length = loadBigEndian32(data + pos);
+        if (length > size - pos - 12)
+            return false;
+        char const *type = reinterpret_cast<char const *>(data + pos + 4);
+        bool metadata = memcmp(type, "tEXt", 4) == 0 || memcmp(type, "zTXt", 4) == 0 ||
+                        memcmp(type, "iTXt", 4) == 0 || memcmp(type, "eXIf", 4) == 0 ||
+                        memcmp(type, "tIME", 4) == 0;
+        if (!metadata)
+        {
+            output.insert(output.end(), data + pos, data + pos + 12 + length);
+        }
+        else if (memcmp(type, "eXIf", 4) == 0)
+        {
+            uint32_t orientation = exifOrientation(data + pos + 8, length);
+            if (orientation > 1)
+            {
+                appendBigEndian32(output, static_cast<uint32_t>(kOrientationExifSize));
+                size_t chunk = output.size();
+                output.insert(output.end(), {'e', 'X', 'I', 'f'});
+                appendOrientationExif(output, orientation);
+                appendBigEndian32(output, pngCrc(output.data() + chunk, output.size() - chunk));
+            }
+        }
+        pos += 12 + length;
+        if (memcmp(type, "IEND", 4) == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ImageFlow
+{
+
+/* 元数据剥离
+ * 按文件的段或块结构去掉元数据  不解码像素
+ * JPEG去掉APP1-APP15与COM段  保留JFIF（APP0）、ICC配置（APP2）与Adobe颜色变换（APP14）
+ * PNG去掉tEXt、zTXt、iTXt、eXIf、tIME块
+ * EXIF带有非默认的方向标记时换成只含方向标记的最小EXIF  查看器仍按原方向显示
+ */
+class MetadataStripper
+{
+public:
+    // 格式不支持或结构无法解析时返回false
+    static bool strip(uint8_t const *data, size_t size, std::vector<uint8_t> &output);
+
+private:
+    static bool stripJpeg(uint8_t const *data, size_t size, std::vector<uint8_t> &output);
+    static bool stripPng(uint8_t const *data, size_t size, std::vector<uint8_t> &output);
+};
+
+} // namespace ImageFlow
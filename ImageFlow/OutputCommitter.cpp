@@ -0,0 +1,229 @@
+#include "OutputCommitter.h"
+//--------------------------
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <set>
+#include <system_error>
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+std::string parentOf(std::string const &path)
+{
+    return std::filesystem::path{path}.parent_path().string();
+}
+
+} // namespace
+
+OutputCommitter::OutputCommitter(
+    Durability durability,
+    size_t groupFiles,
+    std::chrono::milliseconds groupDelay)
+    : mDurability(durability), mGroupFiles(std::max<size_t>(groupFiles, 1)), mGroupDelay(groupDelay)
+{
+    if (mDurability == Durability::GROUP_COMMIT)
+    {
+        // clang-format off
+        mThread = std::thread([this] { run(); });
+        // clang-format on
+    }
+}
+
+OutputCommitter::~OutputCommitter()
+{
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable())
+        mThread.join();
+}
+
+std::string OutputCommitter::makeTempPath(std::string const &path)
+{
+    static std::atomic<uint64_t> counter = 0;
+    std::filesystem::path target{path};
+    auto name = "." + target.filename().string() + "." + std::to_string(++counter) + ".tmp";
+    return (target.parent_path() / name).string();
+}
+
+void OutputCommitter::write(std::string const &path, uint8_t const *data, size_t size, Callback done)
+{
+    auto tempPath = makeTempPath(path);
+    if (!Utils::writeFile(tempPath, data, size))
+    {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        noteResult(false);
+        done(false);
+        return;
+    }
+    commit(tempPath, path, std::move(done));
+}
+
+bool OutputCommitter::write(std::string const &path, uint8_t const *data, size_t size)
+{
+    std::promise<bool> promise;
+    auto future = promise.get_future();
+    write(path, data, size, [&promise](bool ok)
+          { promise.set_value(ok); });
+    return future.get();
+}
+
+void OutputCommitter::commit(std::string const &tempPath, std::string const &path, Callback done)
+{
+    if (mDurability == Durability::GROUP_COMMIT)
+    {
+        {
+            std::lock_guard<std::mutex> _(mMutex);
+            if (mPending.empty())
+                mOldest = Clock::now();
+            mPending.push_back({tempPath, path, std::move(done)});
+        }
+        mCondition.notify_one();
+        return;
+    }
+
+    bool ok = true;
+    if (mDurability == Durability::FSYNC)
+    {
+        // 内容先落盘再改名  否则掉电后可能看到改了名但内容为空的文件
+        auto begin = Clock::now();
+        ok = Utils::syncFile(tempPath);
+        ok = ok && rename(tempPath, path) && Utils::syncDirectory(parentOf(path));
+        std::lock_guard<std::mutex> _(mMutex);
+        mStats.fileSyncs += 1;
+        mStats.dirSyncs += 1;
+        mStats.syncUs += Utils::microsSince(begin);
+    }
+    else
+    {
+        ok = rename(tempPath, path);
+    }
+    if (!ok)
+    {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+    }
+    noteResult(ok);
+    done(ok);
+}
+
+bool OutputCommitter::commit(std::string const &tempPath, std::string const &path)
+{
+    std::promise<bool> promise;
+    auto future = promise.get_future();
+    commit(tempPath, path, [&promise](bool ok)
+           { promise.set_value(ok); });
+    return future.get();
+}
+
+Durability OutputCommitter::getDurability() const
+{
+    return mDurability;
+}
+
+OutputCommitter::Stats OutputCommitter::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mStats;
+}
+
+void OutputCommitter::run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        // 凑满一批或第一个文件等待超时后提交  停止时提交剩余的文件
+        mCondition.wait(lock, [this]
+                        { return mStop || !mPending.empty(); });
+        if (mPending.empty())
+            break;
+        mCondition.wait_until(lock, mOldest + mGroupDelay, [this]
+                              { return mStop || mPending.size() >= mGroupFiles; });
+
+        std::vector<Pending> group;
+        group.swap(mPending);
+        lock.unlock();
+        commitGroup(group);
+        lock.lock();
+    }
+}
+
+void OutputCommitter::commitGroup(std::vector<Pending> &group)
+{
+    auto begin = Clock::now();
+    std::set<std::string> dirs;
+    for (auto &&pending : group)
+        dirs.insert(parentOf(pending.path));
+
+    // 只刷本批的文件  不连带同一文件系统上其他进程的脏数据
+    // 先让全部文件同时开始写回  再逐个等待  设备可以合并与并行处理这些写入
+    for (auto &&pending : group)
+        Utils::startWriteback(pending.tempPath);
+    std::vector<bool> synced(group.size(), false);
+    for (size_t i = 0; i < group.size(); ++i)
+        synced[i] = Utils::syncFile(group[i].tempPath);
+
+    // 内容全部落盘后再改名  最后每个目录fsync一次使改名持久
+    std::vector<bool> renamed(group.size(), false);
+    for (size_t i = 0; i < group.size(); ++i)
+        renamed[i] = synced[i] && rename(group[i].tempPath, group[i].path);
+
+    std::set<std::string> failedDirs;
+    for (auto &&dir : dirs)
+    {
+        if (!Utils::syncDirectory(dir))
+            failedDirs.insert(dir);
+    }
+
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        ++mStats.groups;
+        mStats.fileSyncs += group.size();
+        mStats.dirSyncs += dirs.size();
+        mStats.syncUs += Utils::microsSince(begin);
+    }
+
+    for (size_t i = 0; i < group.size(); ++i)
+    {
+        bool ok = renamed[i] && !failedDirs.contains(parentOf(group[i].path));
+        if (!renamed[i])
+        {
+            std::error_code ec;
+            std::filesystem::remove(group[i].tempPath, ec);
+        }
+        noteResult(ok);
+        group[i].done(ok);
+    }
+}
+
+bool OutputCommitter::rename(std::string const &tempPath, std::string const &path)
+{
+    // 同一文件系统内改名是原子的  已存在的目标文件被直接替换
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::cerr << "无法提交输出文件：" << path << "（" << ec.message() << "）" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void OutputCommitter::noteResult(bool ok)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    if (ok)
+        ++mStats.files;
+    else
+        ++mStats.failures;
+}
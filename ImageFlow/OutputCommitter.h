@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ImageFlow
+{
+
+// 输出的持久化策略  三种策略都先写临时文件再改名  下游不会读到写了一半的文件
+enum class Durability
+{
+    NONE,        // 不刷盘  进程崩溃安全  掉电可能丢失最近的输出
+    FSYNC,       // 每个文件改名前fsync  改名后fsync目录
+    GROUP_COMMIT // 攒一批临时文件一起刷盘后改名  目录每批fsync一次
+};
+
+/* 输出提交
+ * 输出先写到同目录下的临时文件  按持久化策略刷盘后改名为最终文件名
+ * 组提交由单独的线程按文件数或等待时间凑批  完成回调在该线程中调用
+ */
+class OutputCommitter
+{
+public:
+    using Callback = std::function<void(bool)>;
+
+    /* 提交统计 */
+    struct Stats
+    {
+        size_t files = 0;     // 提交成功的文件数
+        size_t failures = 0;  // 失败数
+        size_t groups = 0;    // 组提交的批数
+        size_t fileSyncs = 0; // 文件fsync次数
+        size_t dirSyncs = 0;  // 目录fsync次数
+        int64_t syncUs = 0;   // 累计刷盘耗时（微秒）
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /* 等待组提交的文件 */
+    struct Pending
+    {
+        std::string tempPath; // 已写完的临时文件
+        std::string path;     // 最终文件名
+        Callback done;        // 完成回调
+    };
+
+private:
+    Durability mDurability;
+    size_t mGroupFiles;                    // 凑满该数量立即提交
+    std::chrono::milliseconds mGroupDelay; // 第一个文件的最长等待时间
+    mutable std::mutex mMutex;             // 保护以下状态
+    std::condition_variable mCondition;    // 新文件或停止通知
+    std::vector<Pending> mPending;         // 等待提交的文件
+    Clock::time_point mOldest;             // 本批第一个文件的加入时间
+    bool mStop = false;                    // 停止标志
+    Stats mStats;                          // 统计
+    std::thread mThread;                   // 组提交线程
+
+public:
+    explicit OutputCommitter(
+        Durability durability = Durability::NONE,
+        size_t groupFiles = 64,
+        std::chrono::milliseconds groupDelay = std::chrono::milliseconds(20));
+    ~OutputCommitter();
+
+    OutputCommitter(OutputCommitter const &) = delete;
+    OutputCommitter &operator=(OutputCommitter const &) = delete;
+
+public:
+    // 同目录下的临时文件名  以点开头并以.tmp结尾  不会被按扩展名匹配的下游读到
+    static std::string makeTempPath(std::string const &path);
+
+    // 写出数据并提交  完成后调用done  组提交时在提交线程中调用
+    void write(std::string const &path, uint8_t const *data, size_t size, Callback done);
+
+    // 同步写出  组提交时等待本批落盘
+    bool write(std::string const &path, uint8_t const *data, size_t size);
+
+    // 把已写完的临时文件提交为path  失败时删除临时文件
+    void commit(std::string const &tempPath, std::string const &path, Callback done);
+
+    bool commit(std::string const &tempPath, std::string const &path);
+
+    Durability getDurability() const;
+
+    Stats getStats() const;
+
+private:
+    void run();
+
+    // 一批文件：刷盘  改名  按目录fsync
+    void commitGroup(std::vector<Pending> &group);
+
+    // 改名为最终文件名  失败时删除临时文件
+    static bool rename(std::string const &tempPath, std::string const &path);
+
+    void noteResult(bool ok);
+};
+
+} // namespace ImageFlow
@@ -0,0 +1,498 @@
+#include "PackFile.h"
+//--------------------------
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+//--------------------------
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+// ImageFlow打包格式  整数均为小端
+//   文件头  "IFPK" u32版本
+//   记录    "IFPR" u32名称长度 u64数据长度 名称 数据       （重复）
+//   索引    u32条目数 { u32名称长度 名称 u64数据偏移 u64数据长度 }
+//   尾部    u64索引偏移 "IFPX"
+constexpr char kPackMagic[4] = {'I', 'F', 'P', 'K'};
+constexpr char kRecordMagic[4] = {'I', 'F', 'P', 'R'};
+constexpr char kIndexMagic[4] = {'I', 'F', 'P', 'X'};
+constexpr uint32_t kPackVersion = 1;
+constexpr uint64_t kHeaderSize = 8;
+constexpr uint64_t kRecordHeaderSize = 16;
+constexpr uint64_t kTrailerSize = 12;
+
+constexpr uint64_t kTarBlock = 512;
+
+template <typename T>
+void putInteger(std::vector<uint8_t> &out, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+}
+
+template <typename T>
+T loadInteger(uint8_t const *p)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return static_cast<T>(value);
+}
+
+// tar头中以NUL结尾或占满字段的字符串
+std::string tarString(uint8_t const *field, size_t size)
+{
+    auto end = std::find(field, field + size, uint8_t(0));
+    return {field, end};
+}
+
+// tar头中的八进制数  GNU扩展以最高位标记的大端二进制数
+uint64_t tarNumber(uint8_t const *field, size_t size)
+{
+    uint64_t value = 0;
+    if (field[0] & 0x80)
+    {
+        for (size_t i = 1; i < size; ++i)
+            value = (value << 8) | field[i];
+        return value;
+    }
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (field[i] >= '0' && field[i] <= '7')
+            value = (value << 3) | (field[i] - '0');
+        else if (field[i] != ' ' || value != 0)
+            break;
+    }
+    return value;
+}
+
+// 校验和字段按8个空格计算
+bool tarChecksumValid(uint8_t const *header)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < kTarBlock; ++i)
+        sum += (i >= 148 && i < 156) ? ' ' : header[i];
+    return sum == tarNumber(header + 148, 8);
+}
+
+// pax扩展头中的path记录  格式为"长度 键=值\n"
+std::string paxPath(uint8_t const *data, uint64_t size)
+{
+    std::string path;
+    uint64_t pos = 0;
+    while (pos < size)
+    {
+        uint64_t length = 0;
+        uint64_t i = pos;
+        while (i < size && data[i] >= '0' && data[i] <= '9' && length <= size)
+            length = length * 10 + (data[i++] - '0');
+        // 长度须覆盖长度字段与空格  否则记录内容的范围颠倒
+        if (length == 0 || length > size - pos || i >= size || data[i] != ' ' || i + 1 > pos + length)
+            break;
+
+        std::string record(data + i + 1, data + pos + length);
+        if (record.starts_with("path=") && record.ends_with("\n"))
+            path = record.substr(5, record.size() - 6);
+        pos += length;
+    }
+    return path;
+}
+
+} // namespace
+
+//----------------------------------------------------------------
+// PackReader
+
+PackReader::~PackReader()
+{
+    close();
+}
+
+bool PackReader::open(std::string const &path)
+{
+    close();
+
+#ifdef _WIN32
+    std::wstring wpath = std::filesystem::path{path}.wstring();
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "无法打开打包文件：" << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mMapping)
+        {
+            mData = static_cast<uint8_t const *>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+            mSize = mData ? static_cast<size_t>(size.QuadPart) : 0;
+        }
+    }
+    CloseHandle(file); // 映射持有文件
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "无法打开打包文件：" << path << std::endl;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            mData = static_cast<uint8_t const *>(addr);
+            mSize = static_cast<size_t>(st.st_size);
+        }
+    }
+    ::close(fd); // 映射持有文件
+#endif
+
+    if (!mData)
+    {
+        std::cerr << "无法映射打包文件：" << path << std::endl;
+        close();
+        return false;
+    }
+
+    if (mSize >= kHeaderSize && memcmp(mData, kPackMagic, 4) == 0)
+    {
+        if (loadInteger<uint32_t>(mData + 4) == kPackVersion && parsePack())
+        {
+            mFormat = Format::PACK;
+            return true;
+        }
+    }
+    else if (mSize >= kTarBlock && tarChecksumValid(mData) && parseTar())
+    {
+        mFormat = Format::TAR;
+        return true;
+    }
+
+    std::cerr << "无法识别的打包文件格式：" << path << std::endl;
+    close();
+    return false;
+}
+
+void PackReader::close()
+{
+    if (mData)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        munmap(const_cast<uint8_t *>(mData), mSize);
+#endif
+    }
+#ifdef _WIN32
+    if (mMapping)
+        CloseHandle(mMapping);
+#endif
+    mData = nullptr;
+    mSize = 0;
+    mMapping = nullptr;
+    mFormat = Format::NONE;
+    mEntries.clear();
+    mIndex.clear();
+    mDataEnd = 0;
+    mIndexed = false;
+}
+
+PackReader::Format PackReader::getFormat() const
+{
+    return mFormat;
+}
+
+std::vector<PackEntry> const &PackReader::getEntries() const
+{
+    return mEntries;
+}
+
+PackEntry const *PackReader::find(std::string const &name) const
+{
+    auto it = mIndex.find(name);
+    return it != mIndex.end() ? &mEntries[it->second] : nullptr;
+}
+
+std::span<uint8_t const> PackReader::getData(PackEntry const &entry) const
+{
+    return {mData + entry.offset, static_cast<size_t>(entry.size)};
+}
+
+uint64_t PackReader::getDataEnd() const
+{
+    return mDataEnd;
+}
+
+bool PackReader::isIndexed() const
+{
+    return mIndexed;
+}
+
+bool PackReader::parsePack()
+{
+    // 有完整索引时直接读取索引  否则（写入中途退出）逐条扫描记录
+    if (mSize >= kHeaderSize + kTrailerSize &&
+        memcmp(mData + mSize - 4, kIndexMagic, 4) == 0)
+    {
+        uint64_t indexOffset = loadInteger<uint64_t>(mData + mSize - kTrailerSize);
+        uint64_t indexEnd = mSize - kTrailerSize;
+        bool ok = indexOffset >= kHeaderSize && indexOffset + 4 <= indexEnd;
+        uint64_t pos = indexOffset;
+        uint32_t count = ok ? loadInteger<uint32_t>(mData + pos) : 0;
+        pos += 4;
+        for (uint32_t i = 0; ok && i < count; ++i)
+        {
+            if (pos + 4 > indexEnd)
+            {
+                ok = false;
+                break;
+            }
+            uint32_t nameLength = loadInteger<uint32_t>(mData + pos);
+            pos += 4;
+            if (pos + nameLength + 16 > indexEnd)
+            {
+                ok = false;
+                break;
+            }
+            std::string name(mData + pos, mData + pos + nameLength);
+            pos += nameLength;
+            uint64_t offset = loadInteger<uint64_t>(mData + pos);
+            uint64_t size = loadInteger<uint64_t>(mData + pos + 8);
+            pos += 16;
+            if (offset > indexOffset || size > indexOffset - offset)
+            {
+                ok = false;
+                break;
+            }
+            addEntry(std::move(name), offset, size);
+        }
+        if (ok)
+        {
+            mDataEnd = indexOffset;
+            mIndexed = true;
+            return true;
+        }
+        mEntries.clear();
+        mIndex.clear();
+    }
+
+    scanRecords(kHeaderSize);
+    return true;
+}
+
+void PackReader::scanRecords(uint64_t offset)
+{
+    // 记录标记保证不会把残留的索引当成记录
+    while (offset + kRecordHeaderSize <= mSize && memcmp(mData + offset, kRecordMagic, 4) == 0)
+    {
+        uint32_t nameLength = loadInteger<uint32_t>(mData + offset + 4);
+        uint64_t size = loadInteger<uint64_t>(mData + offset + 8);
+        uint64_t dataOffset = offset + kRecordHeaderSize + nameLength;
+        if (dataOffset > mSize || size > mSize - dataOffset)
+            break;
+        addEntry(std::string(mData + offset + kRecordHeaderSize, mData + dataOffset), dataOffset, size);
+        offset = dataOffset + size;
+    }
+    mDataEnd = offset;
+}
+
+bool PackReader::parseTar()
+{
+    std::string longName; // GNU长文件名或pax路径  作用于下一个条目
+    uint64_t offset = 0;
+    while (offset + kTarBlock <= mSize)
+    {
+        uint8_t const *header = mData + offset;
+        // 两个全零块表示结束
+        if (std::all_of(header, header + kTarBlock, [](uint8_t b)
+                        { return b == 0; }))
+            break;
+        if (!tarChecksumValid(header))
+        {
+            std::cerr << "tar头校验失败  偏移 " << offset << std::endl;
+            return false;
+        }
+
+        uint64_t size = tarNumber(header + 124, 12);
+        uint64_t dataOffset = offset + kTarBlock;
+        if (size > mSize - dataOffset)
+            return false;
+
+        char type = static_cast<char>(header[156]);
+        if (type == 'L')
+        {
+            longName = tarString(mData + dataOffset, static_cast<size_t>(size));
+        }
+        else if (type == 'x')
+        {
+            longName = paxPath(mData + dataOffset, size);
+        }
+        else if (type == '0' || type == '\0' || type == '7')
+        {
+            std::string name = longName;
+            if (name.empty())
+            {
+                name = tarString(header, 100);
+                if (memcmp(header + 257, "ustar", 5) == 0 && header[345])
+                    name = tarString(header + 345, 155) + "/" + name;
+            }
+            addEntry(std::move(name), dataOffset, size);
+            longName.clear();
+        }
+        else
+        {
+            longName.clear(); // 目录、链接等
+        }
+
+        offset = dataOffset + (size + kTarBlock - 1) / kTarBlock * kTarBlock;
+    }
+    return true;
+}
+
+void PackReader::addEntry(std::string name, uint64_t offset, uint64_t size)
+{
+    mIndex[name] = mEntries.size();
+    mEntries.push_back({std::move(name), offset, size});
+}
+
+//----------------------------------------------------------------
+// PackWriter
+
+PackWriter::~PackWriter()
+{
+    close();
+}
+
+bool PackWriter::open(std::string const &path)
+{
+    close();
+    std::lock_guard<std::mutex> _(mMutex);
+    mPath = path;
+    mFailed = false;
+    mEntries.clear();
+
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > 0)
+    {
+        // 接着已有的记录追加  旧索引在关闭时重写
+        PackReader reader;
+        if (!reader.open(path) || reader.getFormat() != PackReader::Format::PACK)
+        {
+            std::cerr << "不是ImageFlow打包文件  无法追加：" << path << std::endl;
+            return false;
+        }
+        mEntries = reader.getEntries();
+        mOffset = reader.getDataEnd();
+        reader.close();
+
+        std::filesystem::resize_file(path, mOffset, ec);
+        if (ec || !(mFile = Utils::openFile(path, "ab")))
+        {
+            std::cerr << "无法打开打包文件：" << path << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        if (!(mFile = Utils::openFile(path, "wb")))
+        {
+            std::cerr << "无法创建打包文件：" << path << std::endl;
+            return false;
+        }
+        std::vector<uint8_t> header(kPackMagic, kPackMagic + 4);
+        putInteger<uint32_t>(header, kPackVersion);
+        if (fwrite(header.data(), 1, header.size(), mFile) != header.size())
+            mFailed = true;
+        mOffset = kHeaderSize;
+    }
+
+    // 条目通常很小  加大缓冲减少系统调用
+    setvbuf(mFile, nullptr, _IOFBF, 1 << 20);
+    return !mFailed;
+}
+
+bool PackWriter::add(std::string const &name, uint8_t const *data, size_t size)
+{
+    std::vector<uint8_t> header;
+    header.reserve(kRecordHeaderSize + name.size());
+    header.insert(header.end(), kRecordMagic, kRecordMagic + 4);
+    putInteger<uint32_t>(header, static_cast<uint32_t>(name.size()));
+    putInteger<uint64_t>(header, size);
+    header.insert(header.end(), name.begin(), name.end());
+
+    std::lock_guard<std::mutex> _(mMutex);
+    if (!mFile || mFailed)
+        return false;
+    if (fwrite(header.data(), 1, header.size(), mFile) != header.size() ||
+        (size > 0 && fwrite(data, 1, size, mFile) != size))
+    {
+        // 已写入的半条记录在下次打开时被扫描丢弃
+        std::cerr << "写入打包文件失败：" << mPath << std::endl;
+        mFailed = true;
+        return false;
+    }
+    mEntries.push_back({name, mOffset + header.size(), size});
+    mOffset += header.size() + size;
+    return true;
+}
+
+bool PackWriter::close(bool sync)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    if (!mFile)
+        return true;
+
+    // 写入失败后不写索引  下次打开时按记录扫描恢复
+    bool ok = !mFailed;
+    if (ok)
+    {
+        std::vector<uint8_t> index;
+        putInteger<uint32_t>(index, static_cast<uint32_t>(mEntries.size()));
+        for (auto &&entry : mEntries)
+        {
+            putInteger<uint32_t>(index, static_cast<uint32_t>(entry.name.size()));
+            index.insert(index.end(), entry.name.begin(), entry.name.end());
+            putInteger<uint64_t>(index, entry.offset);
+            putInteger<uint64_t>(index, entry.size);
+        }
+        putInteger<uint64_t>(index, mOffset);
+        index.insert(index.end(), kIndexMagic, kIndexMagic + 4);
+        ok = fwrite(index.data(), 1, index.size(), mFile) == index.size();
+    }
+    ok = fclose(mFile) == 0 && ok;
+    mFile = nullptr;
+    if (ok && sync)
+        ok = Utils::syncFile(mPath);
+    return ok;
+}
+
+size_t PackWriter::getEntryCount() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mEntries.size();
+}
+
+uint64_t PackWriter::getSize() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mOffset;
+}
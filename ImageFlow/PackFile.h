@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ImageFlow
+{
+
+/* 打包文件中的条目 */
+struct PackEntry
+{
+    std::string name;    // 条目名称（包内路径）
+    uint64_t offset = 0; // 数据在文件中的偏移
+    uint64_t size = 0;   // 数据长度
+};
+
+/* 打包文件读取
+ * 支持tar（ustar、GNU长文件名、pax路径）与ImageFlow打包格式
+ * 整个文件映射到内存  条目数据直接指向映射区域  不复制
+ */
+class PackReader
+{
+public:
+    enum class Format
+    {
+        NONE,
+        PACK, // ImageFlow打包格式
+        TAR,
+    };
+
+private:
+    uint8_t const *mData = nullptr;                 // 映射区域
+    size_t mSize = 0;                               // 文件大小
+    void *mMapping = nullptr;                       // 映射句柄（Windows）
+    Format mFormat = Format::NONE;                  // 文件格式
+    std::vector<PackEntry> mEntries;                // 按文件中的顺序排列
+    std::unordered_map<std::string, size_t> mIndex; // 名称到条目的索引  同名时为最后一个
+    uint64_t mDataEnd = 0;                          // 打包格式中最后一条完整记录的结束位置
+    bool mIndexed = false;                          // 打包格式的索引完整  否则由逐条扫描重建
+
+public:
+    PackReader() = default;
+    ~PackReader();
+
+    PackReader(PackReader const &) = delete;
+    PackReader &operator=(PackReader const &) = delete;
+
+public:
+    // 映射文件并建立条目索引  格式无法识别时返回false
+    bool open(std::string const &path);
+
+    void close();
+
+    Format getFormat() const;
+
+    std::vector<PackEntry> const &getEntries() const;
+
+    // 按名称查找  不存在时返回nullptr
+    PackEntry const *find(std::string const &name) const;
+
+    // 条目数据  指向映射区域  在close之前有效
+    std::span<uint8_t const> getData(PackEntry const &entry) const;
+
+    uint64_t getDataEnd() const;
+
+    bool isIndexed() const;
+
+private:
+    bool parsePack();
+    bool parseTar();
+
+    // 从offset开始逐条读取打包格式的记录  遇到不完整的记录时停止
+    void scanRecords(uint64_t offset);
+
+    void addEntry(std::string name, uint64_t offset, uint64_t size);
+};
+
+/* 打包文件写出
+ * 只追加  记录自带名称与长度  关闭时在文件尾写入索引
+ * 打开已有的打包文件时去掉旧索引后继续追加  未正常关闭的文件按记录扫描恢复
+ * 可从多个线程调用add
+ */
+class PackWriter
+{
+private:
+    mutable std::mutex mMutex;       // 保护以下状态
+    std::string mPath;               // 文件路径
+    FILE *mFile = nullptr;           // 追加写入的文件
+    uint64_t mOffset = 0;            // 当前文件长度
+    std::vector<PackEntry> mEntries; // 全部条目  关闭时写入索引
+    bool mFailed = false;            // 写入出错后不再写入
+
+public:
+    PackWriter() = default;
+    ~PackWriter();
+
+    PackWriter(PackWriter const &) = delete;
+    PackWriter &operator=(PackWriter const &) = delete;
+
+public:
+    // 创建或打开打包文件准备追加
+    bool open(std::string const &path);
+
+    // 追加一个条目
+    bool add(std::string const &name, uint8_t const *data, size_t size);
+
+    // 写入索引并关闭  sync为true时刷到存储设备
+    bool close(bool sync = false);
+
+    size_t getEntryCount() const;
+
+    uint64_t getSize() const;
+};
+
+} // namespace ImageFlow
@@ -0,0 +1,117 @@
+#include "PaletteQuantizer.h"
+//--------------------------
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+//--------------------------
+extern "C"
+{
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+using namespace ImageFlow;
+
+namespace
+{
+
+// 每帧单独统计并生成调色板  paletteuse随帧更换调色板  默认保留透明色
+char const *kPaletteDesc =
+    "split[a][b];"
+    "[a]palettegen=stats_mode=single[p];"
+    "[b][p]paletteuse=new=1:dither=sierra2_4a";
+
+} // namespace
+
+PaletteQuantizer::PaletteQuantizer(AVRational timeBase)
+    : mTimeBase(timeBase.num > 0 && timeBase.den > 0 ? timeBase : AVRational{1, 1})
+{
+}
+
+PaletteQuantizer::~PaletteQuantizer()
+{
+    avfilter_graph_free(&mGraph);
+}
+
+int PaletteQuantizer::send(AVFrame const *frame)
+{
+    if (!frame)
+        return mSource ? av_buffersrc_add_frame(mSource, nullptr) : 0;
+
+    int ret = 0;
+    if (!mGraph && (ret = createGraph(frame)) < 0)
+    {
+        avfilter_graph_free(&mGraph);
+        mSource = mSink = nullptr;
+        return ret;
+    }
+
+    // paletteuse按时间戳对齐调色板与帧  缺少时间戳时按顺序编号
+    AVFrame *input = av_frame_clone(frame);
+    if (!input)
+        return AVERROR(ENOMEM);
+    if (input->pts == AV_NOPTS_VALUE)
+        input->pts = mNextPts;
+    mNextPts = input->pts + 1;
+
+    ret = av_buffersrc_add_frame_flags(mSource, input, 0);
+    av_frame_free(&input);
+    return ret;
+}
+
+int PaletteQuantizer::receive(AVFrame *output)
+{
+    if (!mSink)
+        return AVERROR_EOF;
+    return av_buffersink_get_frame(mSink, output);
+}
+
+int PaletteQuantizer::createGraph(AVFrame const *frame)
+{
+    if (!(mGraph = avfilter_graph_alloc()))
+        return AVERROR(ENOMEM);
+
+    char args[512];
+    snprintf(args, sizeof(args),
+             "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=1/1",
+             frame->width, frame->height, frame->format, mTimeBase.num, mTimeBase.den);
+
+    int ret = avfilter_graph_create_filter(
+        &mSource, avfilter_get_by_name("buffer"), "in", args, nullptr, mGraph);
+    if (ret < 0)
+        return ret;
+    if ((ret = avfilter_graph_create_filter(
+             &mSink, avfilter_get_by_name("buffersink"), "out", nullptr, nullptr, mGraph)) < 0)
+        return ret;
+
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    if (!outputs || !inputs)
+    {
+        avfilter_inout_free(&outputs);
+        avfilter_inout_free(&inputs);
+        return AVERROR(ENOMEM);
+    }
+
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = mSource;
+    outputs->pad_idx = 0;
+    outputs->next = nullptr;
+
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = mSink;
+    inputs->pad_idx = 0;
+    inputs->next = nullptr;
+
+    ret = avfilter_graph_parse_ptr(mGraph, kPaletteDesc, &inputs, &outputs, nullptr);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    if (ret < 0 || (ret = avfilter_graph_config(mGraph, nullptr)) < 0)
+    {
+        std::cerr << "无法创建调色板量化滤镜图" << std::endl;
+        return ret;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+extern "C"
+{
+#include <libavfilter/avfilter.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+namespace ImageFlow
+{
+
+/* GIF调色板量化
+ * 以palettegen/paletteuse滤镜图为每帧生成最多256色的调色板  误差扩散抖动后输出PAL8帧
+ * 替代固定的3-3-2调色板（BGR8）  渐变处不再出现明显的色带  保留一个透明色
+ * 滤镜图在送入第一帧时按帧的尺寸与像素格式创建  之后的帧须与第一帧一致
+ * 用法与编解码器相同：send送入帧  receive取出结果  送入nullptr冲刷
+ */
+class PaletteQuantizer
+{
+public:
+    // 量化前的像素格式  palettegen与paletteuse只接受该格式  其余格式在滤镜图内转换
+    static constexpr AVPixelFormat kInputFormat = AV_PIX_FMT_RGB32;
+
+private:
+    AVRational mTimeBase;               // 输入帧时间戳的时间基
+    AVFilterGraph *mGraph = nullptr;    // 量化滤镜图
+    AVFilterContext *mSource = nullptr; // 缓冲区源
+    AVFilterContext *mSink = nullptr;   // 缓冲区接收器
+    int64_t mNextPts = 0;               // 没有时间戳的帧使用的时间戳
+
+public:
+    explicit PaletteQuantizer(AVRational timeBase = {1, 1});
+    ~PaletteQuantizer();
+
+    PaletteQuantizer(PaletteQuantizer const &) = delete;
+    PaletteQuantizer &operator=(PaletteQuantizer const &) = delete;
+
+public:
+    // 送入一帧  frame为nullptr时冲刷  时间戳须单调递增
+    int send(AVFrame const *frame);
+
+    // 取出一帧量化结果  暂无输出时返回AVERROR(EAGAIN)  冲刷完毕返回AVERROR_EOF
+    int receive(AVFrame *output);
+
+private:
+    int createGraph(AVFrame const *frame);
+};
+
+} // namespace ImageFlow
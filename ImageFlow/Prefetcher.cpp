@@ -0,0 +1,114 @@
+#include "Prefetcher.h"
+//--------------------------
+#include <algorithm>
+#include <cmath>
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+Prefetcher::Prefetcher(ThreadPool &pool, PrefetchOptions const &options)
+    : mPool(pool), mOptions(options), mRateSince(Clock::now())
+{
+    mOptions.minWindow = std::max<size_t>(mOptions.minWindow, 1);
+    mOptions.maxWindow = std::max(mOptions.maxWindow, mOptions.minWindow);
+    mOptions.sampleEvery = std::max<size_t>(mOptions.sampleEvery, 1);
+    mStats.window = mOptions.minWindow;
+}
+
+void Prefetcher::enqueue(std::vector<std::string> const &paths)
+{
+    std::vector<std::string> batch;
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        mPending.insert(mPending.end(), paths.begin(), paths.end());
+        batch = advanceLocked();
+    }
+    hint(batch);
+}
+
+void Prefetcher::noteRead(std::string const &path, bool reading)
+{
+    // 在出队之前查询  反映的是读取开始时的状态
+    // 查询需要mmap与mincore  按间隔抽样  驻留比例仍有代表性
+    bool sampled = reading && mReadCount.fetch_add(1) % mOptions.sampleEvery == 0;
+    int resident = sampled ? Utils::isFileResident(path) : -1;
+
+    std::vector<std::string> batch;
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+
+        // 多个I/O线程并行读取  顺序会略有出入  被读取的文件通常在窗口内
+        auto it = std::find(mPending.begin(), mPending.end(), path);
+        if (it != mPending.end())
+        {
+            if (static_cast<size_t>(it - mPending.begin()) < mHinted)
+                --mHinted;
+            mPending.erase(it);
+        }
+
+        bool warmed = reading && mWarmed.erase(path) > 0;
+        if (sampled)
+        {
+            // 无法查询页缓存时  以后台读取是否已完成代替
+            if (resident < 0)
+                resident = warmed ? 1 : 0;
+            ++mStats.reads;
+            if (resident > 0)
+                ++mStats.resident;
+        }
+
+        ++mRateReads;
+        batch = advanceLocked();
+    }
+    hint(batch);
+}
+
+Prefetcher::Stats Prefetcher::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mStats;
+}
+
+std::vector<std::string> Prefetcher::advanceLocked()
+{
+    // 速率按不短于0.25秒的区间采样  指数平滑
+    auto now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - mRateSince).count();
+    if (elapsed >= 0.25)
+    {
+        double rate = mRateReads / elapsed;
+        mStats.rate = mStats.rate > 0.0 ? mStats.rate * 0.7 + rate * 0.3 : rate;
+        mRateSince = now;
+        mRateReads = 0;
+
+        auto window = static_cast<size_t>(std::ceil(mStats.rate * mOptions.leadSeconds));
+        mStats.window = std::clamp(window, mOptions.minWindow, mOptions.maxWindow);
+    }
+
+    std::vector<std::string> batch;
+    size_t limit = std::min(mStats.window, mPending.size());
+    for (; mHinted < limit; ++mHinted)
+        batch.push_back(mPending[mHinted]);
+    mStats.hinted += batch.size();
+    return batch;
+}
+
+void Prefetcher::hint(std::vector<std::string> const &paths)
+{
+    for (auto &&path : paths)
+    {
+        if (Utils::adviseWillNeed(path))
+            continue;
+
+        // 低优先级  不挡住正在等待的读写
+        mPool.submitWithPriority(TaskPriority::LOW, std::chrono::milliseconds(0), [this, path]
+                                 {
+                                     if (!Utils::touchFile(path))
+                                         return;
+                                     // 已被读取的文件不再记录
+                                     std::lock_guard<std::mutex> _(mMutex);
+                                     if (std::find(mPending.begin(), mPending.end(), path) != mPending.end())
+                                         mWarmed.insert(path); });
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+//--------------------------
+#include "ThreadPool.hpp"
+
+namespace ImageFlow
+{
+
+/* 预取参数 */
+struct PrefetchOptions
+{
+    size_t minWindow = 2;     // 窗口下限（文件数）
+    size_t maxWindow = 64;    // 窗口上限
+    double leadSeconds = 1.0; // 提前量  窗口约为解码速率 × 提前量
+    size_t sampleEvery = 16;  // 每隔多少次读取检查一次驻留情况（mmap+mincore）
+};
+
+/* 输入预取
+ * 按处理顺序记录待读取的输入  每读取一个  就对其后窗口内的文件发出预读
+ * Linux上用posix_fadvise(WILLNEED)让内核异步读入页缓存  其他平台在I/O线程池中以低优先级读一遍
+ * 窗口随实测的读取速率调整  慢盘上快速消耗时窗口变大
+ */
+class Prefetcher
+{
+public:
+    /* 预取统计 */
+    struct Stats
+    {
+        size_t hinted = 0;   // 发出预取的文件数
+        size_t reads = 0;    // 检查过驻留情况的读取次数（抽样）
+        size_t resident = 0; // 读取时数据已全部在缓存中的次数
+        size_t window = 0;   // 当前窗口
+        double rate = 0.0;   // 实测读取速率（文件/秒）
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    ThreadPool &mPool;                       // 不支持预读提示时在此执行后台读取
+    PrefetchOptions mOptions;
+    mutable std::mutex mMutex;               // 保护以下状态
+    std::deque<std::string> mPending;        // 尚未读取的输入  按处理顺序
+    size_t mHinted = 0;                      // mPending前部已发出预取的个数
+    std::unordered_set<std::string> mWarmed; // 后台读取已完成的文件
+    Clock::time_point mRateSince;            // 本次速率采样的起点
+    std::atomic<size_t> mReadCount = 0;      // 读取次数  用于抽样检查驻留情况
+    size_t mRateReads = 0;                   // 本次速率采样内的读取数
+    Stats mStats;                            // 统计
+
+public:
+    explicit Prefetcher(ThreadPool &pool, PrefetchOptions const &options = {});
+
+    Prefetcher(Prefetcher const &) = delete;
+    Prefetcher &operator=(Prefetcher const &) = delete;
+
+public:
+    // 追加即将处理的输入  并对窗口内的文件发出预取
+    void enqueue(std::vector<std::string> const &paths);
+
+    // 输入即将被读取  reading为false表示不读文件（如帧缓存命中）  不计入驻留统计
+    void noteRead(std::string const &path, bool reading = true);
+
+    Stats getStats() const;
+
+private:
+    // 按速率更新窗口  取出窗口内尚未预取的文件  调用时持有mMutex
+    std::vector<std::string> advanceLocked();
+
+    void hint(std::vector<std::string> const &paths);
+};
+
+} // namespace ImageFlow
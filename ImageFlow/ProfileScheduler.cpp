@@ -0,0 +1,142 @@
+#include "ProfileScheduler.h"
+//--------------------------
+#include <algorithm>
+#include <utility>
+//--------------------------
+#include "Defer.hpp"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+int64_t microsBetween(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+}
+
+} // namespace
+
+ProfileScheduler::ProfileScheduler(ThreadPool &pool, size_t capacity)
+    : mPool(pool), mCapacity(capacity)
+{
+}
+
+void ProfileScheduler::setWeight(std::string const &profile, int weight)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    mProfiles[profileIndex(profile)].stats.weight = std::max(weight, 1);
+}
+
+void ProfileScheduler::enqueue(std::string const &profile, std::function<void()> task)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    auto &entry = mProfiles[profileIndex(profile)];
+    entry.queue.push_back({std::move(task), Clock::now()});
+    ++entry.stats.submitted;
+    ++entry.stats.queued;
+    ++mQueued;
+    dispatch();
+}
+
+void ProfileScheduler::noteResult(std::string const &profile, bool ok, int64_t outputBytes)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    auto &stats = mProfiles[profileIndex(profile)].stats;
+    if (!ok)
+        ++stats.failed;
+    stats.outputBytes += outputBytes;
+}
+
+void ProfileScheduler::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this]
+               { return mQueued == 0 && mRunning == 0; });
+}
+
+size_t ProfileScheduler::getQueuedCount() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mQueued;
+}
+
+std::vector<ProfileScheduler::Stats> ProfileScheduler::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    std::vector<Stats> stats;
+    stats.reserve(mProfiles.size());
+    for (auto &&profile : mProfiles)
+        stats.push_back(profile.stats);
+    return stats;
+}
+
+size_t ProfileScheduler::profileIndex(std::string const &profile)
+{
+    // 配置档数量很少  线性查找即可
+    for (size_t i = 0; i < mProfiles.size(); ++i)
+    {
+        if (mProfiles[i].stats.profile == profile)
+            return i;
+    }
+    auto &entry = mProfiles.emplace_back();
+    entry.stats.profile = profile;
+    entry.credit = entry.stats.weight;
+    return mProfiles.size() - 1;
+}
+
+void ProfileScheduler::dispatch()
+{
+    // 线程池可能在线调整大小  未指定上限时每次按当前线程数计算
+    size_t capacity = mCapacity > 0 ? mCapacity : std::max<size_t>(mPool.getThreadCount(), 1);
+    while (mRunning < capacity && mQueued > 0)
+    {
+        // 从轮转位置开始找第一个有排队任务且本轮仍有名额的配置档
+        size_t idx = mCursor;
+        for (size_t step = 0; step <= mProfiles.size(); ++step)
+        {
+            auto &entry = mProfiles[mCursor];
+            if (!entry.queue.empty() && entry.credit > 0)
+            {
+                idx = mCursor;
+                break;
+            }
+            entry.credit = entry.stats.weight;
+            mCursor = (mCursor + 1) % mProfiles.size();
+        }
+
+        auto &entry = mProfiles[idx];
+        auto task = std::move(entry.queue.front());
+        entry.queue.pop_front();
+        --entry.credit;
+        --entry.stats.queued;
+        ++entry.stats.running;
+        --mQueued;
+        ++mRunning;
+
+        mPool.submit([this, idx, submitTime = task.submitTime, func = std::move(task.func)]()
+                     {
+                         // 任务抛出异常时同样归还名额
+                         auto startTime = Clock::now();
+                         DEFER(onFinished(idx, submitTime, startTime));
+                         func(); });
+    }
+}
+
+void ProfileScheduler::onFinished(
+    size_t profileIdx,
+    Clock::time_point submitTime,
+    Clock::time_point startTime)
+{
+    auto endTime = Clock::now();
+    std::lock_guard<std::mutex> _(mMutex);
+    auto &stats = mProfiles[profileIdx].stats;
+    --stats.running;
+    ++stats.completed;
+    stats.queueUs += microsBetween(submitTime, startTime);
+    stats.busyUs += microsBetween(startTime, endTime);
+    --mRunning;
+    dispatch();
+    if (mQueued == 0 && mRunning == 0)
+        mIdle.notify_all();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+//--------------------------
+#include "ThreadPool.hpp"
+
+namespace ImageFlow
+{
+
+/* 按配置档公平调度
+ * 各配置档的任务分别排队  按权重轮流送入共享线程池
+ * 线程池中同时只保留capacity个任务  某个配置档的大批任务不会让其他配置档长时间排队
+ */
+class ProfileScheduler
+{
+public:
+    /* 配置档统计  耗时均为微秒 */
+    struct Stats
+    {
+        std::string profile;     // 配置档名称 空字符串为默认配置
+        int weight = 1;          // 轮转权重
+        size_t submitted = 0;    // 提交数
+        size_t completed = 0;    // 完成数
+        size_t failed = 0;       // 失败数
+        size_t queued = 0;       // 当前排队数
+        size_t running = 0;      // 当前执行数
+        int64_t queueUs = 0;     // 累计排队时间
+        int64_t busyUs = 0;      // 累计执行时间
+        int64_t outputBytes = 0; // 累计输出字节数
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /* 排队中的任务 */
+    struct Task
+    {
+        std::function<void()> func;
+        Clock::time_point submitTime;
+    };
+
+    /* 单个配置档的队列 */
+    struct Profile
+    {
+        std::deque<Task> queue; // 排队任务
+        int credit = 0;         // 本轮剩余的连续出队次数
+        Stats stats;            // 统计
+    };
+
+private:
+    ThreadPool &mPool;
+    size_t mCapacity;               // 同时送入线程池的任务上限 0表示跟随线程数
+    mutable std::mutex mMutex;      // 保护以下状态
+    std::condition_variable mIdle;  // 全部任务完成通知
+    std::vector<Profile> mProfiles; // 按首次出现顺序排列
+    size_t mCursor = 0;             // 轮转位置
+    size_t mRunning = 0;            // 已送入线程池的任务数
+    size_t mQueued = 0;             // 排队任务总数
+
+public:
+    ProfileScheduler(ThreadPool &pool, size_t capacity = 0);
+
+    ProfileScheduler(ProfileScheduler const &) = delete;
+    ProfileScheduler &operator=(ProfileScheduler const &) = delete;
+
+public:
+    // 设置配置档的轮转权重  每轮最多连续出队weight个任务
+    void setWeight(std::string const &profile, int weight);
+
+    // 任务排队  有空闲名额时立即送入线程池
+    void enqueue(std::string const &profile, std::function<void()> task);
+
+    // 记录任务结果  在任务内调用
+    void noteResult(std::string const &profile, bool ok, int64_t outputBytes);
+
+    // 等待所有排队与执行中的任务完成
+    void waitIdle();
+
+    // 尚未送入线程池的任务数  即线程池之外的积压
+    size_t getQueuedCount() const;
+
+    std::vector<Stats> getStats() const;
+
+private:
+    // 配置档在mProfiles中的下标  不存在时创建  调用时持有mMutex
+    size_t profileIndex(std::string const &profile);
+
+    // 按权重轮转选出下一个任务送入线程池  调用时持有mMutex
+    void dispatch();
+
+    // 任务结束  归还名额并继续分派
+    void onFinished(
+        size_t profileIdx,
+        Clock::time_point submitTime,
+        Clock::time_point startTime);
+};
+
+} // namespace ImageFlow
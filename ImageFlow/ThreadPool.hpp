@@ -1,3 +1,6 @@
+#pragma once
+
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -12,25 +15,27 @@
 #include <unordered_map>
 #include <utility>
 #include <vector>
+//--------------------------
+#include "InstrumentedMutex.h"
 
-/* ȼ */
+/* 任务优先级 */
 enum class TaskPriority
 {
     LOW,
     NORMAL,
     HIGH,
-    URGENT, // 
+    URGENT, // 紧急
 };
 
-/* ܾ */
+/* 拒绝策略 */
 enum class RejectPolicy
 {
-    THROW,   // ׳쳣
-    BLOCK,   // ȴ
-    DISCARD, // Ĭ
+    THROW,   // 抛出异常
+    BLOCK,   // 阻塞等待
+    DISCARD, // 静默丢弃
 };
 
-/* װ  洢 */
+/* 任务包装器 擦除类型 方便存储 */
 class TaskWrapper
 {
 private:
@@ -73,12 +78,12 @@ public:
     }
 };
 
-/* ȼȽ */
+/* 优先级比较器 */
 struct TaskComparator
 {
     bool operator()(const TaskWrapper &a, const TaskWrapper &b) const
     {
-        // ȼߵִ  ύִ
+        // 优先级高的先执行  提交早的先执行
         if (a.getPriority() != b.getPriority())
         {
             return static_cast<int>(a.getPriority()) < static_cast<int>(b.getPriority());
@@ -87,39 +92,51 @@ struct TaskComparator
     }
 };
 
-/* ̳߳ */
+/* 线程池 */
 class ThreadPool
 {
 private:
     using TaskQueue = std::priority_queue<TaskWrapper, std::vector<TaskWrapper>, TaskComparator>;
 
 public:
-    /* ״̬ */
+    /* 任务状态 */
     struct TaskStats
     {
-        size_t submitted = 0; // ύ
-        size_t completed = 0; // 
-        size_t failed = 0;    // ʧ
+        size_t submitted = 0; // 提交数
+        size_t completed = 0; // 完成数
+        size_t failed = 0;    // 失败数
     };
 
-    /* ̳߳״̬ */
+    /* 线程池状态 */
     struct PoolStatus
     {
-        size_t queueSize;    // ǰдС
-        size_t activeTasks;  // Ծ
-        size_t totalThreads; // ߳
-        size_t maxQueueSize; // дС
+        size_t queueSize;    // 当前队列大小
+        size_t activeTasks;  // 活跃任务数
+        size_t totalThreads; // 线程总数
+        size_t maxQueueSize; // 最大队列大小
+    };
+
+    /* 利用率统计 */
+    struct Utilization
+    {
+        double busySeconds;   // 累计执行任务的时间
+        double threadSeconds; // 累计线程在线时间（按目标线程数积分）
+        double utilization;   // busySeconds / threadSeconds
     };
 
 public:
+    // 默认线程数为硬件线程数  需要遵循容器CPU配额时由调用者传入
+    // lockName为队列锁在锁统计中的名称  须为字符串字面量  同时存在多个线程池时各取一个名称以区分
     explicit ThreadPool(
-        size_t numThreads = std::thread::hardware_concurrency(),
+        size_t numThreads = defaultThreadCount(),
         size_t maxQueueSize = 1000,
-        RejectPolicy policy = RejectPolicy::BLOCK // Ĭ
-        )
-        : mStop(false), mMaxQueueSize(maxQueueSize),
+        RejectPolicy policy = RejectPolicy::BLOCK, // 默认阻塞
+        char const *lockName = "ThreadPool::mQueueMutex")
+        : mQueueMutex(lockName), mStop(false), mMaxQueueSize(maxQueueSize),
           mActiveTasks(0), mRejectPolicy(policy)
     {
+        mTargetThreads = numThreads;
+        mThreadSince = std::chrono::steady_clock::now();
         for (size_t i = 0; i < numThreads; ++i)
         {
             // clang-format off
@@ -128,6 +145,11 @@ public:
         }
     }
 
+    static size_t defaultThreadCount()
+    {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
     ~ThreadPool()
     {
         shutdown();
@@ -140,7 +162,7 @@ public:
         return submitImpl(
             TaskPriority::NORMAL,
             "unnamed_task",
-            std::chrono::milliseconds(0), // Ĭϲʱ
+            std::chrono::milliseconds(0), // 默认不超时
             std::forward<F>(f),
             std::forward<Args>(args)...);
     }
@@ -174,7 +196,7 @@ public:
             std::forward<Args>(args)...);
     }
 
-    // Ա֧ ύԱ
+    // 成员函数支持 提交成员函数任务
     template <typename R, typename C, typename... Args>
     auto submitMember(C *obj, R (C::*memberFunc)(Args...), Args &&...args)
     {
@@ -183,7 +205,7 @@ public:
             { return (obj->*memberFunc)(args...); });
     }
 
-    // constԱ֧
+    // const成员函数支持
     template <typename R, typename C, typename... Args>
     auto submitMemberConst(const C *obj, R (C::*memberFunc)(Args...) const, Args &&...args)
     {
@@ -192,7 +214,7 @@ public:
             { return (obj->*memberFunc)(args...); });
     }
 
-    // lambdaʽ֧֣ʽָͣ
+    // lambda表达式支持（显式指定返回类型）
     template <typename R, typename F, typename... Args>
     auto submitLambda(F &&f, Args &&...args)
     {
@@ -202,16 +224,16 @@ public:
     void shutdown()
     {
         {
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
             if (mStop.load())
                 return;
             mStop.store(true);
         }
 
-        // ֪ͨеȴ߳
+        // 通知所有等待的线程
         mCondition.notify_all();
 
-        // ȴй߳̽
+        // 等待所有工作线程结束
         for (std::thread &worker : mWorkers)
         {
             if (worker.joinable())
@@ -222,23 +244,24 @@ public:
         std::cout << "ThreadPool shutdown completed." << std::endl;
     }
 
-    // Źر ȴ
+    // 优雅关闭 等待所有任务完成
     void shutdownGraceful()
     {
         {
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
             if (mStop.load())
                 return;
+            mDrain.store(true); // 停止后工作线程继续取完队列
             mStop.store(true);
         }
 
-        // ȴύ
+        // 等待所有已提交的任务完成
         waitAll();
 
-        // ֪ͨеȴ߳
+        // 通知所有等待的线程
         mCondition.notify_all();
 
-        // ȴй߳̽
+        // 等待所有工作线程结束
         for (std::thread &worker : mWorkers)
         {
             if (worker.joinable())
@@ -246,27 +269,32 @@ public:
         }
 
         mWorkers.clear();
+        mDrain.store(false);
         std::cout << "ThreadPool graceful shutdown completed." << std::endl;
     }
 
     /**
-     * @brief ̳߳أ´̡߳
-     * @brief ÷̰߳ȫģȷڵʱû߳ʹ̳߳ء
+     * @brief 重启线程池，清空所有任务并重新创建工作线程。
+     * @brief 该方法不是线程安全的，确保在调用时没有其他线程在使用线程池。
      */
-    void restart(size_t numThreads = std::thread::hardware_concurrency())
+    void restart(size_t numThreads = defaultThreadCount())
     {
-        shutdown(); // ȹر
+        shutdown(); // 先关闭
 
         {
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
             mStop.store(false);
-            // 
+            // 清空任务队列
             while (!mTasks.empty())
                 mTasks.pop();
             mActiveTasks.store(0);
+            mRetireCount = 0;
+            mRetired.clear();
+            accrueThreadTimeLocked();
+            mTargetThreads = numThreads;
         }
 
-        // µĹ߳
+        // 创建新的工作线程
         for (size_t i = 0; i < numThreads; ++i)
         {
             // clang-format off
@@ -277,60 +305,123 @@ public:
         std::cout << "ThreadPool restarted with " << numThreads << " threads." << std::endl;
     }
 
+    /**
+     * @brief 在线调整工作线程数，不清空队列、不等待任务完成。
+     * @brief 增加时立即创建线程；减少时空闲线程立即退出，忙碌线程在完成当前任务后退出。
+     */
+    void resize(size_t numThreads)
+    {
+        numThreads = std::max<size_t>(numThreads, 1);
+        std::vector<std::thread> finished;
+        {
+            ImageFlow::ProfiledLock lock(mQueueMutex);
+            if (mStop.load())
+                return;
+
+            finished = takeRetiredLocked();
+            size_t live = mWorkers.size() - mRetireCount;
+            if (numThreads > live)
+            {
+                // 先抵消尚未退出的退休名额
+                size_t grow = numThreads - live;
+                size_t cancel = std::min(grow, mRetireCount);
+                mRetireCount -= cancel;
+                for (size_t i = cancel; i < grow; ++i)
+                {
+                    // clang-format off
+                    mWorkers.emplace_back([this] { workerLoop(); });
+                    // clang-format on
+                }
+            }
+            else
+            {
+                mRetireCount += live - numThreads;
+            }
+            accrueThreadTimeLocked();
+            mTargetThreads = numThreads;
+        }
+        mCondition.notify_all();
+
+        for (auto &worker : finished)
+            worker.join();
+    }
+
+    size_t getThreadCount() const
+    {
+        return mTargetThreads.load();
+    }
+
     void setRejectPolicy(RejectPolicy policy)
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
+        ImageFlow::ProfiledLock lock(mQueueMutex);
         mRejectPolicy = policy;
     }
 
-    // ȴɣеĺִеģ
+    // 等待所有任务完成（包括队列中的和正在执行的）
     void waitAll()
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
+        ImageFlow::ProfiledLock lock(mQueueMutex);
         mAllDoneCondition.wait(lock, [this]
                                { return mTasks.empty() && mActiveTasks.load() == 0; });
     }
 
-    // ʱĵȴ
+    // 带超时的等待
     bool waitAllFor(std::chrono::milliseconds timeout)
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
+        ImageFlow::ProfiledLock lock(mQueueMutex);
         return mAllDoneCondition.wait_for(lock, timeout, [this]
                                           { return mTasks.empty() && mActiveTasks.load() == 0; });
     }
 
-    // ȴֱָʱ
+    // 等待直到指定时间
     bool waitAllUntil(std::chrono::steady_clock::time_point deadline)
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
+        ImageFlow::ProfiledLock lock(mQueueMutex);
         return mAllDoneCondition.wait_until(lock, deadline, [this]
                                             { return mTasks.empty() && mActiveTasks.load() == 0; });
     }
 
     std::unordered_map<std::string, TaskStats> getTaskStatistics() const
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
+        ImageFlow::ProfiledLock lock(mQueueMutex);
         return mTaskStatistics;
     }
 
     PoolStatus getStatus() const
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
-        return PoolStatus{mTasks.size(), mActiveTasks.load(), mWorkers.size(), mMaxQueueSize};
+        ImageFlow::ProfiledLock lock(mQueueMutex);
+        return PoolStatus{mTasks.size(), mActiveTasks.load(), mTargetThreads.load(), mMaxQueueSize};
+    }
+
+    // 自创建以来的利用率  线程数调整过时按各时段的线程数累计
+    Utilization getUtilization() const
+    {
+        ImageFlow::ProfiledLock lock(mQueueMutex);
+        std::chrono::duration<double> since = std::chrono::steady_clock::now() - mThreadSince;
+        double threadSeconds = mThreadNanos / 1e9 + since.count() * mTargetThreads.load();
+        double busySeconds = mBusyNanos.load() / 1e9;
+        return Utilization{busySeconds, threadSeconds, threadSeconds > 0.0 ? busySeconds / threadSeconds : 0.0};
     }
 
 private:
-    std::vector<std::thread> mWorkers;                          // ߳
-    TaskQueue mTasks;                                           // 
-    mutable std::mutex mQueueMutex;                             // л
-    std::condition_variable mCondition;                         // 
-    std::condition_variable mAllDoneCondition;                  // 
-    std::condition_variable mNotFullCondition;                  // δ
-    std::atomic<bool> mStop;                                    // ֹ̳߳ͣ־
-    std::atomic<size_t> mActiveTasks;                           // Ծ
-    size_t mMaxQueueSize;                                       // дС
-    std::unordered_map<std::string, TaskStats> mTaskStatistics; // ͳ
-    RejectPolicy mRejectPolicy;                                 // ʱľܾ
+    std::vector<std::thread> mWorkers;                          // 工作线程
+    TaskQueue mTasks;                                           // 任务队列
+    mutable ImageFlow::ProfiledMutex mQueueMutex;               // 任务队列互斥锁
+    ImageFlow::ProfiledCondition mCondition;                    // 任务可用条件变量
+    ImageFlow::ProfiledCondition mAllDoneCondition;             // 所有任务完成条件变量
+    ImageFlow::ProfiledCondition mNotFullCondition;             // 队列未满条件变量
+    std::atomic<bool> mStop;                                    // 线程池停止标志
+    std::atomic<size_t> mActiveTasks;                           // 活跃任务数
+    size_t mMaxQueueSize;                                       // 最大队列大小
+    std::unordered_map<std::string, TaskStats> mTaskStatistics; // 任务统计
+    RejectPolicy mRejectPolicy;                                 // 队列满时的拒绝策略
+    std::atomic<bool> mDrain = false;                           // 停止后仍取完队列（优雅关闭）
+    std::atomic<size_t> mTargetThreads = 0;                     // 目标线程数
+    size_t mRetireCount = 0;                                    // 待退出的线程数
+    std::vector<std::thread::id> mRetired;                      // 已退出待回收的线程
+    std::atomic<int64_t> mBusyNanos = 0;                        // 累计执行任务的时间
+    int64_t mThreadNanos = 0;                                   // 截至mThreadSince的线程在线时间
+    std::chrono::steady_clock::time_point mThreadSince;         // 线程数最近一次变化的时间
 
 private:
     template <typename F, typename... Args>
@@ -342,7 +433,7 @@ private:
     {
         using ResultType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
 
-        // packaged_task
+        // 创建packaged_task
         auto task = std::make_shared<std::packaged_task<ResultType()>>(
             [func = std::forward<F>(f), argsTuple = std::make_tuple(std::forward<Args>(args)...)]() mutable
             {
@@ -352,12 +443,12 @@ private:
         auto future = task->get_future();
 
         {
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
 
             if (mStop.load())
                 throw std::runtime_error("submit on stopped ThreadPool");
 
-            // ݾܾԴ
+            // 根据拒绝策略处理队列满的情况
             if (mTasks.size() >= mMaxQueueSize)
             {
                 switch (mRejectPolicy)
@@ -368,7 +459,7 @@ private:
                 case RejectPolicy::BLOCK:
                     if (timeout.count() > 0)
                     {
-                        // ʱĵȴ
+                        // 带超时的等待
                         if (!mNotFullCondition.wait_for(lock, timeout, [this]
                                                         { return mTasks.size() < mMaxQueueSize || mStop.load(); }))
                         {
@@ -377,7 +468,7 @@ private:
                     }
                     else
                     {
-                        // ڵȴ
+                        // 无限期等待
                         mNotFullCondition.wait(lock, [this]
                                                { return mTasks.size() < mMaxQueueSize || mStop.load(); });
                     }
@@ -387,7 +478,7 @@ private:
 
                 case RejectPolicy::DISCARD:
                     mTaskStatistics[taskName + "_discarded"].submitted++;
-                    // ɵfuture쳣
+                    // 创建已完成的future，包含异常
                     std::promise<ResultType> promise;
                     promise.set_exception(std::make_exception_ptr(
                         std::runtime_error("Task discarded due to full queue")));
@@ -395,7 +486,7 @@ private:
                 }
             }
 
-            // TaskWrapperװʵʵִ߼
+            // 创建TaskWrapper，包装实际的执行逻辑
             TaskWrapper wrapper(
                 [task]
                 { (*task)(); },
@@ -411,7 +502,7 @@ private:
 
     void workerLoop()
     {
-        while (!mStop.load())
+        while (!mStop.load() || mDrain.load())
         {
             auto task = getNextTask();
             if (!task)
@@ -421,12 +512,47 @@ private:
         }
     }
 
+    // 把上次线程数变化以来的在线时间计入mThreadNanos  调用时持有mQueueMutex
+    void accrueThreadTimeLocked()
+    {
+        auto now = std::chrono::steady_clock::now();
+        mThreadNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(now - mThreadSince).count() *
+                        static_cast<int64_t>(mTargetThreads.load());
+        mThreadSince = now;
+    }
+
+    // 取出已退出线程的句柄  由调用者在锁外join  调用时持有mQueueMutex
+    std::vector<std::thread> takeRetiredLocked()
+    {
+        std::vector<std::thread> finished;
+        for (auto id : mRetired)
+        {
+            auto it = std::find_if(mWorkers.begin(), mWorkers.end(), [id](std::thread const &worker)
+                                   { return worker.get_id() == id; });
+            if (it != mWorkers.end())
+            {
+                finished.push_back(std::move(*it));
+                mWorkers.erase(it);
+            }
+        }
+        mRetired.clear();
+        return finished;
+    }
+
     std::unique_ptr<TaskWrapper> getNextTask()
     {
-        std::unique_lock<std::mutex> lock(mQueueMutex);
+        ImageFlow::ProfiledLock lock(mQueueMutex);
 
         mCondition.wait(lock, [this]
-                        { return mStop.load() || !mTasks.empty(); });
+                        { return mStop.load() || !mTasks.empty() || mRetireCount > 0; });
+
+        // 缩容  由先醒来的线程退出
+        if (mRetireCount > 0 && !mStop.load())
+        {
+            --mRetireCount;
+            mRetired.push_back(std::this_thread::get_id());
+            return nullptr;
+        }
 
         if (mStop.load() && mTasks.empty())
             return nullptr;
@@ -435,30 +561,34 @@ private:
         mTasks.pop();
         mActiveTasks++;
 
-        // ֪ͨпռ
+        // 通知队列有空间可用
         mNotFullCondition.notify_one();
 
-        // ض϶ʹƶԱ⿽
+        // 返回堆上对象，使用移动以避免额外拷贝
         return std::make_unique<TaskWrapper>(std::move(top));
     }
 
     void executeTask(std::unique_ptr<TaskWrapper> task)
     {
+        auto begin = std::chrono::steady_clock::now();
         try
         {
             task->execute();
 
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
             mTaskStatistics[task->getName()].completed++;
         }
         catch (...)
         {
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
             mTaskStatistics[task->getName()].failed++;
         }
+        mBusyNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - begin)
+                          .count();
 
         {
-            std::unique_lock<std::mutex> lock(mQueueMutex);
+            ImageFlow::ProfiledLock lock(mQueueMutex);
             mActiveTasks--;
             if (mTasks.empty() && mActiveTasks.load() == 0)
             {
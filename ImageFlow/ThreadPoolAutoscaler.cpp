@@ -0,0 +1,129 @@
+#include "ThreadPoolAutoscaler.h"
+//--------------------------
+#include <algorithm>
+//--------------------------
+#include "Logger.hpp"
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+ThreadPoolAutoscaler::ThreadPoolAutoscaler(
+    ThreadPool &pool,
+    AutoscaleOptions const &options,
+    std::function<size_t()> backlog)
+    : mPool(pool), mOptions(options), mBacklog(std::move(backlog)),
+      mCpuLimit(std::max<size_t>(Utils::cpuLimit(), 1))
+{
+    mOptions.minThreads = std::max<size_t>(mOptions.minThreads, 1);
+    if (mOptions.maxThreads == 0)
+        mOptions.maxThreads = mCpuLimit * 2;
+    mOptions.maxThreads = std::max(mOptions.maxThreads, mOptions.minThreads);
+    mStats.threads = mPool.getThreadCount();
+
+    // clang-format off
+    mThread = std::thread([this] { run(); });
+    // clang-format on
+}
+
+ThreadPoolAutoscaler::~ThreadPoolAutoscaler()
+{
+    stop();
+}
+
+void ThreadPoolAutoscaler::stop()
+{
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable())
+        mThread.join();
+}
+
+ThreadPoolAutoscaler::Stats ThreadPoolAutoscaler::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    return mStats;
+}
+
+void ThreadPoolAutoscaler::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto lastWall = Clock::now();
+    double lastCpu = Utils::processCpuSeconds();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mCondition.wait_for(lock, mOptions.interval, [this]
+                                { return mStop; }))
+    {
+        lock.unlock();
+
+        // 利用率 = 进程CPU时间增量 / (墙钟时间增量 × 可用CPU数)
+        auto wall = Clock::now();
+        double cpu = Utils::processCpuSeconds();
+        double elapsed = std::chrono::duration<double>(wall - lastWall).count();
+        double utilization = elapsed > 0.0 ? (cpu - lastCpu) / (elapsed * mCpuLimit) : 0.0;
+        lastWall = wall;
+        lastCpu = cpu;
+
+        auto status = mPool.getStatus();
+        size_t queued = status.queueSize + (mBacklog ? mBacklog() : 0);
+        size_t threads = mPool.getThreadCount();
+        size_t target = decide(threads, queued, status, utilization);
+        if (target != threads)
+        {
+            mPool.resize(target);
+            LOG_DEBUG("线程池调整：{} -> {}  积压 {}  活跃 {}  CPU利用率 {:.2f}",
+                      threads, target, queued, status.activeTasks, utilization);
+        }
+
+        lock.lock();
+        ++mStats.samples;
+        if (target > threads)
+            ++mStats.grows;
+        else if (target < threads)
+            ++mStats.shrinks;
+        mStats.threads = target;
+        mStats.utilization = utilization;
+    }
+}
+
+size_t ThreadPoolAutoscaler::decide(
+    size_t threads,
+    size_t queued,
+    ThreadPool::PoolStatus const &status,
+    double utilization)
+{
+    bool saturated = utilization >= mOptions.highUtilization;
+
+    // 有积压且所有线程都在忙  CPU仍有余量说明线程阻塞在I/O上  加线程
+    if (queued > 0 && status.activeTasks >= threads && !saturated)
+    {
+        mIdleSamples = 0;
+        size_t step = std::max<size_t>(threads / 4, 1);
+        return std::min(threads + step, mOptions.maxThreads);
+    }
+
+    // CPU已饱和且线程数超过可用CPU  多出的线程只增加切换开销
+    if (saturated && threads > mCpuLimit)
+    {
+        mIdleSamples = 0;
+        return std::max(threads - 1, std::max(mCpuLimit, mOptions.minThreads));
+    }
+
+    // 没有积压且有空闲线程  连续若干次后减一个
+    if (queued == 0 && status.activeTasks < threads)
+    {
+        if (++mIdleSamples >= mOptions.shrinkAfter)
+        {
+            mIdleSamples = 0;
+            return std::max(threads - 1, mOptions.minThreads);
+        }
+        return threads;
+    }
+
+    mIdleSamples = 0;
+    return threads;
+}
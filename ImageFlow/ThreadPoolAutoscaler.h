@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+//--------------------------
+#include "ThreadPool.hpp"
+
+namespace ImageFlow
+{
+
+/* 自动调整参数 */
+struct AutoscaleOptions
+{
+    size_t minThreads = 1;                    // 线程数下限
+    size_t maxThreads = 0;                    // 线程数上限 0表示CPU配额的2倍（留给阻塞在I/O上的线程）
+    std::chrono::milliseconds interval{500};  // 采样间隔
+    double highUtilization = 0.90;            // CPU利用率达到该值时视为饱和  不再扩容
+    int shrinkAfter = 4;                      // 连续空闲的采样次数达到该值时缩容
+};
+
+/* 线程池自动调整
+ * 定期采样积压（线程池队列与外部调度器的排队数之和）与进程CPU利用率
+ * 有积压且CPU未饱和（线程阻塞在I/O上）时扩容  持续空闲或CPU饱和且线程数超过配额时缩容
+ */
+class ThreadPoolAutoscaler
+{
+public:
+    /* 调整统计 */
+    struct Stats
+    {
+        size_t samples = 0;        // 采样次数
+        size_t grows = 0;          // 扩容次数
+        size_t shrinks = 0;        // 缩容次数
+        size_t threads = 0;        // 当前线程数
+        double utilization = 0.0;  // 最近一次采样的CPU利用率（相对于可用CPU数）
+    };
+
+private:
+    ThreadPool &mPool;
+    AutoscaleOptions mOptions;
+    std::function<size_t()> mBacklog;   // 线程池之外的排队数 可为空
+    size_t mCpuLimit;                   // 可用CPU数
+    mutable std::mutex mMutex;          // 保护mStop与mStats
+    std::condition_variable mCondition; // 停止通知
+    bool mStop = false;                 // 停止标志
+    int mIdleSamples = 0;               // 连续空闲的采样次数
+    Stats mStats;                       // 统计
+    std::thread mThread;                // 采样线程
+
+public:
+    // 任务经调度器限流送入线程池时  线程池队列几乎总为空  须由backlog提供调度器中的排队数
+    ThreadPoolAutoscaler(
+        ThreadPool &pool,
+        AutoscaleOptions const &options = {},
+        std::function<size_t()> backlog = {});
+    ~ThreadPoolAutoscaler();
+
+    ThreadPoolAutoscaler(ThreadPoolAutoscaler const &) = delete;
+    ThreadPoolAutoscaler &operator=(ThreadPoolAutoscaler const &) = delete;
+
+public:
+    void stop();
+
+    Stats getStats() const;
+
+private:
+    void run();
+
+    // 根据一次采样决定新的线程数
+    size_t decide(
+        size_t threads,
+        size_t queued,
+        ThreadPool::PoolStatus const &status,
+        double utilization);
+};
+
+} // namespace ImageFlow
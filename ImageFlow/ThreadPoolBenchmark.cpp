@@ -0,0 +1,411 @@
+#include "Benchmark.h"
+//--------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+//--------------------------
+#include "ThreadPool.hpp"
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* 一次运行的结果  按场景、策略与线程数区分  指标按加入顺序写出 */
+struct BenchRecord
+{
+    std::string scenario;
+    std::string policy; // 拒绝策略  与策略无关的场景为空
+    size_t producers = 0;
+    size_t consumers = 0;
+    std::vector<std::pair<char const *, double>> metrics;
+};
+
+double secondsSince(Clock::time_point begin)
+{
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+// 按分位取值  values为纳秒  结果为微秒
+double percentileUs(std::vector<int64_t> const &values, double p)
+{
+    std::vector<double> sorted(values.begin(), values.end());
+    std::sort(sorted.begin(), sorted.end());
+    return Utils::percentile(sorted, p) / 1e3;
+}
+
+// 最大值  values为纳秒  结果为微秒
+double maxUs(std::vector<int64_t> const &values)
+{
+    return values.empty() ? 0.0 : *std::max_element(values.begin(), values.end()) / 1e3;
+}
+
+// 忙等模拟计算任务  不让出CPU
+void spinFor(std::chrono::microseconds duration)
+{
+    auto end = Clock::now() + duration;
+    while (Clock::now() < end)
+    {
+    }
+}
+
+// 1、2、4……直到maxThreads  最后一项总是maxThreads
+std::vector<size_t> threadCounts(size_t maxThreads)
+{
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < maxThreads; n *= 2)
+        counts.push_back(n);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+// 启动producers个线程同时执行body(线程序号)  返回从放行到全部结束的秒数
+template <typename Body>
+double runProducers(size_t producers, Body &&body)
+{
+    std::atomic<bool> go = false;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < producers; ++i)
+    {
+        threads.emplace_back([&, i]
+                             {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            body(i); });
+    }
+    auto begin = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &thread : threads)
+        thread.join();
+    return secondsSince(begin);
+}
+
+// 空任务的提交吞吐量与执行完成吞吐量  队列足够大  不触发拒绝策略
+BenchRecord benchSubmitThroughput(size_t producers, size_t consumers, size_t tasks)
+{
+    size_t perProducer = std::max<size_t>(tasks / producers, 1);
+    ThreadPool pool(consumers, perProducer * producers + 1, RejectPolicy::BLOCK);
+
+    auto begin = Clock::now();
+    double submitSeconds = runProducers(producers, [&](size_t)
+                                        {
+        for (size_t i = 0; i < perProducer; ++i)
+            pool.submit([] {}); });
+    pool.waitAll();
+    double totalSeconds = secondsSince(begin);
+
+    double count = static_cast<double>(perProducer * producers);
+    return {"submit_throughput", "", producers, consumers,
+            {{"tasks", count},
+             {"submitPerSec", count / submitSeconds},
+             {"completePerSec", count / totalSeconds},
+             {"submitNsPerTask", submitSeconds * 1e9 / count * producers}}};
+}
+
+// 提交到开始执行的延迟  每个生产者提交后等待任务完成再提交下一个  生产者多于工作线程时包含排队
+BenchRecord benchSubmitToStart(size_t producers, size_t consumers, size_t samples)
+{
+    size_t perProducer = std::max<size_t>(samples / producers, 1);
+    ThreadPool pool(consumers, producers + 1, RejectPolicy::BLOCK);
+    std::vector<std::vector<int64_t>> latencies(producers, std::vector<int64_t>(perProducer));
+
+    runProducers(producers, [&](size_t producer)
+                 {
+        for (size_t i = 0; i < perProducer; ++i)
+        {
+            int64_t submitted = Utils::nowNanos();
+            auto &slot = latencies[producer][i];
+            pool.submit([&slot, submitted]
+                        { slot = Utils::nowNanos() - submitted; })
+                .get();
+        } });
+
+    std::vector<int64_t> all;
+    for (auto &&values : latencies)
+        all.insert(all.end(), values.begin(), values.end());
+    return {"submit_to_start", "", producers, consumers,
+            {{"samples", static_cast<double>(all.size())},
+             {"p50Us", percentileUs(all, 0.50)},
+             {"p99Us", percentileUs(all, 0.99)},
+             {"maxUs", maxUs(all)}}};
+}
+
+// waitAll在最后一个任务结束后多久返回  以及空闲时调用waitAll的开销
+BenchRecord benchWaitAll(size_t consumers, size_t rounds)
+{
+    size_t batch = consumers * 4;
+    ThreadPool pool(consumers, batch + 1, RejectPolicy::BLOCK);
+    std::atomic<int64_t> lastEnd = 0;
+    std::vector<int64_t> wakeups;
+    std::vector<int64_t> idleCalls;
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        lastEnd = 0;
+        for (size_t i = 0; i < batch; ++i)
+        {
+            pool.submit([&lastEnd]
+                        {
+                int64_t end = Utils::nowNanos();
+                int64_t prev = lastEnd.load();
+                while (prev < end && !lastEnd.compare_exchange_weak(prev, end))
+                {
+                } });
+        }
+        pool.waitAll();
+        wakeups.push_back(Utils::nowNanos() - lastEnd.load());
+
+        int64_t begin = Utils::nowNanos();
+        pool.waitAll();
+        idleCalls.push_back(Utils::nowNanos() - begin);
+    }
+    return {"wait_all", "", 1, consumers,
+            {{"rounds", static_cast<double>(rounds)},
+             {"batch", static_cast<double>(batch)},
+             {"wakeP50Us", percentileUs(wakeups, 0.50)},
+             {"wakeP99Us", percentileUs(wakeups, 0.99)},
+             {"idleP50Us", percentileUs(idleCalls, 0.50)}}};
+}
+
+char const *policyName(RejectPolicy policy)
+{
+    switch (policy)
+    {
+    case RejectPolicy::THROW:
+        return "THROW";
+    case RejectPolicy::BLOCK:
+        return "BLOCK";
+    case RejectPolicy::DISCARD:
+        return "DISCARD";
+    }
+    return "UNKNOWN";
+}
+
+// 过载时的拒绝策略  队列很小  任务忙等10微秒  生产者全速提交
+BenchRecord benchRejectPolicy(size_t producers, size_t consumers, RejectPolicy policy, size_t tasks)
+{
+    constexpr size_t kQueueSize = 64;
+    constexpr std::chrono::microseconds kWork{10};
+
+    size_t perProducer = std::max<size_t>(tasks / producers, 1);
+    ThreadPool pool(consumers, kQueueSize, policy);
+    std::atomic<size_t> thrown = 0;
+    std::vector<std::vector<int64_t>> submitNanos(producers);
+
+    auto begin = Clock::now();
+    double submitSeconds = runProducers(producers, [&](size_t producer)
+                                        {
+        auto &calls = submitNanos[producer];
+        calls.reserve(perProducer);
+        for (size_t i = 0; i < perProducer; ++i)
+        {
+            int64_t callBegin = Utils::nowNanos();
+            try
+            {
+                pool.submitWithName("bench", TaskPriority::NORMAL, std::chrono::milliseconds(0), [kWork]
+                                    { spinFor(kWork); });
+            }
+            catch (std::runtime_error const &)
+            {
+                ++thrown;
+            }
+            calls.push_back(Utils::nowNanos() - callBegin);
+        } });
+    pool.waitAll();
+    double totalSeconds = secondsSince(begin);
+
+    // 丢弃的任务按"名称_discarded"计数
+    auto stats = pool.getTaskStatistics();
+    double offered = static_cast<double>(perProducer * producers);
+    double completed = static_cast<double>(stats["bench"].completed);
+    double rejected = static_cast<double>(thrown.load() + stats["bench_discarded"].submitted);
+
+    std::vector<int64_t> calls;
+    for (auto &&values : submitNanos)
+        calls.insert(calls.end(), values.begin(), values.end());
+    return {"reject_policy", policyName(policy), producers, consumers,
+            {{"offered", offered},
+             {"completed", completed},
+             {"rejected", rejected},
+             {"completePerSec", completed / totalSeconds},
+             {"submitSeconds", submitSeconds},
+             {"submitP50Us", percentileUs(calls, 0.50)},
+             {"submitP99Us", percentileUs(calls, 0.99)},
+             {"submitMaxUs", maxUs(calls)}}};
+}
+
+// 在工作线程全部忙于LOW积压时提交任务  测量提交到开始的延迟
+int64_t probeStart(ThreadPool &pool, TaskPriority priority)
+{
+    int64_t submitted = Utils::nowNanos();
+    std::atomic<int64_t> started = 0;
+    pool.submitWithPriority(priority, std::chrono::milliseconds(0), [&started]
+                            { started = Utils::nowNanos(); })
+        .get();
+    return started.load() - submitted;
+}
+
+// 优先级与优先级反转
+// 抢占：HIGH任务只需等一个工作线程空出  LOW任务排在整个积压之后
+// 反转：HIGH任务依赖它提交的LOW子任务  子任务排在积压之后  HIGH任务随之被拖慢
+//       子任务以HIGH提交（相当于优先级继承）作为对照
+BenchRecord benchPriority(size_t consumers, size_t probes)
+{
+    constexpr std::chrono::microseconds kWork{50};
+    size_t backlog = consumers * 100; // 积压约 100 × 50 微秒 = 5 毫秒
+    ThreadPool pool(consumers, backlog + 16, RejectPolicy::BLOCK);
+
+    auto fillBacklog = [&]
+    {
+        for (size_t i = 0; i < backlog; ++i)
+        {
+            pool.submitWithPriority(TaskPriority::LOW, std::chrono::milliseconds(0), [kWork]
+                                    { spinFor(kWork); });
+        }
+    };
+
+    // 依赖子任务的HIGH任务从提交到完成的时间
+    auto probeDependent = [&](TaskPriority childPriority)
+    {
+        int64_t submitted = Utils::nowNanos();
+        pool.submitWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), [&pool, childPriority]
+                                { pool.submitWithPriority(childPriority, std::chrono::milliseconds(0), [] {}).get(); })
+            .get();
+        return Utils::nowNanos() - submitted;
+    };
+
+    std::vector<int64_t> highStart, lowStart, inverted, inherited;
+    for (size_t i = 0; i < probes; ++i)
+    {
+        fillBacklog();
+        highStart.push_back(probeStart(pool, TaskPriority::HIGH));
+        pool.waitAll();
+
+        fillBacklog();
+        lowStart.push_back(probeStart(pool, TaskPriority::LOW));
+        pool.waitAll();
+
+        fillBacklog();
+        inverted.push_back(probeDependent(TaskPriority::LOW));
+        pool.waitAll();
+
+        fillBacklog();
+        inherited.push_back(probeDependent(TaskPriority::HIGH));
+        pool.waitAll();
+    }
+    return {"priority", "", 1, consumers,
+            {{"backlog", static_cast<double>(backlog)},
+             {"highStartP50Us", percentileUs(highStart, 0.50)},
+             {"highStartMaxUs", maxUs(highStart)},
+             {"lowStartP50Us", percentileUs(lowStart, 0.50)},
+             {"invertedP50Us", percentileUs(inverted, 0.50)},
+             {"invertedMaxUs", maxUs(inverted)},
+             {"inheritedP50Us", percentileUs(inherited, 0.50)},
+             {"inheritedMaxUs", maxUs(inherited)}}};
+}
+
+void printRecord(BenchRecord const &record)
+{
+    std::printf("  %-18s %-8s P=%-3zu C=%-3zu", record.scenario.c_str(), record.policy.c_str(),
+                record.producers, record.consumers);
+    for (auto &&[name, value] : record.metrics)
+        std::printf("  %s=%.6g", name, value);
+    std::printf("\n");
+}
+
+// 字段顺序固定  不含时间戳  便于在不同提交之间比较
+bool writeJson(std::string const &path, size_t maxThreads, size_t tasks, std::vector<BenchRecord> const &records)
+{
+    FILE *file = Utils::openFile(path, "wb");
+    if (!file)
+    {
+        std::cerr << "无法创建结果文件：" << path << std::endl;
+        return false;
+    }
+    std::fprintf(file, "{\n  \"benchmark\": \"threadpool\",\n");
+    std::fprintf(file, "  \"hardwareThreads\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(file, "  \"maxThreads\": %zu,\n  \"tasks\": %zu,\n", maxThreads, tasks);
+#ifdef IMAGEFLOW_LOCK_STATS
+    std::fprintf(file, "  \"lockStats\": true,\n");
+#else
+    std::fprintf(file, "  \"lockStats\": false,\n");
+#endif
+    std::fprintf(file, "  \"results\": [");
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        auto const &record = records[i];
+        std::fprintf(file, "%s\n    {\"scenario\": \"%s\"", i ? "," : "", record.scenario.c_str());
+        if (!record.policy.empty())
+            std::fprintf(file, ", \"policy\": \"%s\"", record.policy.c_str());
+        std::fprintf(file, ", \"producers\": %zu, \"consumers\": %zu", record.producers, record.consumers);
+        for (auto &&[name, value] : record.metrics)
+            std::fprintf(file, ", \"%s\": %.10g", name, value);
+        std::fprintf(file, "}");
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+} // namespace
+
+int Benchmark::runThreadPool(size_t maxThreads, size_t tasks, std::string const &outputPath)
+{
+    maxThreads = std::max<size_t>(maxThreads, 1);
+    tasks = std::max<size_t>(tasks, 1000);
+    auto counts = threadCounts(maxThreads);
+
+    std::cout << "=== 线程池基准 ===" << std::endl;
+    std::cout << "  线程：1-" << maxThreads << "  任务：" << tasks << std::endl;
+
+    std::vector<BenchRecord> records;
+    auto add = [&](BenchRecord record)
+    {
+        printRecord(record);
+        records.push_back(std::move(record));
+    };
+
+    for (size_t producers : counts)
+    {
+        for (size_t consumers : counts)
+            add(benchSubmitThroughput(producers, consumers, tasks));
+    }
+    for (size_t producers : counts)
+    {
+        for (size_t consumers : counts)
+            add(benchSubmitToStart(producers, consumers, tasks / 20));
+    }
+    for (size_t consumers : counts)
+        add(benchWaitAll(consumers, 200));
+    for (auto policy : {RejectPolicy::BLOCK, RejectPolicy::THROW, RejectPolicy::DISCARD})
+    {
+        for (size_t producers : counts)
+        {
+            for (size_t consumers : counts)
+                add(benchRejectPolicy(producers, consumers, policy, tasks / 10));
+        }
+    }
+    // 反转场景中HIGH任务占住一个工作线程等待子任务  至少需要两个工作线程
+    for (size_t consumers : counts)
+    {
+        if (consumers >= 2)
+            add(benchPriority(consumers, 10));
+    }
+
+    std::cout << "=================================" << std::endl;
+    if (!writeJson(outputPath, maxThreads, tasks, records))
+        return 1;
+    std::cout << "结果已写入：" << outputPath << std::endl;
+    return 0;
+}
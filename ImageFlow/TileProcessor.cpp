@@ -0,0 +1,217 @@
+#include "TileProcessor.h"
+//--------------------------
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <numeric>
+#include <string>
+//--------------------------
+extern "C"
+{
+#include <libavutil/error.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+//--------------------------
+#include "FilterChainPlanner.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+// 单行像素的字节数（按两行平均  兼容色度垂直下采样格式）
+int64_t rowBytes(AVPixelFormat fmt, int width)
+{
+    int size = av_image_get_buffer_size(fmt, width, 2, 1);
+    return size > 0 ? size / 2 : 0;
+}
+
+/* 条带布局
+ * 源图每unitSrc行恰好缩放为输出的unitDst行  条带边界只落在单位边界上
+ */
+struct StripLayout
+{
+    int unitSrc = 0;       // 单位源行数
+    int unitDst = 0;       // 单位输出行数
+    int totalUnits = 0;    // 单位总数
+    int padUnits = 0;      // 上下重叠单位数
+    int unitsPerStrip = 0; // 每个条带的单位数（不含重叠）
+};
+
+bool computeLayout(AVFrame const *frame, TileOptions const &options, StripLayout &layout)
+{
+    auto srcFmt = static_cast<AVPixelFormat>(frame->format);
+    auto srcDesc = av_pix_fmt_desc_get(srcFmt);
+    auto dstDesc = av_pix_fmt_desc_get(options.outputFmt);
+    if (!srcDesc || !dstDesc || (srcDesc->flags & AV_PIX_FMT_FLAG_PAL))
+        return false;
+
+    int srcH = frame->height;
+    int dstH = options.targetHeight;
+    int g = std::gcd(srcH, dstH);
+    int unitSrc = srcH / g;
+    int unitDst = dstH / g;
+
+    // 条带起点必须落在色度行上
+    int alignSrc = 1 << srcDesc->log2_chroma_h;
+    int alignDst = 1 << dstDesc->log2_chroma_h;
+    int m = 1;
+    while ((unitSrc * m) % alignSrc || (unitDst * m) % alignDst)
+        ++m;
+    if (g % m)
+        return false;
+
+    layout.unitSrc = unitSrc * m;
+    layout.unitDst = unitDst * m;
+    layout.totalUnits = g / m;
+
+    // 重叠行需覆盖缩放核的支撑范围  缩小时支撑范围随比例放大
+    double ratio = static_cast<double>(srcH) / dstH;
+    int padRows = static_cast<int>(std::ceil(3.0 * std::max(ratio, 1.0)));
+    layout.padUnits = (padRows + layout.unitSrc - 1) / layout.unitSrc;
+
+    // 条带工作集：源视图行 + 缩放/滤镜/格式转换的中间输出
+    int64_t unitBytes = layout.unitSrc * rowBytes(srcFmt, frame->width) +
+                        3 * layout.unitDst * rowBytes(options.outputFmt, options.targetWidth);
+    if (unitBytes <= 0)
+        return false;
+    int64_t budgetUnits = static_cast<int64_t>(options.memoryBudget) / unitBytes - 2 * layout.padUnits;
+    layout.unitsPerStrip = static_cast<int>(std::max<int64_t>(budgetUnits, 1));
+
+    // 整图放得进预算时分条带没有意义
+    return layout.unitsPerStrip < layout.totalUnits;
+}
+
+// 构造源图第firstRow行起共rows行的零拷贝视图
+AVFrame *makeRowView(AVFrame const *frame, int firstRow, int rows)
+{
+    auto view = av_frame_alloc();
+    if (!view)
+        return nullptr;
+    if (av_frame_ref(view, frame) < 0)
+    {
+        av_frame_free(&view);
+        return nullptr;
+    }
+
+    auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    for (int plane = 0; plane < AV_NUM_DATA_POINTERS && view->data[plane]; ++plane)
+    {
+        bool isChroma = (plane == 1 || plane == 2) && desc->nb_components >= 3 &&
+                        !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        int offset = isChroma ? (firstRow >> desc->log2_chroma_h) : firstRow;
+        view->data[plane] += static_cast<ptrdiff_t>(offset) * view->linesize[plane];
+    }
+    view->height = rows;
+    return view;
+}
+
+// 将条带输出的[srcRow, srcRow + rows)行复制到目标帧的dstRow行起
+void copyRows(AVFrame *dst, int dstRow, AVFrame const *src, int srcRow, int rows)
+{
+    auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(dst->format));
+    for (int plane = 0; plane < AV_NUM_DATA_POINTERS && dst->data[plane]; ++plane)
+    {
+        bool isChroma = (plane == 1 || plane == 2) && desc->nb_components >= 3 &&
+                        !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        int shift = isChroma ? desc->log2_chroma_h : 0;
+        int lineBytes = av_image_get_linesize(static_cast<AVPixelFormat>(dst->format), dst->width, plane);
+        av_image_copy_plane(
+            dst->data[plane] + static_cast<ptrdiff_t>(dstRow >> shift) * dst->linesize[plane],
+            dst->linesize[plane],
+            src->data[plane] + static_cast<ptrdiff_t>(srcRow >> shift) * src->linesize[plane],
+            src->linesize[plane],
+            lineBytes, rows >> shift);
+    }
+}
+
+} // namespace
+
+//----------------------------------------------------------------
+
+TileProcessor::TileProcessor(FilterGraphPool &pool)
+    : mFilterGraphPool(pool) {}
+
+bool TileProcessor::canTile(
+    AVFrame const *frame,
+    std::string const &filterDesc,
+    TileOptions const &options)
+{
+    if (!frame || options.targetWidth <= 0 || options.targetHeight <= 0 ||
+        options.outputFmt == AV_PIX_FMT_NONE)
+        return false;
+    if (!FilterChainPlanner::isPerPixelChain(filterDesc))
+        return false;
+
+    StripLayout layout;
+    return computeLayout(frame, options, layout);
+}
+
+int TileProcessor::process(
+    AVFrame *inputFrame,
+    std::string const &filterDesc,
+    TileOptions const &options,
+    AVFrame **outputFrame)
+{
+    StripLayout layout;
+    if (!inputFrame || !computeLayout(inputFrame, options, layout))
+        return AVERROR(EINVAL);
+
+    auto output = av_frame_alloc();
+    if (!output)
+        return AVERROR(ENOMEM);
+    output->format = options.outputFmt;
+    output->width = options.targetWidth;
+    output->height = options.targetHeight;
+    if (av_frame_get_buffer(output, 0) < 0)
+    {
+        av_frame_free(&output);
+        return AVERROR(ENOMEM);
+    }
+    av_frame_copy_props(output, inputFrame);
+
+    std::string format = ",format=";
+    format += av_get_pix_fmt_name(options.outputFmt);
+
+    for (int first = 0; first < layout.totalUnits; first += layout.unitsPerStrip)
+    {
+        int last = std::min(first + layout.unitsPerStrip, layout.totalUnits);
+        int padFirst = std::max(first - layout.padUnits, 0);
+        int padLast = std::min(last + layout.padUnits, layout.totalUnits);
+
+        auto view = makeRowView(inputFrame,
+                                padFirst * layout.unitSrc,
+                                (padLast - padFirst) * layout.unitSrc);
+        if (!view)
+        {
+            av_frame_free(&output);
+            return AVERROR(ENOMEM);
+        }
+
+        // 同尺寸的条带共享同一个缓存滤镜图  条带与整图缩放比例相同  规划结论一致
+        auto plan = FilterChainPlanner::plan(
+            filterDesc,
+            view->width, view->height,
+            options.targetWidth, (padLast - padFirst) * layout.unitDst);
+        std::string desc = plan.filterDesc + format;
+
+        AVFrame *stripFrame = nullptr;
+        int ret = mFilterGraphPool.processFrame(view, desc, &stripFrame, options.graphOptions);
+        av_frame_free(&view);
+        if (ret < 0 || !stripFrame)
+        {
+            av_frame_free(&output);
+            return ret < 0 ? ret : AVERROR(EINVAL);
+        }
+
+        copyRows(output, first * layout.unitDst,
+                 stripFrame, (first - padFirst) * layout.unitDst,
+                 (last - first) * layout.unitDst);
+        av_frame_free(&stripFrame);
+    }
+
+    *outputFrame = output;
+    return 0;
+}
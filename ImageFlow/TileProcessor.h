@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+//--------------------------
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+//--------------------------
+#include "FilterGraphPool.h"
+
+namespace ImageFlow
+{
+
+/* 条带处理参数 */
+struct TileOptions
+{
+    int targetWidth = 0;                       // 输出宽度
+    int targetHeight = 0;                      // 输出高度
+    size_t memoryBudget = 64 << 20;            // 单个条带的工作内存预算（字节）
+    AVPixelFormat outputFmt = AV_PIX_FMT_NONE; // 输出像素格式 与编码器一致以免再做整帧转换
+    FilterGraphOptions graphOptions;           // 条带滤镜图选项
+};
+
+/* 条带处理器
+ * 将大图按整行宽度的水平条带切分  条带为原图的零拷贝视图
+ * 每个条带带上足够的重叠行送入滤镜图缩放  裁掉重叠部分后写入输出帧
+ * 条带边界按缩放比例对齐到整数行  拼接处不会产生错位
+ */
+class TileProcessor
+{
+private:
+    FilterGraphPool &mFilterGraphPool;
+
+public:
+    explicit TileProcessor(FilterGraphPool &pool);
+
+public:
+    // 判断图像与滤镜链能否分条带处理
+    static bool canTile(
+        AVFrame const *frame,
+        std::string const &filterDesc,
+        TileOptions const &options);
+
+    // 分条带处理  filterDesc为不含缩放的逐像素滤镜链
+    int process(
+        AVFrame *inputFrame,
+        std::string const &filterDesc,
+        TileOptions const &options,
+        AVFrame **outputFrame);
+};
+
+} // namespace ImageFlow
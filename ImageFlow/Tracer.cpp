@@ -0,0 +1,265 @@
+#include "Tracer.h"
+//--------------------------
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <iostream>
+//--------------------------
+#include "Utils.h"
+
+using namespace ImageFlow;
+
+namespace
+{
+
+// 当前线程正在处理的图像
+struct CurrentImage
+{
+    uint64_t id = 0;
+    int width = 0;
+    int height = 0;
+};
+
+thread_local CurrentImage tCurrentImage;
+
+int64_t nanosBetween(Tracer::Clock::time_point begin, Tracer::Clock::time_point end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+int64_t toNanos(Tracer::Clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+Tracer &Tracer::getInstance()
+{
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::start(size_t eventsPerThread)
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    if (mUsers++ > 0)
+        return;
+
+    // 测量一次记录的主要开销（两次读时钟）  用于估算总开销
+    constexpr int kSamples = 1000;
+    auto calibrateBegin = Clock::now();
+    for (int i = 0; i < kSamples; ++i)
+        (void)Clock::now();
+    double clockNs = static_cast<double>(nanosBetween(calibrateBegin, Clock::now())) / kSamples;
+
+    mBuffers.clear();
+    mEventsPerThread = std::max<size_t>(eventsPerThread, 1);
+    mEventCostNs = clockNs * 2;
+    mOriginNs = toNanos(Clock::now());
+    ++mGeneration;
+    mEnabled = true;
+}
+
+void Tracer::stop()
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    if (mUsers > 0 && --mUsers == 0)
+        mEnabled = false;
+}
+
+void Tracer::record(char const *name, Clock::time_point begin, Clock::time_point end)
+{
+    if (!isEnabled())
+        return;
+    TraceEvent event;
+    event.name = name;
+    event.beginNs = toNanos(begin) - mOriginNs.load(std::memory_order_relaxed);
+    event.durationNs = nanosBetween(begin, end);
+    TraceContext::current(event.imageId, event.width, event.height);
+    append(event);
+}
+
+void Tracer::record(char const *name, Clock::time_point begin)
+{
+    if (isEnabled())
+        record(name, begin, Clock::now());
+}
+
+void Tracer::recordAsync(char const *name, uint64_t imageId, Clock::time_point begin, Clock::time_point end)
+{
+    if (!isEnabled())
+        return;
+    TraceEvent event;
+    event.name = name;
+    event.beginNs = toNanos(begin) - mOriginNs.load(std::memory_order_relaxed);
+    event.durationNs = nanosBetween(begin, end);
+    event.imageId = imageId;
+    event.async = true;
+    append(event);
+}
+
+void Tracer::setThreadName(char const *name)
+{
+    if (!isEnabled())
+        return;
+    if (auto buffer = threadBuffer())
+        buffer->name.store(name, std::memory_order_relaxed);
+}
+
+void Tracer::append(TraceEvent const &event)
+{
+    if (!isEnabled())
+        return;
+    auto buffer = threadBuffer();
+    size_t count = buffer->count.load(std::memory_order_relaxed);
+    if (count >= buffer->capacity)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto &chunk = buffer->chunks[count / kChunkEvents];
+    if (!chunk)
+        chunk = std::make_unique<TraceEvent[]>(kChunkEvents);
+    chunk[count % kChunkEvents] = event;
+    buffer->count.store(count + 1, std::memory_order_release); // 写出时只读取已发布的事件
+}
+
+Tracer::ThreadBuffer *Tracer::threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    uint64_t generation = mGeneration.load(std::memory_order_acquire);
+    if (buffer && buffer->generation == generation)
+        return buffer.get();
+
+    // 新一轮追踪或首次记录  沿用线程名称
+    auto fresh = std::make_shared<ThreadBuffer>();
+    fresh->generation = generation;
+    if (buffer)
+        fresh->name.store(buffer->name.load());
+    std::lock_guard<std::mutex> _(mMutex);
+    fresh->capacity = mEventsPerThread;
+    fresh->chunks.resize((mEventsPerThread + kChunkEvents - 1) / kChunkEvents);
+    fresh->tid = static_cast<uint32_t>(mBuffers.size() + 1);
+    mBuffers.push_back(fresh);
+    buffer = std::move(fresh);
+    return buffer.get();
+}
+
+bool Tracer::write(std::string const &path) const
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        buffers = mBuffers;
+    }
+
+    FILE *file = Utils::openFile(path, "wb");
+    if (!file)
+    {
+        std::cerr << "无法创建追踪文件：" << path << std::endl;
+        return false;
+    }
+
+    // 时间单位为微秒  区间为完整事件（X）  跨线程的区间为异步事件（b/e）
+    bool first = true;
+    auto emit = [&](std::string const &line)
+    {
+        fputs(first ? "\n" : ",\n", file);
+        fputs(line.c_str(), file);
+        first = false;
+    };
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    emit(R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"ImageFlow"}})");
+    for (auto &&buffer : buffers)
+    {
+        auto name = buffer->name.load();
+        emit(std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{} {}"}}}})",
+                         buffer->tid, name ? name : "thread", buffer->tid));
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const &event = buffer->chunks[i / kChunkEvents][i % kChunkEvents];
+            double ts = event.beginNs / 1e3;
+            std::string args;
+            if (event.imageId)
+            {
+                args = std::format(R"(,"args":{{"image":{},"width":{},"height":{}}})",
+                                   event.imageId, event.width, event.height);
+            }
+            if (!event.async)
+            {
+                emit(std::format(R"({{"name":"{}","cat":"imageflow","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":1,"tid":{}{}}})",
+                                 event.name, ts, event.durationNs / 1e3, buffer->tid, args));
+            }
+            else
+            {
+                emit(std::format(R"({{"name":"{}","cat":"imageflow","ph":"b","id":{},"ts":{:.3f},"pid":1,"tid":{}{}}})",
+                                 event.name, event.imageId, ts, buffer->tid, args));
+                emit(std::format(R"({{"name":"{}","cat":"imageflow","ph":"e","id":{},"ts":{:.3f},"pid":1,"tid":{}}})",
+                                 event.name, event.imageId, ts + event.durationNs / 1e3, buffer->tid));
+            }
+        }
+    }
+    fputs("\n]}\n", file);
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+Tracer::Stats Tracer::getStats() const
+{
+    std::lock_guard<std::mutex> _(mMutex);
+    Stats stats;
+    stats.threads = mBuffers.size();
+    for (auto &&buffer : mBuffers)
+    {
+        stats.events += buffer->count.load(std::memory_order_relaxed);
+        stats.dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    stats.overheadSeconds = (stats.events + stats.dropped) * mEventCostNs / 1e9;
+    return stats;
+}
+
+//----------------------------------------------------------------
+
+TraceContext::TraceContext(uint64_t imageId, int width, int height)
+    : mPrevId(tCurrentImage.id), mPrevWidth(tCurrentImage.width), mPrevHeight(tCurrentImage.height)
+{
+    tCurrentImage = {imageId, width, height};
+}
+
+TraceContext::~TraceContext()
+{
+    tCurrentImage = {mPrevId, mPrevWidth, mPrevHeight};
+}
+
+void TraceContext::setSize(int width, int height)
+{
+    tCurrentImage.width = width;
+    tCurrentImage.height = height;
+}
+
+void TraceContext::current(uint64_t &imageId, int &width, int &height)
+{
+    imageId = tCurrentImage.id;
+    width = tCurrentImage.width;
+    height = tCurrentImage.height;
+}
+
+//----------------------------------------------------------------
+
+TraceScope::TraceScope(char const *name)
+    : mName(name), mActive(Tracer::getInstance().isEnabled())
+{
+    if (mActive)
+        mBegin = Tracer::Clock::now();
+}
+
+TraceScope::~TraceScope()
+{
+    if (mActive)
+        Tracer::getInstance().record(mName, mBegin, Tracer::Clock::now());
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ImageFlow
+{
+
+/* 追踪事件 */
+struct TraceEvent
+{
+    char const *name = nullptr; // 区间名称  须为字符串字面量
+    int64_t beginNs = 0;        // 相对追踪开始的时间
+    int64_t durationNs = 0;     // 持续时间
+    uint64_t imageId = 0;       // 图像编号 0表示不属于某张图像
+    int width = 0;              // 图像宽度 0表示未知
+    int height = 0;             // 图像高度
+    bool async = false;         // 跨线程的区间（排队、异步写出）  按图像编号单独成轨
+};
+
+/* 时间线追踪
+ * 记录各线程的处理区间  写出为Chrome trace-event JSON  可在Perfetto或chrome://tracing中打开
+ * 每个线程一块缓冲  记录时不加锁  按块分配  写满容量后丢弃并计数  开销与内存都有上限
+ * 关闭时每个区间只多读一次原子变量
+ */
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats
+    {
+        size_t events = 0;            // 已记录的事件数
+        size_t dropped = 0;           // 缓冲写满后丢弃的事件数
+        size_t threads = 0;           // 记录过事件的线程数
+        double overheadSeconds = 0.0; // 按启动时测得的单次开销估算的记录总耗时
+    };
+
+private:
+    static constexpr size_t kChunkEvents = 4096; // 每块的事件数  缓冲按块增长  已写入的事件不移动
+
+    /* 单个线程的事件缓冲  只由所属线程写入 */
+    struct ThreadBuffer
+    {
+        uint32_t tid = 0;                                  // 在追踪文件中的线程编号
+        uint64_t generation = 0;                           // 所属的追踪轮次
+        size_t capacity = 0;                               // 事件上限
+        std::atomic<char const *> name = nullptr;          // 线程名称
+        std::vector<std::unique_ptr<TraceEvent[]>> chunks; // 预留全部块的位置  用到时才分配
+        std::atomic<size_t> count = 0;                     // 已写入的事件数
+        std::atomic<size_t> dropped = 0;                   // 丢弃的事件数
+    };
+
+    std::atomic<bool> mEnabled = false;
+    std::atomic<uint64_t> mGeneration = 0; // 每次start加一  线程发现变化后换用新缓冲
+    std::atomic<int64_t> mOriginNs = 0;    // 时间零点（steady_clock纳秒）
+
+    mutable std::mutex mMutex;                           // 保护以下状态
+    size_t mUsers = 0;                                   // 未配对stop的start次数
+    std::vector<std::shared_ptr<ThreadBuffer>> mBuffers; // 本轮各线程的缓冲
+    size_t mEventsPerThread = 0;                         // 每个线程的事件上限
+    double mEventCostNs = 0.0;                           // 单次记录的开销（纳秒）
+
+private:
+    Tracer() = default;
+
+public:
+    Tracer(Tracer const &) = delete;
+    Tracer &operator=(Tracer const &) = delete;
+
+public:
+    static Tracer &getInstance();
+
+    // 开始记录  start与stop成对调用且可嵌套  多个处理器共用同一轮记录
+    // 只有最外层的start开始新一轮并丢弃之前的事件  eventsPerThread为每个线程的事件上限
+    void start(size_t eventsPerThread = 1 << 16);
+
+    // 最后一个stop停止记录  已记录的事件仍可写出
+    void stop();
+
+    bool isEnabled() const
+    {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    // 记录当前线程上的区间  图像编号与尺寸取当前线程的TraceContext
+    void record(char const *name, Clock::time_point begin, Clock::time_point end);
+
+    // 记录从begin到现在的区间  复用调用者已有的阶段计时  关闭时不读时钟
+    void record(char const *name, Clock::time_point begin);
+
+    // 记录跨线程的区间
+    void recordAsync(char const *name, uint64_t imageId, Clock::time_point begin, Clock::time_point end);
+
+    // 当前线程在追踪文件中显示的名称  须为字符串字面量
+    void setThreadName(char const *name);
+
+    // 写出已记录的事件  可在记录过程中调用
+    bool write(std::string const &path) const;
+
+    Stats getStats() const;
+
+private:
+    void append(TraceEvent const &event);
+
+    // 当前线程本轮的缓冲  首次调用时注册
+    ThreadBuffer *threadBuffer();
+};
+
+/* 当前线程正在处理的图像  期间记录的区间都带上其编号与尺寸  可嵌套 */
+class TraceContext
+{
+private:
+    uint64_t mPrevId;
+    int mPrevWidth;
+    int mPrevHeight;
+
+public:
+    explicit TraceContext(uint64_t imageId, int width = 0, int height = 0);
+    ~TraceContext();
+
+    TraceContext(TraceContext const &) = delete;
+    TraceContext &operator=(TraceContext const &) = delete;
+
+public:
+    // 解码后才知道的图像尺寸
+    void setSize(int width, int height);
+
+    // 当前线程的图像信息（Tracer使用）
+    static void current(uint64_t &imageId, int &width, int &height);
+};
+
+/* 区间  构造时开始  析构时记录  追踪关闭时不读时钟 */
+class TraceScope
+{
+private:
+    char const *mName;
+    Tracer::Clock::time_point mBegin;
+    bool mActive;
+
+public:
+    explicit TraceScope(char const *name);
+    ~TraceScope();
+
+    TraceScope(TraceScope const &) = delete;
+    TraceScope &operator=(TraceScope const &) = delete;
+};
+
+} // namespace ImageFlow
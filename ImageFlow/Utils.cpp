@@ -1,17 +1,23 @@
 #include "Utils.h"
 //------------------
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 
 using namespace ImageFlow;
 
 #ifdef _WIN32
 #include <windows.h>
 /**
- * @brief WindowsϽַӱرתΪUTF-8
- * @param [in] str رַ
- * @return UTF-8תַ
+ * @brief 在Windows上将字符串从本地编码转换为UTF-8。
+ * @param [in] str 本地编码的输入字符串
+ * @return UTF-8编码的转换字符串。
  */
 std::string Utils::localToUtf8(std::string const &str)
 {
@@ -36,18 +42,480 @@ std::string Utils::localToUtf8(std::string const &str)
     }
     catch (std::exception const &ec)
     {
-        std::cerr << "޷ַӱرתΪUTF-8" << ec.what() << std::endl;
+        std::cerr << "无法将字符串从本地编码转换为UTF-8：" << ec.what() << std::endl;
         return {};
     }
 }
 #else
 /**
- * @brief ڷWindowsƽ̨ϣǼ豾رUTF-8
- * @param [in] str رַ
- * @return ַٶUTF-8롣
+ * @brief 在非Windows平台上，我们假设本地编码是UTF-8。
+ * @param [in] str 本地编码的输入字符串
+ * @return 输入字符串，假定采用UTF-8编码。
  */
 std::string Utils::localToUtf8(std::string const &str)
 {
     return str;
 }
 #endif
+
+FILE *Utils::openFile(std::string const &path, char const *mode)
+{
+    FILE *file = nullptr;
+#if defined(_WIN32)
+    std::wstring wpath = std::filesystem::path{path}.wstring();
+    std::wstring wmode(mode, mode + strlen(mode));
+    if (_wfopen_s(&file, wpath.c_str(), wmode.c_str()) != 0)
+        file = nullptr;
+#else
+    file = fopen(path.c_str(), mode);
+#endif
+    return file;
+}
+
+bool Utils::writeFile(std::string const &path, uint8_t const *data, size_t size)
+{
+    // 打开输出文件
+    std::filesystem::path outPath{path};
+    FILE *outputFile = nullptr;
+#if defined(_WIN32)
+    // 使用宽字符路径打开文件，支持 Unicode 路径
+    std::wstring wpath = outPath.wstring();
+    if (_wfopen_s(&outputFile, wpath.c_str(), L"wb") != 0)
+        outputFile = nullptr;
+#else
+    std::string outPathStr = outPath.string();
+    outputFile = fopen(outPathStr.c_str(), "wb");
+#endif
+
+    if (!outputFile)
+    {
+        std::cerr << "无法打开输出文件：" << outPath << std::endl;
+        return false;
+    }
+
+    bool ok = fwrite(data, 1, size, outputFile) == size;
+    fclose(outputFile);
+    return ok;
+}
+
+bool Utils::readFile(std::string const &path, std::vector<uint8_t> &data)
+{
+    std::filesystem::path inPath{path};
+    FILE *inputFile = nullptr;
+#if defined(_WIN32)
+    std::wstring wpath = inPath.wstring();
+    if (_wfopen_s(&inputFile, wpath.c_str(), L"rb") != 0)
+        inputFile = nullptr;
+#else
+    std::string inPathStr = inPath.string();
+    inputFile = fopen(inPathStr.c_str(), "rb");
+#endif
+
+    if (!inputFile)
+    {
+        std::cerr << "无法打开输入文件：" << inPath << std::endl;
+        return false;
+    }
+
+    data.clear();
+    uint8_t buffer[64 * 1024];
+    size_t n = 0;
+    while ((n = fread(buffer, 1, sizeof(buffer), inputFile)) > 0)
+        data.insert(data.end(), buffer, buffer + n);
+    bool ok = !ferror(inputFile);
+    fclose(inputFile);
+    return ok;
+}
+
+bool Utils::readFileHead(std::string const &path, size_t maxBytes, std::vector<uint8_t> &data)
+{
+    FILE *file = openFile(path, "rb");
+    if (!file)
+        return false;
+
+    data.resize(maxBytes);
+    size_t n = fread(data.data(), 1, maxBytes, file);
+    bool ok = !ferror(file);
+    fclose(file);
+    data.resize(n);
+    return ok;
+}
+
+bool Utils::touchFile(std::string const &path)
+{
+    std::ifstream file(std::filesystem::path{path}, std::ios::binary);
+    if (!file)
+        return false;
+
+    // 每个线程复用一块缓冲
+    thread_local std::vector<char> buffer(1 << 20);
+    while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())))
+    {
+    }
+    return !file.bad();
+}
+
+int64_t Utils::nowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t Utils::microsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+std::string_view Utils::trim(std::string_view s)
+{
+    while (!s.empty() && s.front() == ' ')
+        s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ')
+        s.remove_suffix(1);
+    return s;
+}
+
+double Utils::percentile(std::vector<double> const &values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    auto idx = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(idx, values.size() - 1)];
+}
+
+#ifdef _WIN32
+bool Utils::adviseWillNeed(std::string const &)
+{
+    // 没有不映射文件的异步预读提示  由调用者改用touchFile
+    return false;
+}
+
+int Utils::isFileResident(std::string const &)
+{
+    return -1;
+}
+
+bool Utils::syncFile(std::string const &path)
+{
+    std::wstring wpath = std::filesystem::path{path}.wstring();
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ok;
+}
+
+bool Utils::syncDirectory(std::string const &)
+{
+    // NTFS的元数据由日志保证  改名在FlushFileBuffers之后即持久
+    return true;
+}
+
+bool Utils::startWriteback(std::string const &)
+{
+    return false;
+}
+
+bool Utils::copyFile(std::string const &srcPath, std::string const &dstPath)
+{
+    // 支持块克隆的卷（ReFS）上CopyFile只复制引用
+    std::wstring src = std::filesystem::path{srcPath}.wstring();
+    std::wstring dst = std::filesystem::path{dstPath}.wstring();
+    if (!CopyFileW(src.c_str(), dst.c_str(), FALSE))
+    {
+        std::cerr << "无法复制文件：" << srcPath << " -> " << dstPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int64_t Utils::memoryLimitBytes()
+{
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    if (!GlobalMemoryStatusEx(&status))
+        return 0;
+    return static_cast<int64_t>(status.ullTotalPhys);
+}
+
+size_t Utils::cpuLimit()
+{
+    // 进程亲和性掩码中的CPU数  作业对象的CPU速率限制不在此列
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    size_t count = std::thread::hardware_concurrency();
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) && processMask)
+    {
+        size_t affinity = 0;
+        for (; processMask; processMask &= processMask - 1)
+            ++affinity;
+        count = count > 0 ? std::min(count, affinity) : affinity;
+    }
+    return std::max<size_t>(count, 1);
+}
+
+double Utils::processCpuSeconds()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    auto toSeconds = [](FILETIME const &t)
+    {
+        return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 1e7;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+}
+#else
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/fs.h>
+#endif
+
+bool Utils::adviseWillNeed(std::string const &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    // 只把读请求排入队列  不等待读完
+    int ret = posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+    return ret == 0;
+}
+
+bool Utils::syncFile(std::string const &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+#if defined(__linux__)
+    bool ok = fdatasync(fd) == 0;
+#else
+    bool ok = fsync(fd) == 0;
+#endif
+    close(fd);
+    return ok;
+}
+
+bool Utils::syncDirectory(std::string const &path)
+{
+    int fd = open(path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+bool Utils::startWriteback(std::string const &path)
+{
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    bool ok = sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE) == 0;
+    close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool Utils::copyFile(std::string const &srcPath, std::string const &dstPath)
+{
+    int src = open(srcPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (src < 0)
+    {
+        std::cerr << "无法打开输入文件：" << srcPath << std::endl;
+        return false;
+    }
+    struct stat st{};
+    int dst = fstat(src, &st) == 0 ? open(dstPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    if (dst < 0)
+    {
+        std::cerr << "无法创建输出文件：" << dstPath << std::endl;
+        close(src);
+        return false;
+    }
+
+    bool ok = false;
+#if defined(__linux__)
+    // 先尝试reflink（Btrfs、XFS）只共享数据块  再用copy_file_range在内核中复制  都不支持时读写复制
+    ok = ioctl(dst, FICLONE, src) == 0;
+    off_t copied = 0;
+    while (!ok && copied < st.st_size)
+    {
+        ssize_t n = copy_file_range(src, nullptr, dst, nullptr, static_cast<size_t>(st.st_size - copied), 0);
+        if (n <= 0)
+            break;
+        copied += n;
+        ok = copied >= st.st_size;
+    }
+    if (!ok && copied == 0)
+        ok = st.st_size == 0;
+#else
+    off_t copied = 0;
+#endif
+    if (!ok && lseek(src, copied, SEEK_SET) == copied)
+    {
+        char buffer[64 * 1024];
+        ssize_t n = 0;
+        while ((n = read(src, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t done = 0; n > 0 && done < n;)
+            {
+                ssize_t m = write(dst, buffer + done, static_cast<size_t>(n - done));
+                if (m <= 0)
+                {
+                    n = -1;
+                    break;
+                }
+                done += m;
+            }
+        }
+        ok = n == 0;
+    }
+    close(src);
+    if (close(dst) != 0)
+        ok = false;
+    if (!ok)
+        std::cerr << "无法复制文件：" << srcPath << " -> " << dstPath << std::endl;
+    return ok;
+}
+
+int Utils::isFileResident(std::string const &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0)
+    {
+        close(fd);
+        return 1;
+    }
+
+    // 映射后用mincore查询各页是否驻留  不会触发读取
+    size_t size = static_cast<size_t>(st.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return -1;
+
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    std::vector<unsigned char> pages((size + pageSize - 1) / pageSize);
+    int resident = -1;
+    if (mincore(addr, size, pages.data()) == 0)
+    {
+        resident = std::all_of(pages.begin(), pages.end(), [](unsigned char page)
+                               { return (page & 1) != 0; })
+                       ? 1
+                       : 0;
+    }
+    munmap(addr, size);
+    return resident;
+}
+
+int64_t Utils::memoryLimitBytes()
+{
+    int64_t limit = 0;
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && pageSize > 0)
+        limit = static_cast<int64_t>(pages) * pageSize;
+
+    // cgroup v2 为 memory.max（无限制时为"max"）  v1 为 memory.limit_in_bytes
+    for (auto path : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"})
+    {
+        std::ifstream file(path);
+        std::string value;
+        if (!(file >> value) || value == "max")
+            continue;
+        try
+        {
+            int64_t cgroupLimit = std::stoll(value);
+            if (cgroupLimit > 0)
+                limit = limit > 0 ? std::min(limit, cgroupLimit) : cgroupLimit;
+        }
+        catch (std::exception const &)
+        {
+        }
+        break;
+    }
+    return limit;
+}
+
+size_t Utils::cpuLimit()
+{
+    size_t count = std::thread::hardware_concurrency();
+
+    // 亲和性（taskset、cpuset）限制了可用的CPU
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        size_t affinity = static_cast<size_t>(CPU_COUNT(&set));
+        if (affinity > 0)
+            count = count > 0 ? std::min(count, affinity) : affinity;
+    }
+
+    // CFS配额  cgroup v2 为 cpu.max（"配额 周期"  无限制时配额为"max"）
+    // v1 为 cpu.cfs_quota_us（无限制时为-1）与 cpu.cfs_period_us
+    // 向下取整  线程数超过配额时会被CFS限流
+    double quota = 0.0;
+    {
+        std::ifstream file("/sys/fs/cgroup/cpu.max");
+        std::string max, period;
+        if (file >> max >> period && max != "max")
+        {
+            try
+            {
+                quota = std::stod(max) / std::stod(period);
+            }
+            catch (std::exception const &)
+            {
+            }
+        }
+    }
+    if (quota <= 0.0)
+    {
+        std::ifstream quotaFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream periodFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        double quotaUs = 0.0, periodUs = 0.0;
+        if (quotaFile >> quotaUs && periodFile >> periodUs && quotaUs > 0 && periodUs > 0)
+            quota = quotaUs / periodUs;
+    }
+    if (quota > 0.0)
+    {
+        size_t byQuota = std::max<size_t>(static_cast<size_t>(quota), 1);
+        count = count > 0 ? std::min(count, byQuota) : byQuota;
+    }
+    return std::max<size_t>(count, 1);
+}
+
+double Utils::processCpuSeconds()
+{
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+    auto toSeconds = [](timeval const &t)
+    {
+        return t.tv_sec + t.tv_usec / 1e6;
+    };
+    return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+}
+#endif
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <cstddef>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 namespace ImageFlow
 {
@@ -9,5 +17,68 @@ namespace Utils
 
 std::string localToUtf8(std::string const &str);
 
+// 打开文件  mode同fopen  Windows上支持Unicode路径  失败时返回nullptr
+FILE *openFile(std::string const &path, char const *mode);
+
+// 将数据写入文件（覆盖已有文件）
+bool writeFile(std::string const &path, uint8_t const *data, size_t size);
+
+// 读取整个文件
+bool readFile(std::string const &path, std::vector<uint8_t> &data);
+
+// 读取文件开头最多maxBytes字节  文件较短时读完为止
+bool readFileHead(std::string const &path, size_t maxBytes, std::vector<uint8_t> &data);
+
+// 顺序读完文件并丢弃数据  只为把文件带入系统缓存
+bool touchFile(std::string const &path);
+
+// 提示内核异步预读整个文件到页缓存  平台不支持时返回false
+bool adviseWillNeed(std::string const &path);
+
+// 文件内容是否全部在页缓存中  1是 0否 -1无法判断
+int isFileResident(std::string const &path);
+
+// 把文件内容刷到存储设备  Linux用fdatasync  只刷读回内容所需的元数据（长度等）  不刷访问时间
+bool syncFile(std::string const &path);
+
+// 把目录项刷到存储设备  使文件的创建与改名落盘  不需要时（Windows）直接返回true
+bool syncDirectory(std::string const &path);
+
+// 开始把文件的脏页写回存储设备但不等待（Linux sync_file_range）  之后的syncFile只需等待  平台不支持时返回false
+bool startWriteback(std::string const &path);
+
+// 复制整个文件（覆盖已有文件）  文件系统支持时共享数据块（reflink、块克隆）  否则在内核中复制
+bool copyFile(std::string const &srcPath, std::string const &dstPath);
+
+// 进程可用的内存上限（字节）  Linux取cgroup限制与物理内存的较小值  无法获取时返回0
+int64_t memoryLimitBytes();
+
+// 进程可用的CPU数  Linux取cgroup CPU配额（向下取整）、亲和性与硬件线程数的最小值  至少为1
+size_t cpuLimit();
+
+// 进程累计占用的CPU时间（用户态+内核态  秒）
+double processCpuSeconds();
+
+// steady_clock的当前时间（纳秒）
+int64_t nowNanos();
+
+// 从begin到现在经过的微秒数
+int64_t microsSince(std::chrono::steady_clock::time_point begin);
+
+// 去掉首尾空格
+std::string_view trim(std::string_view s);
+
+// 解析整个字符串为数值  有多余字符、超出范围或不是数字时返回false  不抛出异常
+template <typename T>
+bool parseNumber(std::string_view text, T &value)
+{
+    auto end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+// 按分位取值（最近秩）  values须已排序  为空时返回0
+double percentile(std::vector<double> const &values, double p);
+
 }
 } // namespace ImageFlow
@@ -1,10 +1,22 @@
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <string>
 #include <vector>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
+#include "Benchmark.h"
 #include "ImageFlowProcessor.h"
+#include "JobClient.h"
+#include "JobServer.h"
+#include "LoadGenerator.h"
+#include "PackFile.h"
+#include "Utils.h"
 
 namespace fs = std::filesystem;
 
@@ -23,19 +35,194 @@ static std::vector<std::string> listFilesBasic(const std::string &folderPath)
     }
     catch (const fs::filesystem_error &ex)
     {
-        std::cerr << "ļϵͳ: " << ex.what() << std::endl;
+        std::cerr << "文件系统错误: " << ex.what() << std::endl;
     }
     return ret;
 }
 
-int main()
+// 第index个命令行参数转为数值  未给出时取默认值  不是数字时返回false
+template <typename T>
+static bool numberArg(int argc, char *argv[], int index, T defaultValue, T &value)
 {
+    value = defaultValue;
+    return index >= argc || ImageFlow::Utils::parseNumber(argv[index], value);
+}
+
+// 列出打包文件中的条目
+static int listPack(std::string const &path)
+{
+    ImageFlow::PackReader reader;
+    if (!reader.open(path))
+        return 1;
+    for (auto &&entry : reader.getEntries())
+        std::cout << entry.size << "\t" << entry.name << std::endl;
+    std::cout << reader.getEntries().size() << " 个条目"
+              << (reader.isIndexed() || reader.getFormat() == ImageFlow::PackReader::Format::TAR ? "" : "（索引缺失  由扫描恢复）")
+              << std::endl;
+    return 0;
+}
+
+// 按名称取出一个条目  未指定输出文件时写到标准输出
+static int extractPackEntry(std::string const &path, std::string const &name, std::string const &outputPath)
+{
+    ImageFlow::PackReader reader;
+    if (!reader.open(path))
+        return 1;
+    auto entry = reader.find(name);
+    if (!entry)
+    {
+        std::cerr << "条目不存在：" << name << std::endl;
+        return 1;
+    }
+    auto data = reader.getData(*entry);
+    if (outputPath.empty())
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY); // 避免换行符被转换
+#endif
+        return fwrite(data.data(), 1, data.size(), stdout) == data.size() ? 0 : 1;
+    }
+    return ImageFlow::Utils::writeFile(outputPath, data.data(), data.size()) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    // ImageFlow pack-list <打包文件>
+    if (argc > 2 && std::string(argv[1]) == "pack-list")
+        return listPack(argv[2]);
+
+    // ImageFlow pack-get <打包文件> <条目名> [输出文件]
+    if (argc > 3 && std::string(argv[1]) == "pack-get")
+        return extractPackEntry(argv[2], argv[3], argc > 4 ? argv[4] : "");
+
+    // ImageFlow bench-fastpath [滤镜描述] [迭代次数]
+    if (argc > 1 && std::string(argv[1]) == "bench-fastpath")
+    {
+        int iterations = 0;
+        if (!numberArg(argc, argv, 3, 20, iterations))
+        {
+            std::cerr << "用法：bench-fastpath [滤镜描述] [迭代次数]" << std::endl;
+            return 1;
+        }
+        return ImageFlow::Benchmark::runFastPath(
+            argc > 2 ? argv[2] : "scale=800:600,hue=h=30:s=1", iterations);
+    }
+
+    // ImageFlow bench-encode [宽] [高] [迭代次数]
+    if (argc > 1 && std::string(argv[1]) == "bench-encode")
+    {
+        int width = 0, height = 0, iterations = 0;
+        if (!numberArg(argc, argv, 2, 1920, width) ||
+            !numberArg(argc, argv, 3, 1080, height) ||
+            !numberArg(argc, argv, 4, 5, iterations))
+        {
+            std::cerr << "用法：bench-encode [宽] [高] [迭代次数]" << std::endl;
+            return 1;
+        }
+        return ImageFlow::Benchmark::runEncode(width, height, iterations);
+    }
+
+    // ImageFlow bench-threadpool [最大线程数] [任务数] [结果文件]
+    if (argc > 1 && std::string(argv[1]) == "bench-threadpool")
+    {
+        size_t maxThreads = 0, tasks = 0;
+        if (!numberArg(argc, argv, 2, ImageFlow::Utils::cpuLimit(), maxThreads) ||
+            !numberArg<size_t>(argc, argv, 3, 100000, tasks))
+        {
+            std::cerr << "用法：bench-threadpool [最大线程数] [任务数] [结果文件]" << std::endl;
+            return 1;
+        }
+        return ImageFlow::Benchmark::runThreadPool(
+            maxThreads, tasks, argc > 4 ? argv[4] : "threadpool-bench.json");
+    }
+
     ImageFlow::ProcessConfig config{
         800,
         600,
         "hue=h=30:s=1",
         "jpg"};
 
+    // 设置了IMAGEFLOW_TRACE时记录处理时间线  结束时写出到该路径  可在Perfetto中打开
+    if (auto tracePath = std::getenv("IMAGEFLOW_TRACE"))
+        config.tracePath = tracePath;
+
+    // ImageFlow loadgen [--rate 张/s]... [--sweep 最小:最大:倍数] [--constant] [--duration 秒] [--warmup 秒]
+    //                   [--size 宽x高]... [--format 格式]... [--filter 描述]... [--slo 毫秒] [--no-stop] [--inline] [--seed N] 文件...
+    // 按给定到达率开环提交单图任务  测量各速率下的延迟分位数并找出饱和拐点
+    if (argc > 1 && std::string(argv[1]) == "loadgen")
+    {
+        ImageFlow::LoadGenerator::LoadOptions options;
+        if (!ImageFlow::LoadGenerator::parseArgs({argv + 2, argv + argc}, options))
+        {
+            std::cerr << "用法：loadgen [--rate 张/s]... [--sweep 最小:最大:倍数] [--constant] [--duration 秒] "
+                         "[--warmup 秒] [--size 宽x高]... [--format 格式]... [--filter 描述]... "
+                         "[--slo 毫秒] [--no-stop] [--inline] [--seed N] 文件..."
+                      << std::endl;
+            return 1;
+        }
+        ImageFlow::ImageFlowProcessor processor(config);
+        return ImageFlow::LoadGenerator::run(processor, options) == 0 ? 0 : 1;
+    }
+
+    // ImageFlow pack <输入打包文件（tar或ImageFlow打包格式）> <输出打包文件>
+    // 大量小图像时避免逐个文件的打开、创建与目录操作
+    if (argc > 3 && std::string(argv[1]) == "pack")
+    {
+        ImageFlow::ImageFlowProcessor processor(config);
+        return processor.processPack(argv[2], argv[3]) == 0 ? 0 : 1;
+    }
+
+    // ImageFlow serve <套接字路径> [--root 目录]... [配置档名=宽x高[:权重]]...
+    // 指定--root时任务的输入与输出路径须位于这些目录内
+    // 常驻进程  任务未指定选项时使用上面的默认配置  配置档沿用默认配置的滤镜与格式
+    if (argc > 2 && std::string(argv[1]) == "serve")
+    {
+        // 常驻进程常收到同一源图的不同规格请求  开启解码帧缓存
+        config.frameCacheBytes = int64_t(512) << 20;
+        // 负载随客户端波动  按积压与CPU利用率增减线程
+        config.autoscaleThreads = true;
+        ImageFlow::ImageFlowProcessor processor(config);
+        std::vector<std::string> roots;
+        for (int i = 3; i < argc; ++i)
+        {
+            std::string spec = argv[i];
+            if (spec == "--root" && i + 1 < argc)
+            {
+                roots.push_back(argv[++i]);
+                continue;
+            }
+            auto pos = spec.find('=');
+            ImageFlow::ProcessConfig profile = config;
+            int weight = 1;
+            if (pos == std::string::npos ||
+                sscanf(spec.c_str() + pos + 1, "%dx%d:%d",
+                       &profile.targetWidth, &profile.targetHeight, &weight) < 2 ||
+                !processor.setProfile(spec.substr(0, pos), profile, weight))
+            {
+                std::cerr << "无效的配置档：" << spec << std::endl;
+                return 1;
+            }
+        }
+        ImageFlow::JobServer server(processor, argv[2]);
+        if (!server.setAllowedRoots(roots))
+            return 1;
+        return server.run();
+    }
+
+    // ImageFlow client <套接字路径> [--inline] [--repeat N] [--window N] [--out 目录] [--set 键=值] [-v] 文件...
+    if (argc > 1 && std::string(argv[1]) == "client")
+    {
+        ImageFlow::JobClient::ClientOptions options;
+        if (!ImageFlow::JobClient::parseArgs({argv + 2, argv + argc}, options))
+        {
+            std::cerr << "用法：client <套接字路径> [--inline] [--repeat N] [--window N] "
+                         "[--out 目录] [--set 键=值] [-v] 文件..."
+                      << std::endl;
+            return 1;
+        }
+        return ImageFlow::JobClient::run(options);
+    }
+
     ImageFlow::ImageFlowProcessor processor(config);
 
     auto imagePaths = listFilesBasic("C:\\Users\\XLC\\Desktop\\3\\");
@@ -45,15 +232,15 @@ int main()
             imagePaths,
             "C:\\Users\\XLC\\Desktop\\2"))
     {
-        std::cout << "ͼѳɹɣ" << std::endl;
+        std::cout << "图像处理已成功完成！" << std::endl;
     }
     else
     {
-        std::cout << "ͼƬʧܣ" << std::endl;
+        std::cout << "图片处理失败！" << std::endl;
     }
     auto end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed = end - start;
-    std::cout << "ɣʱ" << elapsed.count() << " " << std::endl;
+    std::cout << "处理完成，耗时：" << elapsed.count() << " 秒" << std::endl;
 
     return 0;
 }